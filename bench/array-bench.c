@@ -0,0 +1,174 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "ssm.h"
+
+/* Compare ways of scheduling sparse writes to a large table
+
+   Every tick, a writer schedules a handful of random entries of a table
+   for the next tick:
+
+   write(table &t) =
+     loop
+       for k in 1 .. WRITES
+         after 1 t[random] <- random
+       wait 1
+     until INSTANTS
+
+   The table is first one ssm_i32_t per entry, each with its own event,
+   then a single variable holding the whole table that is copied on
+   every update, then a scheduled array that commits only the dirty
+   entries.  Each run checks its table against a plain copy.
+
+   Usage: array-bench [instants] [entries] [writes per instant]
+*/
+
+long instants;
+size_t entries;
+int writes;
+
+enum { SEPARATE, WHOLESALE, ARRAY } mode;
+
+ssm_i32_t *separate;
+
+/** The whole table as one variable, copied as a scalar would be */
+typedef struct {
+  ssm_sv_t sv;
+  i32 *value, *later_value;
+} table_t;
+
+table_t wholesale;
+
+bool update_table(ssm_sv_t *sv)
+{
+  table_t *t = container_of(sv, table_t, sv);
+  memcpy(t->value, t->later_value, entries * sizeof(i32));
+  return true;
+}
+
+ssm_array_t array;
+i32 *expected;
+
+typedef struct {
+  SSM_ACT_FIELDS;
+  ssm_trigger_t trigger;
+  ssm_event_t timer;
+  unsigned seed;
+} writer_act_t;
+
+void step_writer(ssm_act_t *sact)
+{
+  writer_act_t *act = (writer_act_t *) sact;
+  switch (act->pc) {
+  case 0:
+    ssm_sensitize(&act->timer.sv, &act->trigger);
+    while (ssm_now() < (ssm_time_t) instants) {
+      for (int k = 0 ; k < writes ; k++) {
+	size_t i = rand_r(&act->seed) % entries;
+	i32 x = rand_r(&act->seed);
+	expected[i] = x;
+	switch (mode) {
+	case SEPARATE:
+	  ssm_later_i32(&separate[i], ssm_now() + 1, x);
+	  break;
+	case WHOLESALE:
+	  wholesale.later_value[i] = x;
+	  ssm_schedule(&wholesale.sv, ssm_now() + 1);
+	  break;
+	case ARRAY:
+	  ssm_later_array(&array, ssm_now() + 1, i, &x);
+	  break;
+	}
+      }
+      ssm_later_event(&act->timer, ssm_now() + 1);
+      act->pc = 1;
+      return;
+    case 1:
+      ;
+    }
+  }
+  ssm_desensitize(&act->trigger);
+  ssm_leave(sact, sizeof(writer_act_t));
+}
+
+i32 entry(size_t i)
+{
+  switch (mode) {
+  case SEPARATE: return separate[i].value;
+  case WHOLESALE: return wholesale.value[i];
+  default: return ((i32 *) array.value)[i];
+  }
+}
+
+void run_mode(const char *name)
+{
+  ssm_reset();
+  i32 *value = calloc(entries, sizeof(i32));
+  i32 *later = calloc(entries, sizeof(i32));
+  uint64_t *dirty = calloc(SSM_ARRAY_DIRTY_WORDS(entries), sizeof(uint64_t));
+  expected = calloc(entries, sizeof(i32));
+  switch (mode) {
+  case SEPARATE:
+    separate = calloc(entries, sizeof(ssm_i32_t));
+    for (size_t i = 0 ; i < entries ; i++) {
+      ssm_initialize_i32(&separate[i]);
+      separate[i].value = 0;
+    }
+    break;
+  case WHOLESALE:
+    ssm_initialize(&wholesale.sv, update_table);
+    wholesale.value = value;
+    wholesale.later_value = later;
+    break;
+  case ARRAY:
+    ssm_initialize_array(&array, value, later, dirty, entries, sizeof(i32));
+    break;
+  }
+
+  writer_act_t *act = (writer_act_t *)
+    ssm_enter(sizeof(writer_act_t), step_writer, &ssm_top_parent,
+	      SSM_ROOT_PRIORITY, SSM_ROOT_DEPTH);
+  ssm_initialize_event(&act->timer);
+  act->trigger.act = (ssm_act_t *) act;
+  act->seed = 1;
+  ssm_activate((ssm_act_t *) act);
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  ssm_tick();
+  while (ssm_next_event_time() != SSM_NEVER)
+    ssm_tick();
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  for (size_t i = 0 ; i < entries ; i++)
+    if (entry(i) != expected[i]) {
+      fprintf(stderr, "%s: entry %zu is wrong\n", name, i);
+      exit(1);
+    }
+
+  double seconds = (end.tv_sec - start.tv_sec) +
+    (end.tv_nsec - start.tv_nsec) * 1e-9;
+  printf("%-9s: %ld instants in %.3f s, %.0f ns/instant\n", name, instants,
+	 seconds, seconds * 1e9 / instants);
+  if (mode == SEPARATE) free(separate);
+  free(value);
+  free(later);
+  free(dirty);
+  free(expected);
+}
+
+int main(int argc, char *argv[])
+{
+  instants = argc > 1 ? atol(argv[1]) : 200000;
+  entries = argc > 2 ? atol(argv[2]) : 4096;
+  writes = argc > 3 ? atoi(argv[3]) : 16;
+
+  mode = SEPARATE;
+  run_mode("separate");
+  mode = WHOLESALE;
+  run_mode("wholesale");
+  mode = ARRAY;
+  run_mode("array");
+  return 0;
+}
@@ -0,0 +1,214 @@
+#define _GNU_SOURCE
+#define SSM_ACT_MALLOC(size) ssm_batch_alloc(size)
+#define SSM_ACT_FREE(ptr, size) ssm_batch_free(ptr, size)
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "ssm-linux.h"
+
+/* Run a parameter sweep of many short runs with the batch harness
+
+   plant(u64 param) =
+     var tick : event
+     var x : u64 = 1
+     par ticker(tick)
+         integrate(tick, param, x)
+
+   ticker(event &tick) =
+     loop
+       after 1 ms tick <- Event
+       wait tick
+
+   integrate(event &tick, u64 param, u64 &x) =
+     loop
+       wait tick
+       x <- x * 6 + param
+
+   Each run stops after a fixed number of instants with both loops still
+   running; the batch harness discards them in constant time.  The sweep
+   runs once on a single worker and once on every core, and the two sets
+   of summaries are compared.
+
+   Usage: batch-bench [runs] [instants per run]
+*/
+
+typedef struct {
+  u64 x;          // Final value of x
+  u64 instants;   // Number of instants run
+} summary_t;
+
+long instants;
+
+typedef struct {
+  SSM_ACT_FIELDS;
+  ssm_trigger_t trigger;
+  ssm_event_t *tick;
+} ticker_act_t;
+
+ssm_stepf_t step_ticker;
+
+ticker_act_t *enter_ticker(ssm_act_t *parent, ssm_priority_t priority,
+			   ssm_depth_t depth, ssm_event_t *tick)
+{
+  ticker_act_t *act = (ticker_act_t *)
+    ssm_enter(sizeof(ticker_act_t), step_ticker, parent, priority, depth);
+  act->tick = tick;
+  act->trigger.act = (ssm_act_t *) act;
+  return act;
+}
+
+void step_ticker(ssm_act_t *sact)
+{
+  ticker_act_t *act = (ticker_act_t *) sact;
+  switch (act->pc) {
+  case 0:
+    ssm_sensitize(&act->tick->sv, &act->trigger);
+    for (;;) {
+      ssm_later_event(act->tick, ssm_now() + SSM_MILLISECOND);
+      act->pc = 1;
+      return;
+    case 1:
+      ;
+    }
+  }
+}
+
+typedef struct {
+  SSM_ACT_FIELDS;
+  ssm_trigger_t trigger;
+  ssm_event_t *tick;
+  u64 param;
+  ssm_u64_t *x;
+} integrate_act_t;
+
+ssm_stepf_t step_integrate;
+
+integrate_act_t *enter_integrate(ssm_act_t *parent, ssm_priority_t priority,
+				 ssm_depth_t depth, ssm_event_t *tick,
+				 u64 param, ssm_u64_t *x)
+{
+  integrate_act_t *act = (integrate_act_t *)
+    ssm_enter(sizeof(integrate_act_t), step_integrate, parent, priority,
+	      depth);
+  act->tick = tick;
+  act->param = param;
+  act->x = x;
+  act->trigger.act = (ssm_act_t *) act;
+  return act;
+}
+
+void step_integrate(ssm_act_t *sact)
+{
+  integrate_act_t *act = (integrate_act_t *) sact;
+  switch (act->pc) {
+  case 0:
+    ssm_sensitize(&act->tick->sv, &act->trigger);
+    act->pc = 1;
+    return;
+  case 1:
+    ssm_assign_u64(act->x, act->priority, act->x->value * 6 + act->param);
+    return;
+  }
+}
+
+typedef struct {
+  SSM_ACT_FIELDS;
+  ssm_event_t tick;
+  ssm_u64_t x;
+  u64 param;
+} plant_act_t;
+
+ssm_stepf_t step_plant;
+
+plant_act_t *enter_plant(ssm_act_t *parent, ssm_priority_t priority,
+			 ssm_depth_t depth, u64 param)
+{
+  plant_act_t *act = (plant_act_t *)
+    ssm_enter(sizeof(plant_act_t), step_plant, parent, priority, depth);
+  ssm_initialize_event(&act->tick);
+  ssm_initialize_u64(&act->x);
+  act->x.value = 1;
+  act->param = param;
+  return act;
+}
+
+void step_plant(ssm_act_t *sact)
+{
+  plant_act_t *act = (plant_act_t *) sact;
+  switch (act->pc) {
+  case 0: {
+    ssm_depth_t new_depth = act->depth - 1;
+    ssm_priority_t pinc = 1 << new_depth;
+    ssm_activate((ssm_act_t *)
+		 enter_ticker(sact, act->priority, new_depth, &act->tick));
+    ssm_activate((ssm_act_t *)
+		 enter_integrate(sact, act->priority + pinc, new_depth,
+				 &act->tick, act->param, &act->x));
+    act->pc = 1;
+    return;
+  }
+  case 1:
+    ssm_leave(sact, sizeof(plant_act_t));
+  }
+}
+
+plant_act_t *plant; // The current run's top routine, to read its results
+
+void run(size_t i, void *summary)
+{
+  plant = enter_plant(&ssm_top_parent, SSM_ROOT_PRIORITY, SSM_ROOT_DEPTH, i);
+  ssm_activate((ssm_act_t *) plant);
+  ssm_tick();
+  long count = 1;
+  for ( ; count < instants && ssm_next_event_time() != SSM_NEVER ; count++)
+    ssm_tick();
+  *(summary_t *) summary = (summary_t) { .x = plant->x.value,
+					 .instants = count };
+}
+
+double seconds_since(struct timespec *start)
+{
+  struct timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  return (end.tv_sec - start->tv_sec) + (end.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+int main(int argc, char *argv[])
+{
+  long runs = argc > 1 ? atol(argv[1]) : 1000000;
+  instants = argc > 2 ? atol(argv[2]) : 20;
+
+  summary_t *one = malloc(runs * sizeof(summary_t));
+  summary_t *all = malloc(runs * sizeof(summary_t));
+  if (!one || !all) {
+    perror("malloc");
+    return 1;
+  }
+
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  if (ssm_batch_run(runs, 1, run, one, sizeof(summary_t))) {
+    perror("ssm_batch_run");
+    return 1;
+  }
+  double t1 = seconds_since(&start);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  if (ssm_batch_run(runs, 0, run, all, sizeof(summary_t))) {
+    perror("ssm_batch_run");
+    return 1;
+  }
+  double tn = seconds_since(&start);
+
+  long mismatches = 0;
+  for (long i = 0 ; i < runs ; i++)
+    if (one[i].x != all[i].x || one[i].instants != all[i].instants)
+      mismatches++;
+
+  printf("one worker: %ld runs of %ld instants in %.3f s: "
+	 "%.0f runs per minute\n", runs, instants, t1, runs * 60 / t1);
+  printf("every core: %ld runs of %ld instants in %.3f s: "
+	 "%.0f runs per minute\n", runs, instants, tn, runs * 60 / tn);
+  printf(mismatches ? "%ld runs differ\n" : "results match\n", mismatches);
+  return mismatches != 0;
+}
@@ -0,0 +1,172 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "ssm.h"
+
+/* Compare separate Boolean signals with a bit vector
+
+   Simulates a ring of clocked XOR gates (cellular automaton rule 90):
+   each cell's next state is the XOR of its two neighbors.
+
+   clock(bool &c[]) =
+     loop
+       for i in 0 .. CELLS - 1
+         after 1 c[i] <- c[i - 1] xor c[i + 1]
+       wait 1
+     until INSTANTS
+
+   The cells are first one ssm_bool_t each, then an ssm_bits_t that the
+   routine updates a word of 64 cells at a time.  Each run checks its
+   cells against a plain simulation.  The default stays within the
+   default journal size, which holds one entry per ssm_bool_t that
+   changes in an instant.
+
+   Usage: bits-bench [instants] [cells]
+*/
+
+long instants;
+size_t cells;
+
+enum { BOOLS, BITS } mode;
+
+ssm_bool_t *bools;
+ssm_bits_t bits;
+uint64_t *value, *later, *pending;
+
+typedef struct {
+  SSM_ACT_FIELDS;
+  ssm_trigger_t trigger;
+  ssm_event_t timer;
+} clock_act_t;
+
+/** Return the next state of word w, a rotate of the whole ring each way */
+uint64_t next_word(const uint64_t *v, size_t w)
+{
+  size_t words = SSM_BITS_WORDS(cells);
+  size_t top = (cells - 1) % 64;    // Highest bit used in the last word
+  uint64_t cur = v[w];
+  uint64_t below = w ? v[w - 1] >> 63 : v[words - 1] >> top & 1;
+  uint64_t above = w + 1 < words ? v[w + 1] & 1 : v[0] & 1;
+  uint64_t left = cur << 1 | below;   // Bit i holds cell i - 1
+  uint64_t right = cur >> 1;          // Bit i holds cell i + 1
+  if (w + 1 < words)
+    right |= above << 63;
+  else
+    right |= above << top;
+  uint64_t next = left ^ right;
+  if (w + 1 == words && top < 63)
+    next &= ((uint64_t) 1 << (top + 1)) - 1;
+  return next;
+}
+
+void step_clock(ssm_act_t *sact)
+{
+  clock_act_t *act = (clock_act_t *) sact;
+  switch (act->pc) {
+  case 0:
+    ssm_sensitize(&act->timer.sv, &act->trigger);
+    while (ssm_now() < (ssm_time_t) instants) {
+      if (mode == BOOLS)
+	for (size_t i = 0 ; i < cells ; i++)
+	  ssm_later_bool(&bools[i], ssm_now() + 1,
+			 bools[(i + cells - 1) % cells].value ^
+			 bools[(i + 1) % cells].value);
+      else
+	for (size_t w = 0 ; w < SSM_BITS_WORDS(cells) ; w++)
+	  ssm_later_bits(&bits, ssm_now() + 1, w, ~(uint64_t) 0,
+			 next_word(bits.value, w));
+      ssm_later_event(&act->timer, ssm_now() + 1);
+      act->pc = 1;
+      return;
+    case 1:
+      ;
+    }
+  }
+  ssm_desensitize(&act->trigger);
+  ssm_leave(sact, sizeof(clock_act_t));
+}
+
+bool *expected;
+
+void simulate(void)
+{
+  bool *next = calloc(cells, sizeof(bool));
+  expected[cells / 2] = true;
+  for (long t = 0 ; t < instants ; t++) {
+    for (size_t i = 0 ; i < cells ; i++)
+      next[i] = expected[(i + cells - 1) % cells] ^ expected[(i + 1) % cells];
+    for (size_t i = 0 ; i < cells ; i++)
+      expected[i] = next[i];
+  }
+  free(next);
+}
+
+void run_mode(const char *name, size_t bytes)
+{
+  ssm_reset();
+  size_t words = SSM_BITS_WORDS(cells);
+  if (mode == BOOLS) {
+    bools = calloc(cells, sizeof(ssm_bool_t));
+    for (size_t i = 0 ; i < cells ; i++) {
+      ssm_initialize_bool(&bools[i]);
+      bools[i].value = i == cells / 2;
+    }
+  } else {
+    value = calloc(words, sizeof(uint64_t));
+    later = calloc(words, sizeof(uint64_t));
+    pending = calloc(words, sizeof(uint64_t));
+    value[cells / 2 / 64] = (uint64_t) 1 << (cells / 2 % 64);
+    ssm_initialize_bits(&bits, value, later, pending, cells);
+  }
+
+  clock_act_t *act = (clock_act_t *)
+    ssm_enter(sizeof(clock_act_t), step_clock, &ssm_top_parent,
+	      SSM_ROOT_PRIORITY, SSM_ROOT_DEPTH);
+  ssm_initialize_event(&act->timer);
+  act->trigger.act = (ssm_act_t *) act;
+  ssm_activate((ssm_act_t *) act);
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  ssm_tick();
+  while (ssm_next_event_time() != SSM_NEVER)
+    ssm_tick();
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  for (size_t i = 0 ; i < cells ; i++)
+    if ((mode == BOOLS ? bools[i].value : ssm_bits_get(&bits, i)) !=
+	expected[i]) {
+      fprintf(stderr, "%s: cell %zu is wrong\n", name, i);
+      exit(1);
+    }
+
+  double seconds = (end.tv_sec - start.tv_sec) +
+    (end.tv_nsec - start.tv_nsec) * 1e-9;
+  printf("%-5s: %ld instants in %.3f s, %.1f ns/cell/instant, "
+	 "%.2f bytes/cell\n", name, instants, seconds,
+	 seconds * 1e9 / instants / cells, (double) bytes / cells);
+  if (mode == BOOLS)
+    free(bools);
+  else {
+    free(value);
+    free(later);
+    free(pending);
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  instants = argc > 1 ? atol(argv[1]) : 20000;
+  cells = argc > 2 ? atol(argv[2]) : 1000;
+  if (cells < 3) cells = 3;
+  expected = calloc(cells, sizeof(bool));
+  simulate();
+
+  mode = BOOLS;
+  run_mode("bools", cells * sizeof(ssm_bool_t));
+  mode = BITS;
+  run_mode("bits", sizeof(ssm_bits_t) +
+	   3 * SSM_BITS_WORDS(cells) * sizeof(uint64_t));
+  return 0;
+}
@@ -0,0 +1,173 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ssm.h"
+
+/* Compare copying and pointer-swapping large scheduled values
+
+   A producer sends a new frame every tick to a consumer that reads its
+   sequence number:
+
+   produce(frame &f) =
+     loop
+       after 1 f <- next frame
+       wait f
+
+   consume(frame &f) =
+     loop
+       wait f
+       check f.seq
+
+   The frame is first a scalar-style variable, whose later and update
+   functions copy the whole frame, then an aggregate (ssm_blob_t), which
+   the producer fills in place and commits by swapping pointers.  The
+   producer writes only the header either way.
+
+   Usage: blob-bench [instants] [frame bytes]
+*/
+
+size_t frame_size;
+long instants;
+
+typedef struct {
+  uint64_t seq;
+  unsigned char data[];
+} frame_t;
+
+/** A frame variable that copies, as SSM_DEFINE_SV_SCALAR would */
+typedef struct {
+  ssm_sv_t sv;
+  frame_t *value;
+  frame_t *later_value;
+} copy_frame_t;
+
+bool update_copy(ssm_sv_t *sv)
+{
+  copy_frame_t *v = container_of(sv, copy_frame_t, sv);
+  memcpy(v->value, v->later_value, frame_size);
+  return true;
+}
+
+void later_copy(copy_frame_t *v, ssm_time_t then, const frame_t *frame)
+{
+  memcpy(v->later_value, frame, frame_size);
+  ssm_schedule(&v->sv, then);
+}
+
+bool swapping;
+copy_frame_t copied;
+ssm_blob_t swapped;
+frame_t *scratch;
+
+typedef struct {
+  SSM_ACT_FIELDS;
+  ssm_trigger_t trigger;
+  uint64_t seq;
+} frame_act_t;
+
+ssm_stepf_t step_produce, step_consume;
+
+ssm_sv_t *frame_sv(void) { return swapping ? &swapped.sv : &copied.sv; }
+
+const frame_t *frame_value(void)
+{
+  return swapping ? swapped.value : copied.value;
+}
+
+void step_produce(ssm_act_t *sact)
+{
+  frame_act_t *act = (frame_act_t *) sact;
+  switch (act->pc) {
+  case 0:
+    ssm_sensitize(frame_sv(), &act->trigger);
+    for (;;) {
+      if (swapping) {
+	frame_t *f = ssm_blob_buffer(&swapped);
+	f->seq = ++act->seq;
+	ssm_later_blob(&swapped, ssm_now() + 1);
+      } else {
+	scratch->seq = ++act->seq;
+	later_copy(&copied, ssm_now() + 1, scratch);
+      }
+      act->pc = 1;
+      return;
+    case 1:
+      ;
+    }
+  }
+}
+
+void step_consume(ssm_act_t *sact)
+{
+  frame_act_t *act = (frame_act_t *) sact;
+  switch (act->pc) {
+  case 0:
+    ssm_sensitize(frame_sv(), &act->trigger);
+    act->pc = 1;
+    return;
+  case 1:
+    if (frame_value()->seq != ++act->seq) {
+      fprintf(stderr, "frame %lu out of order\n", (unsigned long) act->seq);
+      exit(1);
+    }
+    return;
+  }
+}
+
+frame_act_t *enter_frame(ssm_stepf_t *step, ssm_priority_t priority,
+			 ssm_depth_t depth)
+{
+  frame_act_t *act = (frame_act_t *)
+    ssm_enter(sizeof(frame_act_t), step, &ssm_top_parent, priority, depth);
+  act->trigger.act = (ssm_act_t *) act;
+  act->seq = 0;
+  return act;
+}
+
+void run_mode(const char *name, bool swap)
+{
+  swapping = swap;
+  frame_t *a = calloc(1, frame_size), *b = calloc(1, frame_size);
+  ssm_reset();
+  if (swapping)
+    ssm_initialize_blob(&swapped, a, b, frame_size);
+  else {
+    ssm_initialize(&copied.sv, update_copy);
+    copied.value = a;
+    copied.later_value = b;
+  }
+  ssm_depth_t depth = SSM_ROOT_DEPTH - 1;
+  ssm_activate((ssm_act_t *)
+	       enter_frame(step_produce, SSM_ROOT_PRIORITY, depth));
+  ssm_activate((ssm_act_t *)
+	       enter_frame(step_consume, SSM_ROOT_PRIORITY + (1 << depth),
+			   depth));
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  ssm_tick();
+  while (ssm_now() < (ssm_time_t) instants)
+    ssm_tick();
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  double seconds = (end.tv_sec - start.tv_sec) +
+    (end.tv_nsec - start.tv_nsec) * 1e-9;
+  printf("%s: %ld instants of %zu-byte frames in %.3f s, %.0f ns/instant\n",
+	 name, instants, frame_size, seconds, seconds * 1e9 / instants);
+  free(a);
+  free(b);
+}
+
+int main(int argc, char *argv[])
+{
+  instants = argc > 1 ? atol(argv[1]) : 1000000;
+  frame_size = argc > 2 ? atol(argv[2]) : 4096;
+  if (frame_size < sizeof(frame_t)) frame_size = sizeof(frame_t);
+  scratch = calloc(1, frame_size);
+
+  run_mode("copy", false);
+  run_mode("swap", true);
+  return 0;
+}
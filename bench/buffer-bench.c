@@ -0,0 +1,209 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ssm.h"
+
+/* Compare copying and handing off variable-length packets
+
+   An adapter receives a packet of random length every tick and passes
+   it to a consumer that checksums it:
+
+   receive(packet &p) =
+     loop
+       read a packet into a buffer
+       after 1 p <- buffer
+       wait 1
+
+   consume(packet &p) =
+     loop
+       wait p
+       checksum p
+
+   The packet is first a variable holding a maximum-size frame, which
+   later and update copy as a scalar would, then a byte buffer
+   (ssm_buffer_t) that takes a slice from a pool the adapter filled.
+   Both runs must produce the same checksum, and the pool must be full
+   again at the end: nothing is allocated once packets flow.
+
+   Usage: buffer-bench [instants] [min bytes] [max bytes]
+*/
+
+long instants;
+size_t min_len, max_len;
+
+typedef struct {
+  size_t len;
+  unsigned char data[];
+} frame_t;
+
+/** A frame variable that copies, as SSM_DEFINE_SV_SCALAR would */
+typedef struct {
+  ssm_sv_t sv;
+  frame_t *value;
+  frame_t *later_value;
+} copy_frame_t;
+
+bool update_copy_frame(ssm_sv_t *sv)
+{
+  copy_frame_t *v = container_of(sv, copy_frame_t, sv);
+  memcpy(v->value, v->later_value, sizeof(frame_t) + max_len);
+  return true;
+}
+
+bool slicing;
+copy_frame_t copied;
+ssm_buffer_t buffer;
+ssm_slice_pool_t pool;
+frame_t *scratch;
+uint64_t sum;
+size_t bytes;
+
+typedef struct {
+  SSM_ACT_FIELDS;
+  ssm_trigger_t trigger;
+  ssm_event_t timer;
+  unsigned seed;
+} packet_act_t;
+
+/** Stand in for a device: fill `data` with a packet and return its length */
+size_t read_packet(unsigned *seed, unsigned char *data)
+{
+  size_t len = min_len + rand_r(seed) % (max_len - min_len + 1);
+  unsigned char c = rand_r(seed);
+  for (size_t i = 0 ; i < len ; i += 64) data[i] = c++;
+  return len;
+}
+
+void step_receive(ssm_act_t *sact)
+{
+  packet_act_t *act = (packet_act_t *) sact;
+  switch (act->pc) {
+  case 0:
+    ssm_sensitize(&act->timer.sv, &act->trigger);
+    while (ssm_now() < (ssm_time_t) instants) {
+      if (slicing) {
+	ssm_slice_t *s = ssm_slice_alloc(&pool);
+	if (!s) {
+	  fprintf(stderr, "slice pool exhausted\n");
+	  exit(1);
+	}
+	s->len = read_packet(&act->seed, s->data);
+	ssm_later_buffer(&buffer, ssm_now() + 1, s);
+      } else {
+	scratch->len = read_packet(&act->seed, scratch->data);
+	memcpy(copied.later_value, scratch, sizeof(frame_t) + max_len);
+	ssm_schedule(&copied.sv, ssm_now() + 1);
+      }
+      ssm_later_event(&act->timer, ssm_now() + 1);
+      act->pc = 1;
+      return;
+    case 1:
+      ;
+    }
+  }
+  ssm_desensitize(&act->trigger);
+  ssm_leave(sact, sizeof(packet_act_t));
+}
+
+void step_consume(ssm_act_t *sact)
+{
+  packet_act_t *act = (packet_act_t *) sact;
+  switch (act->pc) {
+  case 0:
+    ssm_sensitize(slicing ? &buffer.sv : &copied.sv, &act->trigger);
+    act->pc = 1;
+    return;
+  case 1:
+    {
+      const unsigned char *data =
+	slicing ? buffer.value->data : copied.value->data;
+      size_t len = slicing ? buffer.value->len : copied.value->len;
+      for (size_t i = 0 ; i < len ; i += 64) sum = sum * 31 + data[i];
+      bytes += len;
+    }
+    return;
+  }
+}
+
+packet_act_t *enter_packet(ssm_stepf_t *step, ssm_priority_t priority,
+			   ssm_depth_t depth)
+{
+  packet_act_t *act = (packet_act_t *)
+    ssm_enter(sizeof(packet_act_t), step, &ssm_top_parent, priority, depth);
+  act->trigger.act = (ssm_act_t *) act;
+  act->seed = 1;
+  return act;
+}
+
+uint64_t run_mode(const char *name, bool slice)
+{
+  slicing = slice;
+  sum = 0;
+  bytes = 0;
+  ssm_reset();
+
+  frame_t *a = calloc(1, sizeof(frame_t) + max_len);
+  frame_t *b = calloc(1, sizeof(frame_t) + max_len);
+  size_t pool_bytes = 4 * SSM_SLICE_STRIDE(max_len);
+  uint64_t *storage = malloc(pool_bytes);
+  if (slicing) {
+    ssm_initialize_slice_pool(&pool, storage, pool_bytes, max_len);
+    ssm_initialize_buffer(&buffer);
+  } else {
+    ssm_initialize(&copied.sv, update_copy_frame);
+    copied.value = a;
+    copied.later_value = b;
+  }
+
+  ssm_depth_t depth = SSM_ROOT_DEPTH - 1;
+  packet_act_t *recv = enter_packet(step_receive, SSM_ROOT_PRIORITY, depth);
+  ssm_initialize_event(&recv->timer);
+  ssm_activate((ssm_act_t *) recv);
+  ssm_activate((ssm_act_t *)
+	       enter_packet(step_consume, SSM_ROOT_PRIORITY + (1 << depth),
+			    depth));
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  ssm_tick();
+  while (ssm_next_event_time() != SSM_NEVER)
+    ssm_tick();
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  if (slicing) {
+    ssm_drop_buffer(&buffer);
+    if (pool.available != 4) {
+      fprintf(stderr, "%s: %zu slices leaked\n", name, 4 - pool.available);
+      exit(1);
+    }
+  }
+
+  double seconds = (end.tv_sec - start.tv_sec) +
+    (end.tv_nsec - start.tv_nsec) * 1e-9;
+  printf("%-5s: %ld packets of %zu-%zu bytes in %.3f s, %.0f ns/packet, "
+	 "%.0f MB/s\n", name, instants, min_len, max_len, seconds,
+	 seconds * 1e9 / instants, bytes / seconds * 1e-6);
+  free(a);
+  free(b);
+  free(storage);
+  return sum;
+}
+
+int main(int argc, char *argv[])
+{
+  instants = argc > 1 ? atol(argv[1]) : 1000000;
+  min_len = argc > 2 ? atol(argv[2]) : 64;
+  max_len = argc > 3 ? atol(argv[3]) : 1500;
+  if (max_len < min_len) max_len = min_len;
+  scratch = calloc(1, sizeof(frame_t) + max_len);
+
+  uint64_t copy_sum = run_mode("copy", false);
+  uint64_t slice_sum = run_mode("slice", true);
+  if (copy_sum != slice_sum) {
+    fprintf(stderr, "checksums differ\n");
+    return 1;
+  }
+  return 0;
+}
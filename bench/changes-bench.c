@@ -0,0 +1,140 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "ssm.h"
+
+/* Measure pruning wakeups with variables that fire only on changes
+
+   A counter drives WIDTH chains of DEPTH stages.  Each stage halves its
+   input, so the output of stage k changes only every 2^k ticks:
+
+   stage(i32 &in, i32 &out) =
+     loop
+       wait in
+       out = in / 2
+
+   With ordinary variables every stage wakes every tick; with
+   ssm_changes_only() a stage wakes only when its input really changes.
+   The last stage of each chain must hold the counter >> DEPTH.
+
+   Usage: changes-bench [instants] [depth] [width]
+*/
+
+long instants;
+int depth, width;
+
+ssm_i32_t counter;
+ssm_i32_t *outs;      /* width chains of depth outputs */
+long wakeups;
+
+typedef struct {
+  SSM_ACT_FIELDS;
+  ssm_trigger_t trigger;
+  ssm_i32_t *in, *out;
+} stage_act_t;
+
+typedef struct {
+  SSM_ACT_FIELDS;
+  ssm_trigger_t trigger;
+  ssm_event_t timer;
+} count_act_t;
+
+void step_stage(ssm_act_t *sact)
+{
+  stage_act_t *act = (stage_act_t *) sact;
+  switch (act->pc) {
+  case 0:
+    ssm_sensitize(&act->in->sv, &act->trigger);
+    act->pc = 1;
+    return;
+  case 1:
+    wakeups++;
+    ssm_assign_i32(act->out, act->priority, act->in->value / 2);
+    return;
+  }
+}
+
+void step_count(ssm_act_t *sact)
+{
+  count_act_t *act = (count_act_t *) sact;
+  switch (act->pc) {
+  case 0:
+    ssm_sensitize(&act->timer.sv, &act->trigger);
+    while (ssm_now() < (ssm_time_t) instants) {
+      ssm_later_i32(&counter, ssm_now() + 1, counter.value + 1);
+      ssm_later_event(&act->timer, ssm_now() + 1);
+      act->pc = 1;
+      return;
+    case 1:
+      ;
+    }
+  }
+  ssm_desensitize(&act->trigger);
+  ssm_leave(sact, sizeof(count_act_t));
+}
+
+void run_mode(const char *name, bool changes)
+{
+  ssm_reset();
+  wakeups = 0;
+  ssm_initialize_i32(&counter);
+  counter.value = 0;
+  if (changes) ssm_changes_only(&counter);
+
+  ssm_depth_t d = SSM_ROOT_DEPTH - 6;
+  count_act_t *count = (count_act_t *)
+    ssm_enter(sizeof(count_act_t), step_count, &ssm_top_parent,
+	      SSM_ROOT_PRIORITY, d);
+  ssm_initialize_event(&count->timer);
+  count->trigger.act = (ssm_act_t *) count;
+  ssm_activate((ssm_act_t *) count);
+
+  for (int w = 0 ; w < width ; w++)
+    for (int k = 0 ; k < depth ; k++) {
+      ssm_i32_t *out = &outs[w * depth + k];
+      ssm_initialize_i32(out);
+      out->value = 0;
+      if (changes) ssm_changes_only(out);
+      stage_act_t *act = (stage_act_t *)
+	ssm_enter(sizeof(stage_act_t), step_stage, &ssm_top_parent,
+		  SSM_ROOT_PRIORITY + ((ssm_priority_t) (k + 1) << d), d);
+      act->trigger.act = (ssm_act_t *) act;
+      act->in = k ? out - 1 : &counter;
+      act->out = out;
+      ssm_activate((ssm_act_t *) act);
+    }
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  ssm_tick();
+  while (ssm_next_event_time() != SSM_NEVER)
+    ssm_tick();
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  for (int w = 0 ; w < width ; w++)
+    if (outs[w * depth + depth - 1].value != (i32) (instants >> depth)) {
+      fprintf(stderr, "%s: chain %d is wrong\n", name, w);
+      exit(1);
+    }
+
+  double seconds = (end.tv_sec - start.tv_sec) +
+    (end.tv_nsec - start.tv_nsec) * 1e-9;
+  printf("%-8s: %ld instants in %.3f s, %.0f ns/instant, "
+	 "%.2f wakeups/stage/instant\n", name, instants, seconds,
+	 seconds * 1e9 / instants,
+	 (double) wakeups / instants / (depth * width));
+}
+
+int main(int argc, char *argv[])
+{
+  instants = argc > 1 ? atol(argv[1]) : 100000;
+  depth = argc > 2 ? atoi(argv[2]) : 16;
+  width = argc > 3 ? atoi(argv[3]) : 16;
+  if (depth < 1 || depth > 62) depth = 16;
+  outs = calloc(depth * width, sizeof(ssm_i32_t));
+
+  run_mode("always", false);
+  run_mode("changes", true);
+  return 0;
+}
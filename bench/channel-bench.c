@@ -0,0 +1,202 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ssm.h"
+
+/* Compare a single-valued variable with a channel for passing messages
+
+   A producer emits BURST messages at a time to a consumer that checks
+   their sequence numbers:
+
+   produce(msg &m) =
+     loop
+       for k in 1 .. BURST
+         send m (next message)
+
+   consume(msg &m) =
+     loop
+       wait m
+       check every message received
+
+   A single-valued variable keeps only its last write, so the producer
+   must spend an instant per message, and each message is copied into
+   the variable's buffer and again by its update.  A channel takes the
+   whole burst in one instant; the producer builds each message in its
+   slot and the consumer reads it there.
+
+   Usage: channel-bench [messages] [message bytes] [burst]
+*/
+
+long messages;
+size_t msg_size;
+long burst;
+
+typedef struct {
+  uint64_t seq;
+  unsigned char data[];
+} msg_t;
+
+/** A message variable that copies, as SSM_DEFINE_SV_SCALAR would */
+typedef struct {
+  ssm_sv_t sv;
+  msg_t *value;
+  msg_t *later_value;
+} copy_msg_t;
+
+bool update_copy(ssm_sv_t *sv)
+{
+  copy_msg_t *v = container_of(sv, copy_msg_t, sv);
+  memcpy(v->value, v->later_value, msg_size);
+  return true;
+}
+
+bool channeling;
+copy_msg_t single;
+ssm_channel_t channel;
+msg_t *scratch;
+
+typedef struct {
+  SSM_ACT_FIELDS;
+  ssm_trigger_t trigger;
+  ssm_event_t timer;
+  uint64_t seq;
+} node_act_t;
+
+/** Build a message in place */
+void fill(msg_t *m, uint64_t seq)
+{
+  m->seq = seq;
+  memset(m->data, (int) seq, msg_size - sizeof(msg_t));
+}
+
+void step_produce(ssm_act_t *sact)
+{
+  node_act_t *act = (node_act_t *) sact;
+  switch (act->pc) {
+  case 0:
+    ssm_sensitize(&act->timer.sv, &act->trigger);
+    while (act->seq < (uint64_t) messages) {
+      if (channeling) {
+	for (long k = 0 ; k < burst && act->seq < (uint64_t) messages ; k++) {
+	  msg_t *m = ssm_channel_reserve(&channel);
+	  if (!m) break; // Full: wait for the consumer
+	  fill(m, ++act->seq);
+	  ssm_later_channel(&channel, ssm_now() + 1);
+	}
+      } else {
+	fill(scratch, ++act->seq);
+	memcpy(single.later_value, scratch, msg_size);
+	ssm_schedule(&single.sv, ssm_now() + 1);
+      }
+      ssm_later_event(&act->timer, ssm_now() + 1);
+      act->pc = 1;
+      return;
+    case 1:
+      ;
+    }
+  }
+  ssm_desensitize(&act->trigger);
+  ssm_leave(sact, sizeof(node_act_t));
+}
+
+void check(const msg_t *m, node_act_t *act)
+{
+  if (m->seq != ++act->seq || m->data[msg_size - sizeof(msg_t) - 1] !=
+      (unsigned char) m->seq) {
+    fprintf(stderr, "message %lu out of order\n", (unsigned long) act->seq);
+    exit(1);
+  }
+}
+
+void step_consume(ssm_act_t *sact)
+{
+  node_act_t *act = (node_act_t *) sact;
+  switch (act->pc) {
+  case 0:
+    ssm_sensitize(channeling ? &channel.sv : &single.sv, &act->trigger);
+    act->pc = 1;
+    return;
+  case 1:
+    if (channeling) {
+      msg_t *m;
+      while ((m = ssm_channel_peek(&channel))) {
+	check(m, act);
+	ssm_channel_pop(&channel);
+      }
+    } else
+      check(single.value, act);
+    return;
+  }
+}
+
+node_act_t *enter_node(ssm_stepf_t *step, ssm_priority_t priority,
+		       ssm_depth_t depth)
+{
+  node_act_t *act = (node_act_t *)
+    ssm_enter(sizeof(node_act_t), step, &ssm_top_parent, priority, depth);
+  ssm_initialize_event(&act->timer);
+  act->trigger.act = (ssm_act_t *) act;
+  act->seq = 0;
+  return act;
+}
+
+void run_mode(const char *name, bool channel_mode)
+{
+  channeling = channel_mode;
+  ssm_reset();
+  void *slots = calloc(burst, msg_size);
+  ssm_time_t *times = calloc(burst, sizeof(ssm_time_t));
+  msg_t *a = calloc(1, msg_size), *b = calloc(1, msg_size);
+  ssm_initialize_channel(&channel, slots, times, msg_size, burst);
+  ssm_initialize(&single.sv, update_copy);
+  single.value = a;
+  single.later_value = b;
+
+  ssm_depth_t depth = SSM_ROOT_DEPTH - 1;
+  ssm_activate((ssm_act_t *)
+	       enter_node(step_produce, SSM_ROOT_PRIORITY, depth));
+  node_act_t *consumer =
+    enter_node(step_consume, SSM_ROOT_PRIORITY + (1 << depth), depth);
+  ssm_activate((ssm_act_t *) consumer);
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  long instants = 0;
+  ssm_tick();
+  while (ssm_next_event_time() != SSM_NEVER) {
+    ssm_tick();
+    instants++;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  if (consumer->seq != (uint64_t) messages) {
+    fprintf(stderr, "%s: %lu messages arrived, not %ld\n", name,
+	    (unsigned long) consumer->seq, messages);
+    exit(1);
+  }
+  double seconds = (end.tv_sec - start.tv_sec) +
+    (end.tv_nsec - start.tv_nsec) * 1e-9;
+  printf("%-7s: %ld messages of %zu bytes in %ld instants, %.3f s, "
+	 "%.0f ns/message\n", name, messages, msg_size, instants, seconds,
+	 seconds * 1e9 / messages);
+  free(slots);
+  free(times);
+  free(a);
+  free(b);
+}
+
+int main(int argc, char *argv[])
+{
+  messages = argc > 1 ? atol(argv[1]) : 1000000;
+  msg_size = argc > 2 ? atol(argv[2]) : 256;
+  burst = argc > 3 ? atol(argv[3]) : 64;
+  if (msg_size <= sizeof(msg_t)) msg_size = sizeof(msg_t) + 1;
+  if (burst < 1) burst = 1;
+  scratch = calloc(1, msg_size);
+
+  run_mode("single", false);
+  run_mode("channel", true);
+  return 0;
+}
@@ -0,0 +1,166 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "ssm.h"
+
+/* Compare helper routines with a delay line for values in flight
+
+   A source sends a new value every tick over a link with a transport
+   delay of LATENCY ticks, so LATENCY values are always in flight:
+
+   source(i32 &link) =
+     loop
+       send(link, ++n)      // arrives LATENCY ticks later
+       wait 1
+
+   sink(i32 &link) =
+     loop
+       wait link
+       check link == ++m
+
+   An ssm_i32_t can only hold one pending value, so the link is first an
+   ssm_i32_t with a helper routine per value in flight, each waiting out
+   the latency on its own timer before assigning the link, then an
+   ssm_delay_t that queues the values itself.
+
+   Usage: delay-bench [instants] [latency]
+*/
+
+long instants;
+long latency;
+bool delaying;
+
+ssm_i32_t link;
+ssm_delay_t line;
+i32 line_value;
+
+typedef struct {
+  SSM_ACT_FIELDS;
+  ssm_trigger_t trigger;
+  ssm_event_t timer;
+  i32 n;
+} node_act_t;
+
+ssm_stepf_t step_source, step_sink, step_helper;
+
+node_act_t *enter_node(ssm_stepf_t *step, ssm_priority_t priority,
+		       ssm_depth_t depth)
+{
+  node_act_t *act = (node_act_t *)
+    ssm_enter(sizeof(node_act_t), step, &ssm_top_parent, priority, depth);
+  ssm_initialize_event(&act->timer);
+  act->trigger.act = (ssm_act_t *) act;
+  act->n = 0;
+  return act;
+}
+
+/** Wait out the latency, then deliver one value */
+void step_helper(ssm_act_t *sact)
+{
+  node_act_t *act = (node_act_t *) sact;
+  switch (act->pc) {
+  case 0:
+    ssm_sensitize(&act->timer.sv, &act->trigger);
+    ssm_later_event(&act->timer, ssm_now() + latency);
+    act->pc = 1;
+    return;
+  case 1:
+    ssm_desensitize(&act->trigger);
+    ssm_assign_i32(&link, act->priority, act->n);
+    ssm_leave(sact, sizeof(node_act_t));
+    return;
+  }
+}
+
+void step_source(ssm_act_t *sact)
+{
+  node_act_t *act = (node_act_t *) sact;
+  switch (act->pc) {
+  case 0:
+    ssm_sensitize(&act->timer.sv, &act->trigger);
+    while (ssm_now() < (ssm_time_t) instants) {
+      ++act->n;
+      if (delaying)
+	ssm_later_delay(&line, ssm_now() + latency, &act->n);
+      else {
+	node_act_t *helper = enter_node(step_helper, act->priority,
+					act->depth);
+	helper->n = act->n;
+	ssm_activate((ssm_act_t *) helper);
+      }
+      ssm_later_event(&act->timer, ssm_now() + 1);
+      act->pc = 1;
+      return;
+    case 1:
+      ;
+    }
+  }
+  ssm_desensitize(&act->trigger);
+  ssm_leave(sact, sizeof(node_act_t));
+}
+
+void step_sink(ssm_act_t *sact)
+{
+  node_act_t *act = (node_act_t *) sact;
+  switch (act->pc) {
+  case 0:
+    ssm_sensitize(delaying ? &line.sv : &link.sv, &act->trigger);
+    act->pc = 1;
+    return;
+  case 1:
+    if ((delaying ? line_value : link.value) != ++act->n) {
+      fprintf(stderr, "value %ld out of order\n", (long) act->n);
+      exit(1);
+    }
+    return;
+  }
+}
+
+void run_mode(const char *name, bool delay)
+{
+  delaying = delay;
+  ssm_reset();
+  ssm_time_t *times = calloc(latency, sizeof(ssm_time_t));
+  i32 *values = calloc(latency, sizeof(i32));
+  ssm_initialize_i32(&link);
+  ssm_initialize_delay(&line, &line_value, times, values, sizeof(i32),
+		       latency);
+
+  ssm_depth_t depth = SSM_ROOT_DEPTH - 1;
+  node_act_t *source = enter_node(step_source, SSM_ROOT_PRIORITY, depth);
+  node_act_t *sink = enter_node(step_sink, SSM_ROOT_PRIORITY + (1 << depth),
+				depth);
+  ssm_activate((ssm_act_t *) source);
+  ssm_activate((ssm_act_t *) sink);
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  ssm_tick();
+  while (ssm_next_event_time() != SSM_NEVER)
+    ssm_tick();
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  if (sink->n != instants) {
+    fprintf(stderr, "%s: %ld values arrived, not %ld\n", name,
+	    (long) sink->n, instants);
+    exit(1);
+  }
+  double seconds = (end.tv_sec - start.tv_sec) +
+    (end.tv_nsec - start.tv_nsec) * 1e-9;
+  printf("%-7s: %ld values in %.3f s, %.0f ns/value\n", name, instants,
+	 seconds, seconds * 1e9 / instants);
+  free(times);
+  free(values);
+}
+
+int main(int argc, char *argv[])
+{
+  instants = argc > 1 ? atol(argv[1]) : 1000000;
+  latency = argc > 2 ? atol(argv[2]) : 100;
+  if (latency < 1) latency = 1;
+
+  run_mode("helpers", false);
+  run_mode("delay", true);
+  return 0;
+}
@@ -0,0 +1,194 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "ssm.h"
+#include "ssm-linux.h"
+
+/* Compare running a parameter sweep as an ensemble against running each
+   configuration on its own
+
+   plant(u64 param) =
+     var x : u64 = 1
+     var tick : event
+     for steps
+       after 1 ms tick <- Event
+       wait tick
+       x <- x * 6 + param
+     if x is odd then result <- 2 * x + 1 else result <- 2 * x
+
+   The scalar version runs plant once per configuration.  The ensemble
+   version runs all SSM_LANES configurations in lock step; at the end, the
+   lanes whose x is odd split off into another context.
+
+   Usage: ensemble-bench [steps]
+*/
+
+u64 params[SSM_LANES];
+u64 scalar_results[SSM_LANES];
+u64 *ensemble_results; // Shared by every context of the ensemble
+long steps;
+
+typedef struct {
+  SSM_ACT_FIELDS;
+  ssm_trigger_t trigger;
+  ssm_event_t tick;
+  ssm_u64_t x;
+  long count;
+  int lane;
+} plant_act_t;
+
+ssm_stepf_t step_plant;
+
+plant_act_t *enter_plant(ssm_act_t *parent, ssm_priority_t priority,
+			 ssm_depth_t depth, int lane)
+{
+  plant_act_t *act = (plant_act_t *)
+    ssm_enter(sizeof(plant_act_t), step_plant, parent, priority, depth);
+  ssm_initialize_event(&act->tick);
+  ssm_initialize_u64(&act->x);
+  act->x.value = 1;
+  act->count = 0;
+  act->lane = lane;
+  act->trigger.act = (ssm_act_t *) act;
+  return act;
+}
+
+void step_plant(ssm_act_t *sact)
+{
+  plant_act_t *act = (plant_act_t *) sact;
+  switch (act->pc) {
+  case 0:
+    ssm_sensitize(&act->tick.sv, &act->trigger);
+    for ( ; act->count < steps ; act->count++) {
+      ssm_later_event(&act->tick, ssm_now() + SSM_MILLISECOND);
+      act->pc = 1;
+      return;
+    case 1:
+      ssm_assign_u64(&act->x, act->priority,
+		     act->x.value * 6 + params[act->lane]);
+    }
+    ssm_desensitize(&act->trigger);
+    if (act->x.value & 1)
+      scalar_results[act->lane] = 2 * act->x.value + 1;
+    else
+      scalar_results[act->lane] = 2 * act->x.value;
+  }
+  ssm_leave(sact, sizeof(plant_act_t));
+}
+
+typedef struct {
+  SSM_ACT_FIELDS;
+  ssm_trigger_t trigger;
+  ssm_event_t tick;
+  ssm_u64_lanes_t x;
+  long count;
+} plant_lanes_act_t;
+
+ssm_stepf_t step_plant_lanes;
+
+plant_lanes_act_t *enter_plant_lanes(ssm_act_t *parent,
+				     ssm_priority_t priority,
+				     ssm_depth_t depth)
+{
+  plant_lanes_act_t *act = (plant_lanes_act_t *)
+    ssm_enter(sizeof(plant_lanes_act_t), step_plant_lanes, parent, priority,
+	      depth);
+  ssm_initialize_event(&act->tick);
+  ssm_initialize_u64_lanes(&act->x);
+  for (int i = 0 ; i < SSM_LANES ; i++)
+    act->x.value[i] = 1;
+  act->count = 0;
+  act->trigger.act = (ssm_act_t *) act;
+  return act;
+}
+
+void step_plant_lanes(ssm_act_t *sact)
+{
+  plant_lanes_act_t *act = (plant_lanes_act_t *) sact;
+  u64 next[SSM_LANES];
+  bool odd[SSM_LANES];
+  switch (act->pc) {
+  case 0:
+    ssm_sensitize(&act->tick.sv, &act->trigger);
+    for ( ; act->count < steps ; act->count++) {
+      ssm_later_event(&act->tick, ssm_now() + SSM_MILLISECOND);
+      act->pc = 1;
+      return;
+    case 1:
+      for (int i = 0 ; i < SSM_LANES ; i++)
+	next[i] = act->x.value[i] * 6 + params[i];
+      ssm_assign_u64_lanes(&act->x, act->priority, next);
+    }
+    ssm_desensitize(&act->trigger);
+    for (int i = 0 ; i < SSM_LANES ; i++)
+      odd[i] = act->x.value[i] & 1;
+    if (ssm_diverge(ssm_lanes_where(odd))) {
+      for (int i = 0 ; i < SSM_LANES ; i++)
+	if (ssm_active_lanes >> i & 1)
+	  ensemble_results[i] = 2 * act->x.value[i] + 1;
+    } else {
+      for (int i = 0 ; i < SSM_LANES ; i++)
+	if (ssm_active_lanes >> i & 1)
+	  ensemble_results[i] = 2 * act->x.value[i];
+    }
+  }
+  ssm_leave(sact, sizeof(plant_lanes_act_t));
+}
+
+void run(ssm_act_t *act)
+{
+  ssm_reset();
+  ssm_activate(act);
+  ssm_tick();
+  while (ssm_next_event_time() != SSM_NEVER)
+    ssm_tick();
+}
+
+double seconds_since(struct timespec *start)
+{
+  struct timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  return (end.tv_sec - start->tv_sec) + (end.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+int main(int argc, char *argv[])
+{
+  steps = argc > 1 ? atol(argv[1]) : 200000;
+  for (int i = 0 ; i < SSM_LANES ; i++)
+    params[i] = i + 1; // x ends up odd in lanes with odd parameters
+  ensemble_results = ssm_ensemble_shared(SSM_LANES * sizeof(u64));
+  if (!ensemble_results) {
+    perror("ssm_ensemble_shared");
+    return 1;
+  }
+
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int i = 0 ; i < SSM_LANES ; i++)
+    run((ssm_act_t *) enter_plant(&ssm_top_parent, SSM_ROOT_PRIORITY,
+				  SSM_ROOT_DEPTH, i));
+  double scalar = seconds_since(&start);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  run((ssm_act_t *) enter_plant_lanes(&ssm_top_parent, SSM_ROOT_PRIORITY,
+				      SSM_ROOT_DEPTH));
+  if (ssm_ensemble_join()) {
+    printf("a split-off context failed\n");
+    return 1;
+  }
+  double ensemble = seconds_since(&start);
+
+  int mismatches = 0;
+  for (int i = 0 ; i < SSM_LANES ; i++)
+    if (scalar_results[i] != ensemble_results[i]) mismatches++;
+
+  double runs = (double) SSM_LANES * steps;
+  printf("scalar: %d runs of %ld instants in %.3f s: %.1f ns per run-instant\n",
+	 SSM_LANES, steps, scalar, scalar * 1e9 / runs);
+  printf("ensemble: %d lanes of %ld instants in %.3f s: "
+	 "%.1f ns per run-instant\n",
+	 SSM_LANES, steps, ensemble, ensemble * 1e9 / runs);
+  printf(mismatches ? "%d lanes differ\n" : "results match\n", mismatches);
+  return mismatches != 0;
+}
@@ -0,0 +1,132 @@
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "ssm.h"
+#include "ssm-linux.h"
+
+/* Stress the multi-producer input ring under the real-time driver
+
+   Each producer thread posts the sequence 1, 2, ..., n to its own
+   variable, timestamped with the wall time.  A watcher routine per
+   variable checks the values it sees never go backward.  Updates posted
+   before the same instant may coalesce, so the watcher may skip values,
+   but it must end at n.
+
+   watch(u64 &v) =
+     loop
+       wait v
+       if v < last then backward = backward + 1
+       last = v
+
+   Usage: input-bench [producers] [posts per producer]
+*/
+
+#define MAX_PRODUCERS 16
+
+long posts;
+int producers;
+ssm_u64_t vars[MAX_PRODUCERS];
+u64 last[MAX_PRODUCERS];
+long backward, seen, full;
+int done;
+
+typedef struct {
+  SSM_ACT_FIELDS;
+  ssm_trigger_t trigger;
+  int id;
+} watch_act_t;
+
+ssm_stepf_t step_watch;
+
+watch_act_t *enter_watch(ssm_act_t *parent, ssm_priority_t priority,
+			 ssm_depth_t depth, int id)
+{
+  watch_act_t *act = (watch_act_t *)
+    ssm_enter(sizeof(watch_act_t), step_watch, parent, priority, depth);
+  act->id = id;
+  act->trigger.act = (ssm_act_t *) act;
+  return act;
+}
+
+void step_watch(ssm_act_t *sact)
+{
+  watch_act_t *act = (watch_act_t *) sact;
+  switch (act->pc) {
+  case 0:
+    ssm_sensitize(&vars[act->id].sv, &act->trigger);
+    act->pc = 1;
+    return;
+  case 1:
+    if (vars[act->id].value < last[act->id]) backward++;
+    last[act->id] = vars[act->id].value;
+    seen++;
+    return;
+  }
+}
+
+void *produce(void *arg)
+{
+  int id = (int) (long) arg;
+  for (u64 i = 1 ; i <= (u64) posts ; i++)
+    while (!ssm_input_post(&vars[id].sv, ssm_deliver_u64,
+			   ssm_rt_wall_time(), &i, sizeof(i))) {
+      __atomic_fetch_add(&full, 1, __ATOMIC_RELAXED);
+      sched_yield();
+    }
+  if (__atomic_add_fetch(&done, 1, __ATOMIC_ACQ_REL) == producers)
+    ssm_rt_stop();
+  return 0;
+}
+
+int main(int argc, char *argv[])
+{
+  producers = argc > 1 ? atoi(argv[1]) : 4;
+  posts = argc > 2 ? atol(argv[2]) : 250000;
+  if (producers < 1 || producers > MAX_PRODUCERS) {
+    fprintf(stderr, "between 1 and %d producers\n", MAX_PRODUCERS);
+    return 1;
+  }
+
+  if (ssm_rt_init() < 0) {
+    perror("ssm_rt_init");
+    return 1;
+  }
+  ssm_depth_t depth = SSM_ROOT_DEPTH - 5;
+  for (int i = 0 ; i < producers ; i++) {
+    ssm_initialize_u64(&vars[i]);
+    vars[i].value = 0;
+    ssm_activate((ssm_act_t *)
+		 enter_watch(&ssm_top_parent,
+			     SSM_ROOT_PRIORITY + ((ssm_priority_t) i << depth),
+			     depth, i));
+  }
+  ssm_tick();
+
+  pthread_t threads[MAX_PRODUCERS];
+  for (int i = 0 ; i < producers ; i++)
+    pthread_create(&threads[i], 0, produce, (void *) (long) i);
+  ssm_rt_run(SSM_NEVER);
+  for (int i = 0 ; i < producers ; i++)
+    pthread_join(threads[i], 0);
+
+  // Take in whatever was posted after the stop
+  for (ssm_input_drain() ; ssm_next_event_time() != SSM_NEVER ;
+       ssm_input_drain())
+    ssm_tick();
+
+  double secs = (double) ssm_rt_wall_time() / SSM_SECOND;
+  int short_ends = 0;
+  for (int i = 0 ; i < producers ; i++)
+    if (last[i] != (u64) posts) short_ends++;
+  printf("%d producers posted %ld updates in %.3f s: %.0f posts per second\n",
+	 producers, producers * posts, secs, producers * posts / secs);
+  printf("%ld updates seen after coalescing; ring full %ld times\n",
+	 seen, full);
+  printf(backward || short_ends ? "%ld backward, %d ended early\n"
+	 : "ordering preserved\n", backward, short_ends);
+  ssm_rt_close();
+  return backward || short_ends;
+}
@@ -0,0 +1,135 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "ssm.h"
+
+/* Compare mirroring outputs by polling every one with mirroring only the
+   ones in the changed-variable journal
+
+   A driver routine assigns a few of many output variables each instant,
+   round robin.  After each instant, the platform copies changed outputs
+   to a "device" array, either by checking every output with
+   ssm_event_on() or by walking ssm_journal().
+
+   driver(u32 outputs[n]) =
+     loop
+       after 1 ms tick <- Event
+       wait tick
+       for k changes: outputs[next++ % n] <- now
+
+   The journal only runs when the library and the bench are compiled
+   with -DSSM_JOURNAL.
+
+   Usage: journal-bench [outputs] [changes per instant] [instants]
+*/
+
+long n_outputs, changes, instants;
+ssm_u32_t *outputs;
+u32 *device;
+
+typedef struct {
+  SSM_ACT_FIELDS;
+  ssm_trigger_t trigger;
+  ssm_event_t tick;
+  long next;
+} driver_act_t;
+
+ssm_stepf_t step_driver;
+
+driver_act_t *enter_driver(ssm_act_t *parent, ssm_priority_t priority,
+			   ssm_depth_t depth)
+{
+  driver_act_t *act = (driver_act_t *)
+    ssm_enter(sizeof(driver_act_t), step_driver, parent, priority, depth);
+  ssm_initialize_event(&act->tick);
+  act->next = 0;
+  act->trigger.act = (ssm_act_t *) act;
+  return act;
+}
+
+void step_driver(ssm_act_t *sact)
+{
+  driver_act_t *act = (driver_act_t *) sact;
+  switch (act->pc) {
+  case 0:
+    ssm_sensitize(&act->tick.sv, &act->trigger);
+    for (;;) {
+      ssm_later_event(&act->tick, ssm_now() + SSM_MILLISECOND);
+      act->pc = 1;
+      return;
+    case 1:
+      for (long k = 0 ; k < changes ; k++, act->next++)
+	ssm_assign_u32(&outputs[act->next % n_outputs], act->priority,
+		       ssm_now() / SSM_MILLISECOND);
+    }
+  }
+}
+
+/** Run the model, mirroring outputs after each instant; return seconds */
+double run(bool journal, u64 *checksum)
+{
+  ssm_reset();
+  for (long i = 0 ; i < n_outputs ; i++) {
+    ssm_initialize_u32(&outputs[i]);
+    outputs[i].value = device[i] = 0;
+  }
+  ssm_activate((ssm_act_t *) enter_driver(&ssm_top_parent, SSM_ROOT_PRIORITY,
+					  SSM_ROOT_DEPTH));
+  ssm_tick();
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (long t = 0 ; t < instants ; t++) {
+    ssm_tick();
+#ifdef SSM_JOURNAL
+    if (journal) {
+      size_t count;
+      ssm_sv_t *const *changed = ssm_journal(&count);
+      for (size_t i = 0 ; i < count ; i++) {
+	ssm_u32_t *v = container_of(changed[i], ssm_u32_t, sv);
+	if (v >= outputs && v < outputs + n_outputs) // An output?
+	  device[v - outputs] = v->value;
+      }
+    } else
+#endif
+      for (long i = 0 ; i < n_outputs ; i++)
+	if (ssm_event_on(&outputs[i].sv))
+	  device[i] = outputs[i].value;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  *checksum = 0;
+  for (long i = 0 ; i < n_outputs ; i++)
+    *checksum = *checksum * 31 + device[i];
+  return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
+}
+
+int main(int argc, char *argv[])
+{
+  n_outputs = argc > 1 ? atol(argv[1]) : 10000;
+  changes = argc > 2 ? atol(argv[2]) : 10;
+  instants = argc > 3 ? atol(argv[3]) : 20000;
+  outputs = malloc(n_outputs * sizeof(ssm_u32_t));
+  device = malloc(n_outputs * sizeof(u32));
+  if (!outputs || !device) {
+    perror("malloc");
+    return 1;
+  }
+
+  u64 polled_sum;
+  double polled = run(false, &polled_sum);
+  printf("polling %ld outputs: %.2f us per instant\n", n_outputs,
+	 polled * 1e6 / instants);
+#ifdef SSM_JOURNAL
+  u64 journal_sum;
+  double journaled = run(true, &journal_sum);
+  printf("journal of %ld changes: %.2f us per instant\n", changes,
+	 journaled * 1e6 / instants);
+  printf(polled_sum == journal_sum ? "results match\n" : "results differ\n");
+  return polled_sum != journal_sum;
+#else
+  printf("journal: compiled without -DSSM_JOURNAL\n");
+  return 0;
+#endif
+}
@@ -0,0 +1,146 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "ssm.h"
+
+/* Compare eager and lazy commits of variables that are rarely read
+
+   A writer refreshes every sample every tick; a monitor reads one of
+   them every PERIOD ticks:
+
+   write(i32 &s[]) =
+     loop
+       for i in 0 .. SAMPLES - 1
+         after 1 s[i] <- now
+       wait 1
+     until INSTANTS
+
+   monitor(i32 &s[]) =
+     loop
+       wait PERIOD
+       check s[random] == now
+
+   The samples are first ssm_i32_t, each updated by ssm_tick(), then
+   ssm_i32_lazy_t, which commit only when the monitor reads them.
+
+   Usage: lazy-bench [instants] [samples] [period]
+*/
+
+long instants;
+size_t samples;
+long period;
+bool lazy;
+
+ssm_i32_t *eager;
+ssm_i32_lazy_t *lazies;
+
+typedef struct {
+  SSM_ACT_FIELDS;
+  ssm_trigger_t trigger;
+  ssm_event_t timer;
+  unsigned seed;
+} node_act_t;
+
+void step_write(ssm_act_t *sact)
+{
+  node_act_t *act = (node_act_t *) sact;
+  switch (act->pc) {
+  case 0:
+    ssm_sensitize(&act->timer.sv, &act->trigger);
+    while (ssm_now() < (ssm_time_t) instants) {
+      for (size_t i = 0 ; i < samples ; i++)
+	if (lazy)
+	  ssm_later_i32_lazy(&lazies[i], ssm_now() + 1, ssm_now() + 1);
+	else
+	  ssm_later_i32(&eager[i], ssm_now() + 1, ssm_now() + 1);
+      ssm_later_event(&act->timer, ssm_now() + 1);
+      act->pc = 1;
+      return;
+    case 1:
+      ;
+    }
+  }
+  ssm_desensitize(&act->trigger);
+  ssm_leave(sact, sizeof(node_act_t));
+}
+
+void step_monitor(ssm_act_t *sact)
+{
+  node_act_t *act = (node_act_t *) sact;
+  switch (act->pc) {
+  case 0:
+    ssm_sensitize(&act->timer.sv, &act->trigger);
+    while (ssm_now() + period <= (ssm_time_t) instants) {
+      ssm_later_event(&act->timer, ssm_now() + period);
+      act->pc = 1;
+      return;
+    case 1:
+      ;
+      size_t i = rand_r(&act->seed) % samples;
+      i32 x = lazy ? ssm_read_i32_lazy(&lazies[i]) : eager[i].value;
+      if (x != (i32) ssm_now()) {
+	fprintf(stderr, "sample %zu is %ld at %ld\n", i, (long) x,
+		(long) ssm_now());
+	exit(1);
+      }
+    }
+  }
+  ssm_desensitize(&act->trigger);
+  ssm_leave(sact, sizeof(node_act_t));
+}
+
+node_act_t *enter_node(ssm_stepf_t *step, ssm_priority_t priority,
+		       ssm_depth_t depth)
+{
+  node_act_t *act = (node_act_t *)
+    ssm_enter(sizeof(node_act_t), step, &ssm_top_parent, priority, depth);
+  ssm_initialize_event(&act->timer);
+  act->trigger.act = (ssm_act_t *) act;
+  act->seed = 1;
+  return act;
+}
+
+void run_mode(const char *name, bool lazy_mode)
+{
+  lazy = lazy_mode;
+  ssm_reset();
+  for (size_t i = 0 ; i < samples ; i++)
+    if (lazy)
+      ssm_initialize_i32_lazy(&lazies[i]);
+    else
+      ssm_initialize_i32(&eager[i]);
+
+  ssm_depth_t depth = SSM_ROOT_DEPTH - 1;
+  ssm_activate((ssm_act_t *)
+	       enter_node(step_write, SSM_ROOT_PRIORITY, depth));
+  ssm_activate((ssm_act_t *)
+	       enter_node(step_monitor, SSM_ROOT_PRIORITY + (1 << depth),
+			  depth));
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  ssm_tick();
+  while (ssm_next_event_time() != SSM_NEVER)
+    ssm_tick();
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  double seconds = (end.tv_sec - start.tv_sec) +
+    (end.tv_nsec - start.tv_nsec) * 1e-9;
+  printf("%-5s: %ld instants in %.3f s, %.1f ns/write\n", name, instants,
+	 seconds, seconds * 1e9 / instants / samples);
+}
+
+int main(int argc, char *argv[])
+{
+  instants = argc > 1 ? atol(argv[1]) : 20000;
+  samples = argc > 2 ? atol(argv[2]) : 1000;
+  period = argc > 3 ? atol(argv[3]) : 100;
+  if (period < 1) period = 1;
+  eager = calloc(samples, sizeof(ssm_i32_t));
+  lazies = calloc(samples, sizeof(ssm_i32_lazy_t));
+
+  run_mode("eager", false);
+  run_mode("lazy", true);
+  return 0;
+}
@@ -0,0 +1,198 @@
+#define _GNU_SOURCE
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "ssm.h"
+#include "ssm-linux.h"
+
+/* Measure the lateness of instants that start heavy computations
+
+   A periodic routine computes a naive discrete Fourier transform of a
+   synthetic window of samples every period and assigns the strongest
+   bin, as a delayed assignment, a fixed latency later; a second routine
+   adds the results into a checksum.  The latency must be less than the
+   period since a variable holds only one pending update.
+
+   sample(i64 &spectrum) =
+     loop
+       after LATENCY spectrum <- dft(window)
+       after PERIOD timer <- Event
+       wait timer
+
+   The model runs twice under the real-time driver: computing the
+   transform inside the instant, then offloading it to worker threads.
+   Both runs must produce the same checksum.
+
+   Usage: offload-bench [instants] [period in us] [latency in us] [window]
+                        [workers]
+*/
+
+long window;
+ssm_time_t period, latency;
+bool offloading;
+long late;
+uint64_t checksum;
+
+/** Return the index of the strongest bin of window k's transform */
+void dft(void *arg, void *result)
+{
+  long k = (long) (uintptr_t) arg;
+  double x[window], c[window], s[window];
+  for (long n = 0 ; n < window ; n++) {
+    x[n] = sin(2 * M_PI * n * ((k % 37) + 3) / window) +
+      0.5 * sin(2 * M_PI * n * ((k % 11) + 40) / window);
+    c[n] = cos(2 * M_PI * n / window);
+    s[n] = sin(2 * M_PI * n / window);
+  }
+  double best = -1;
+  int64_t best_bin = 0;
+  for (long f = 0 ; f < window / 2 ; f++) {
+    double re = 0, im = 0;
+    for (long n = 0 ; n < window ; n++) {
+      long t = f * n % window;
+      re += x[n] * c[t];
+      im -= x[n] * s[t];
+    }
+    double power = re * re + im * im;
+    if (power > best) {
+      best = power;
+      best_bin = f;
+    }
+  }
+  *(int64_t *) result = best_bin;
+}
+
+typedef struct {
+  SSM_ACT_FIELDS;
+  ssm_trigger_t trigger;
+  ssm_event_t timer;
+  ssm_i64_t *spectrum;
+  long k;
+} sample_act_t;
+
+typedef struct {
+  SSM_ACT_FIELDS;
+  ssm_trigger_t trigger;
+  ssm_i64_t *spectrum;
+} sum_act_t;
+
+ssm_stepf_t step_sample, step_sum;
+
+void step_sample(ssm_act_t *sact)
+{
+  sample_act_t *act = (sample_act_t *) sact;
+  switch (act->pc) {
+  case 0:
+    ssm_sensitize(&act->timer.sv, &act->trigger);
+    for (;;) {
+      if (offloading) {
+	if (!ssm_offload(dft, (void *) (uintptr_t) act->k,
+			 &act->spectrum->sv, ssm_deliver_i64,
+			 ssm_now() + latency)) {
+	  fprintf(stderr, "too many outstanding computations\n");
+	  exit(1);
+	}
+      } else {
+	int64_t bin;
+	dft((void *) (uintptr_t) act->k, &bin);
+	ssm_later_i64(act->spectrum, ssm_now() + latency, bin);
+      }
+      act->k++;
+      ssm_later_event(&act->timer, ssm_now() + period);
+      act->pc = 1;
+      return;
+    case 1:
+      ;
+    }
+  }
+}
+
+void step_sum(ssm_act_t *sact)
+{
+  sum_act_t *act = (sum_act_t *) sact;
+  switch (act->pc) {
+  case 0:
+    ssm_sensitize(&act->spectrum->sv, &act->trigger);
+    act->pc = 1;
+    return;
+  case 1:
+    checksum = checksum * 31 + act->spectrum->value;
+    return;
+  }
+}
+
+void record_late(ssm_time_t due, ssm_time_t waited) { late++; }
+
+void run_mode(const char *name, long instants)
+{
+  static ssm_i64_t spectrum;
+  if (ssm_rt_init() < 0) {
+    perror("ssm_rt_init");
+    exit(1);
+  }
+  checksum = 0;
+  late = 0;
+
+  ssm_reset();
+  ssm_initialize_i64(&spectrum);
+  ssm_depth_t new_depth = SSM_ROOT_DEPTH - 1;
+  sample_act_t *sample = (sample_act_t *)
+    ssm_enter(sizeof(sample_act_t), step_sample, &ssm_top_parent,
+	      SSM_ROOT_PRIORITY, new_depth);
+  ssm_initialize_event(&sample->timer);
+  sample->trigger.act = (ssm_act_t *) sample;
+  sample->spectrum = &spectrum;
+  sample->k = 0;
+  sum_act_t *sum = (sum_act_t *)
+    ssm_enter(sizeof(sum_act_t), step_sum, &ssm_top_parent,
+	      SSM_ROOT_PRIORITY + (1 << new_depth), new_depth);
+  sum->trigger.act = (ssm_act_t *) sum;
+  sum->spectrum = &spectrum;
+  ssm_activate((ssm_act_t *) sample);
+  ssm_activate((ssm_act_t *) sum);
+
+  ssm_tick();
+  ssm_rt_run(instants * period + latency + 1);
+
+  ssm_rt_stats_t stats = ssm_rt_stats();
+  printf("%s: %lu instants, lateness mean %.1f us, max %.1f us, "
+	 "%ld results waited for, checksum %016lx\n", name,
+	 (unsigned long) stats.instants,
+	 (double) stats.total / stats.instants / SSM_MICROSECOND,
+	 (double) stats.max / SSM_MICROSECOND, late,
+	 (unsigned long) checksum);
+  ssm_rt_close();
+}
+
+int main(int argc, char *argv[])
+{
+  long instants = argc > 1 ? atol(argv[1]) : 500;
+  period = (argc > 2 ? atol(argv[2]) : 2000) * SSM_MICROSECOND;
+  latency = (argc > 3 ? atol(argv[3]) : 1500) * SSM_MICROSECOND;
+  window = argc > 4 ? atol(argv[4]) : 256;
+  if (latency >= period) {
+    fprintf(stderr, "latency must be less than the period\n");
+    return 1;
+  }
+  unsigned workers = argc > 5 ? atoi(argv[5]) : 4;
+
+  offloading = false;
+  run_mode("inline", instants);
+  uint64_t inline_checksum = checksum;
+
+  if (ssm_offload_start(workers) < 0) {
+    perror("ssm_offload_start");
+    return 1;
+  }
+  ssm_offload_set_late_handler(record_late);
+  ssm_rt_set_collector(ssm_offload_collect);
+  offloading = true;
+  run_mode("offload", instants);
+  ssm_offload_stop();
+
+  if (checksum != inline_checksum) {
+    fprintf(stderr, "checksums differ\n");
+    return 1;
+  }
+  return 0;
+}
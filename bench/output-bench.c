@@ -0,0 +1,167 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "ssm.h"
+#include "ssm-linux.h"
+
+/* Measure what deferring device I/O does to instants
+
+   Every period, a high-priority routine writes to a slow device,
+   modeled by sleeping, and a low-priority routine wakes on the same
+   event.  We time how long after the start of the instant the
+   low-priority routine runs, and how long the tick thread is busy per
+   instant, when the write is done
+
+   - in the step function itself,
+   - as a deferred action performed after ssm_tick(), and
+   - as a deferred action handed to the I/O thread.
+
+   writer(event &clk) =             reader(event &clk) =
+     loop                             loop
+       wait clk                         wait clk
+       device_write()                   note the time
+
+   Usage: output-bench [instants] [device write us]
+*/
+
+enum mode { IN_STEP, DEFERRED, IO_THREAD };
+
+enum mode mode;
+long write_us;
+long writes;
+struct timespec instant_start;
+double reader_delay;
+
+double seconds_between(struct timespec *start, struct timespec *end)
+{
+  return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+void device_write(void *data, uint64_t value)
+{
+  usleep(write_us);
+  writes++;
+}
+
+typedef struct {
+  SSM_ACT_FIELDS;
+  ssm_trigger_t trigger;
+  ssm_event_t *clk;
+} loop_act_t;
+
+ssm_stepf_t step_clock, step_writer, step_reader;
+
+loop_act_t *enter_loop(ssm_act_t *parent, ssm_priority_t priority,
+		       ssm_depth_t depth, ssm_stepf_t *step, ssm_event_t *clk)
+{
+  loop_act_t *act = (loop_act_t *)
+    ssm_enter(sizeof(loop_act_t), step, parent, priority, depth);
+  act->clk = clk;
+  act->trigger.act = (ssm_act_t *) act;
+  return act;
+}
+
+void step_clock(ssm_act_t *sact)
+{
+  loop_act_t *act = (loop_act_t *) sact;
+  switch (act->pc) {
+  case 0:
+    ssm_sensitize(&act->clk->sv, &act->trigger);
+    for (;;) {
+      ssm_later_event(act->clk, ssm_now() + SSM_MILLISECOND);
+      act->pc = 1;
+      return;
+    case 1:
+      ;
+    }
+  }
+}
+
+void step_writer(ssm_act_t *sact)
+{
+  loop_act_t *act = (loop_act_t *) sact;
+  switch (act->pc) {
+  case 0:
+    ssm_sensitize(&act->clk->sv, &act->trigger);
+    act->pc = 1;
+    return;
+  case 1:
+    if (mode == IN_STEP)
+      device_write(0, ssm_now());
+    else
+      ssm_defer(device_write, 0, ssm_now());
+    return;
+  }
+}
+
+void step_reader(ssm_act_t *sact)
+{
+  loop_act_t *act = (loop_act_t *) sact;
+  struct timespec now;
+  switch (act->pc) {
+  case 0:
+    ssm_sensitize(&act->clk->sv, &act->trigger);
+    act->pc = 1;
+    return;
+  case 1:
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    reader_delay += seconds_between(&instant_start, &now);
+    return;
+  }
+}
+
+ssm_event_t clk;
+
+void run(const char *name, enum mode m, long instants)
+{
+  mode = m;
+  writes = 0;
+  reader_delay = 0;
+  if (mode == IO_THREAD && ssm_output_start() < 0) {
+    perror("ssm_output_start");
+    exit(1);
+  }
+
+  ssm_reset();
+  ssm_initialize_event(&clk);
+  ssm_depth_t depth = SSM_ROOT_DEPTH - 2;
+  ssm_activate((ssm_act_t *) enter_loop(&ssm_top_parent, 0, depth,
+					step_clock, &clk));
+  ssm_activate((ssm_act_t *) enter_loop(&ssm_top_parent, 1 << depth, depth,
+					step_writer, &clk));
+  ssm_activate((ssm_act_t *) enter_loop(&ssm_top_parent, 2 << depth, depth,
+					step_reader, &clk));
+  ssm_tick();
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (long i = 0 ; i < instants ; i++) {
+    clock_gettime(CLOCK_MONOTONIC, &instant_start);
+    ssm_tick();
+    ssm_flush_actions(mode == IO_THREAD ? ssm_output_sink : 0);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double busy = seconds_between(&start, &end);
+  if (mode == IO_THREAD) ssm_output_stop();
+
+  printf("%-10s reader runs %8.1f us into the instant; "
+	 "tick thread busy %8.1f us per instant; %ld writes\n", name,
+	 reader_delay * 1e6 / instants, busy * 1e6 / instants, writes);
+}
+
+int main(int argc, char *argv[])
+{
+  long instants = argc > 1 ? atol(argv[1]) : 2000;
+  write_us = argc > 2 ? atol(argv[2]) : 50;
+  if (instants > SSM_OUTPUT_RING_SIZE) {
+    fprintf(stderr, "at most %d instants\n", SSM_OUTPUT_RING_SIZE);
+    return 1;
+  }
+
+  run("in step", IN_STEP, instants);
+  run("deferred", DEFERRED, instants);
+  run("I/O thread", IO_THREAD, instants);
+  return 0;
+}
@@ -0,0 +1,153 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "ssm.h"
+
+/* Compare separate scalar variables with a pool of the same variables
+
+   Every tick, a writer schedules some fraction of a large set of
+   integer signals for one of the next SPREAD ticks:
+
+   write(i32 &s[]) =
+     loop
+       for k in 1 .. WRITES
+         after 1 + random % SPREAD s[random] <- random
+       wait 1
+     until INSTANTS
+
+   The signals are first one ssm_i32_t each, whose updates are one call
+   apiece through the event queue, then an ssm_i32_pool_t, which commits
+   them together.  Each run checks its signals against a plain copy.
+   Separate variables each take an event-queue and a journal entry, so
+   they are only run with no more pending writes than the default queue
+   and journal sizes allow; the pool takes one of each however many
+   signals are pending.  With a SPREAD above 1, the pool's elements are
+   pending at many different times.
+
+   Usage: pool-bench [instants] [signals] [writes per instant] [spread]
+*/
+
+long instants;
+size_t signals;
+long writes;
+long spread;
+
+bool pooled;
+ssm_i32_t *separate;
+ssm_i32_pool_t pool;
+i32 *expected;
+
+typedef struct {
+  SSM_ACT_FIELDS;
+  ssm_trigger_t trigger;
+  ssm_event_t timer;
+  unsigned seed;
+} writer_act_t;
+
+void step_writer(ssm_act_t *sact)
+{
+  writer_act_t *act = (writer_act_t *) sact;
+  switch (act->pc) {
+  case 0:
+    ssm_sensitize(&act->timer.sv, &act->trigger);
+    while (ssm_now() < (ssm_time_t) instants) {
+      for (long k = 0 ; k < writes ; k++) {
+	size_t i = rand_r(&act->seed) % signals;
+	i32 x = rand_r(&act->seed);
+	ssm_time_t then = ssm_now() + 1 + rand_r(&act->seed) % spread;
+	expected[i] = x;
+	if (pooled)
+	  ssm_later_i32_pool(&pool, then, i, x);
+	else
+	  ssm_later_i32(&separate[i], then, x);
+      }
+      ssm_later_event(&act->timer, ssm_now() + 1);
+      act->pc = 1;
+      return;
+    case 1:
+      ;
+    }
+  }
+  ssm_desensitize(&act->trigger);
+  ssm_leave(sact, sizeof(writer_act_t));
+}
+
+void run_mode(const char *name, bool pool_mode)
+{
+  pooled = pool_mode;
+  ssm_reset();
+  expected = calloc(signals, sizeof(i32));
+  /* The pool's storage; the program decides where it lives */
+  i32 *value = 0, *later = 0;
+  ssm_time_t *times = 0;
+  ssm_trigger_t **triggers = 0;
+  uint32_t *indices = 0;
+  if (pooled) {
+    value = malloc(signals * sizeof(i32));
+    later = malloc(signals * sizeof(i32));
+    times = malloc(2 * signals * sizeof(ssm_time_t));
+    triggers = malloc(signals * sizeof(ssm_trigger_t *));
+    indices = malloc(2 * signals * sizeof(uint32_t));
+    if (!value || !later || !times || !triggers || !indices) {
+      perror("malloc");
+      exit(1);
+    }
+    ssm_initialize_i32_pool(&pool, value, later, times, triggers, indices,
+			    signals);
+  } else {
+    separate = calloc(signals, sizeof(ssm_i32_t));
+    for (size_t i = 0 ; i < signals ; i++) {
+      ssm_initialize_i32(&separate[i]);
+      separate[i].value = 0;
+    }
+  }
+
+  writer_act_t *act = (writer_act_t *)
+    ssm_enter(sizeof(writer_act_t), step_writer, &ssm_top_parent,
+	      SSM_ROOT_PRIORITY, SSM_ROOT_DEPTH);
+  ssm_initialize_event(&act->timer);
+  act->trigger.act = (ssm_act_t *) act;
+  act->seed = 1;
+  ssm_activate((ssm_act_t *) act);
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  ssm_tick();
+  while (ssm_next_event_time() != SSM_NEVER)
+    ssm_tick();
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  for (size_t i = 0 ; i < signals ; i++)
+    if ((pooled ? pool.value[i] : separate[i].value) != expected[i]) {
+      fprintf(stderr, "%s: signal %zu is wrong\n", name, i);
+      exit(1);
+    }
+
+  double seconds = (end.tv_sec - start.tv_sec) +
+    (end.tv_nsec - start.tv_nsec) * 1e-9;
+  printf("%-8s: %ld instants in %.3f s, %.1f ns/write\n", name, instants,
+	 seconds, seconds * 1e9 / (instants * writes));
+  free(value);
+  free(later);
+  free(times);
+  free(triggers);
+  free(indices);
+  free(separate);
+  separate = 0;
+  free(expected);
+}
+
+int main(int argc, char *argv[])
+{
+  instants = argc > 1 ? atol(argv[1]) : 100;
+  signals = argc > 2 ? atol(argv[2]) : 100000;
+  writes = argc > 3 ? atol(argv[3]) : 1000;
+  spread = argc > 4 ? atol(argv[4]) : 1;
+  if (spread < 1) spread = 1;
+
+  if (writes * spread <= 1000)
+    run_mode("separate", false);
+  run_mode("pool", true);
+  return 0;
+}
@@ -0,0 +1,122 @@
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "ssm.h"
+#include "ssm-linux.h"
+
+/* Count edges far faster than instants under the real-time driver
+
+   Producer threads count edges on a pulse counter as fast as they can
+   while the model samples it once per gate, like a frequency counter:
+
+   gate(pulses &p) =
+     loop
+       after GATE p <- sample
+       wait p
+       print(p.delta / GATE)
+
+   Only one instant runs per gate however fast the edges arrive.  At the
+   end, the edges the model saw plus any not yet sampled must equal the
+   edges the producers counted.
+
+   Usage: pulses-bench [gates] [gate in ms] [producers]
+*/
+
+ssm_pulses_t pulses;
+ssm_time_t gate;
+long gates;
+bool quitting;
+
+typedef struct {
+  SSM_ACT_FIELDS;
+  ssm_trigger_t trigger;
+  long remaining;
+} gate_act_t;
+
+ssm_stepf_t step_gate;
+
+void step_gate(ssm_act_t *sact)
+{
+  gate_act_t *act = (gate_act_t *) sact;
+  switch (act->pc) {
+  case 0:
+    ssm_sensitize(&pulses.sv, &act->trigger);
+    for ( ; act->remaining > 0 ; act->remaining--) {
+      ssm_later_pulses(&pulses, ssm_now() + gate);
+      act->pc = 1;
+      return;
+    case 1:
+      printf("%8.3f s: %12.0f edges/s\n", (double) ssm_now() / SSM_SECOND,
+	     (double) pulses.delta * SSM_SECOND / gate);
+    }
+  }
+  ssm_desensitize(&act->trigger);
+  ssm_rt_stop();
+  ssm_leave(sact, sizeof(gate_act_t));
+}
+
+void *producer(void *arg)
+{
+  uint64_t *edges = arg;
+  while (!__atomic_load_n(&quitting, __ATOMIC_RELAXED)) {
+    for (int i = 0 ; i < 1000 ; i++)
+      ssm_pulses_add(&pulses, 1);
+    *edges += 1000;
+  }
+  return 0;
+}
+
+int main(int argc, char *argv[])
+{
+  gates = argc > 1 ? atol(argv[1]) : 10;
+  gate = (argc > 2 ? atol(argv[2]) : 100) * SSM_MILLISECOND;
+  int producers = argc > 3 ? atoi(argv[3]) : 2;
+  if (producers < 1 || producers > 64) {
+    fprintf(stderr, "producers must be between 1 and 64\n");
+    return 1;
+  }
+
+  if (ssm_rt_init() < 0) {
+    perror("ssm_rt_init");
+    return 1;
+  }
+  ssm_reset();
+  ssm_initialize_pulses(&pulses);
+  gate_act_t *act = (gate_act_t *)
+    ssm_enter(sizeof(gate_act_t), step_gate, &ssm_top_parent,
+	      SSM_ROOT_PRIORITY, SSM_ROOT_DEPTH);
+  act->trigger.act = (ssm_act_t *) act;
+  act->remaining = gates;
+  ssm_activate((ssm_act_t *) act);
+
+  pthread_t threads[64];
+  uint64_t edges[64] = { 0 };
+  for (int i = 0 ; i < producers ; i++)
+    if (pthread_create(&threads[i], 0, producer, &edges[i])) {
+      perror("pthread_create");
+      return 1;
+    }
+
+  ssm_tick();
+  ssm_rt_run(SSM_NEVER);
+
+  __atomic_store_n(&quitting, true, __ATOMIC_RELAXED);
+  uint64_t produced = 0;
+  for (int i = 0 ; i < producers ; i++) {
+    pthread_join(threads[i], 0);
+    produced += edges[i];
+  }
+
+  uint64_t seen = pulses.value + (u32) (pulses.count - pulses.sampled);
+  printf("%lu edges in %lu instants, %lu edges per instant\n",
+	 (unsigned long) produced, (unsigned long) ssm_rt_stats().instants,
+	 (unsigned long) (pulses.value / ssm_rt_stats().instants));
+  ssm_rt_close();
+  if (seen != produced) {
+    fprintf(stderr, "counted %lu edges but produced %lu\n",
+	    (unsigned long) seen, (unsigned long) produced);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,207 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "ssm.h"
+#include "ssm-linux.h"
+
+/* Measure the lateness of the real-time driver
+
+   A periodic routine wakes every period of model time while a child
+   process writes a byte to a pipe at its own pace; each byte becomes an
+   event on the input variable, which a second routine counts.
+
+   tick(event &timer) =
+     loop
+       after PERIOD timer <- Event
+       wait timer
+
+   count(event &input) =
+     loop
+       wait input
+       inputs = inputs + 1
+
+   The model runs twice: first sleeping until each instant, then waking
+   a margin early and spinning, with memory locked and, if a processor is
+   given, pinned to it under SCHED_FIFO.  Each run prints a histogram of
+   lateness.
+
+   Usage: rt-bench [instants] [period in us] [spin margin in us] [cpu]
+*/
+
+#define INPUT_SPACING_US 7000
+
+long inputs;
+ssm_time_t period;
+ssm_time_t *lateness;
+long measured, capacity;
+
+typedef struct {
+  SSM_ACT_FIELDS;
+  ssm_trigger_t trigger;
+  ssm_event_t *var;
+} loop_act_t;
+
+ssm_stepf_t step_tick, step_count;
+
+loop_act_t *enter_loop(ssm_act_t *parent, ssm_priority_t priority,
+		       ssm_depth_t depth, ssm_stepf_t *step, ssm_event_t *var)
+{
+  loop_act_t *act = (loop_act_t *)
+    ssm_enter(sizeof(loop_act_t), step, parent, priority, depth);
+  act->var = var;
+  act->trigger.act = (ssm_act_t *) act;
+  return act;
+}
+
+void step_tick(ssm_act_t *sact)
+{
+  loop_act_t *act = (loop_act_t *) sact;
+  switch (act->pc) {
+  case 0:
+    ssm_sensitize(&act->var->sv, &act->trigger);
+    for (;;) {
+      ssm_later_event(act->var, ssm_now() + period);
+      act->pc = 1;
+      return;
+    case 1:
+      ;
+    }
+  }
+}
+
+void step_count(ssm_act_t *sact)
+{
+  loop_act_t *act = (loop_act_t *) sact;
+  switch (act->pc) {
+  case 0:
+    ssm_sensitize(&act->var->sv, &act->trigger);
+    act->pc = 1;
+    return;
+  case 1:
+    inputs++;
+    return;
+  }
+}
+
+ssm_event_t timer, input;
+
+void read_input(int fd, void *data)
+{
+  char c;
+  if (read(fd, &c, 1) == 1)
+    ssm_later_event(&input, ssm_rt_input_time());
+  else
+    ssm_rt_remove_input(fd); // Writer went away
+}
+
+void record_lateness(ssm_time_t instant, ssm_time_t late)
+{
+  if (measured < capacity) lateness[measured++] = late;
+}
+
+int compare_times(const void *a, const void *b)
+{
+  ssm_time_t x = *(const ssm_time_t *) a, y = *(const ssm_time_t *) b;
+  return x < y ? -1 : x > y;
+}
+
+/** Print how many instants were late by less than 1, 2, 4, ... us */
+void print_histogram(void)
+{
+  int bucket = 0;
+  long i = 0;
+  while (i < measured) {
+    ssm_time_t bound = (ssm_time_t) SSM_MICROSECOND << bucket;
+    long count = 0;
+    for ( ; i < measured && lateness[i] < bound ; i++) count++;
+    if (count)
+      printf("  < %6lu us: %6ld %5.1f%%\n", (unsigned long) 1 << bucket,
+	     count, 100.0 * count / measured);
+    bucket++;
+  }
+}
+
+/** Run the model for a number of instants; wake `margin` early and spin */
+void run_mode(const char *name, long instants, ssm_time_t margin)
+{
+  int fds[2];
+  if (pipe(fds) < 0) {
+    perror("pipe");
+    exit(1);
+  }
+  fflush(stdout);
+  pid_t child = fork();
+  if (child == 0) {
+    close(fds[0]);
+    long writes = instants * period / (INPUT_SPACING_US * SSM_MICROSECOND);
+    for (long i = 0 ; i < writes ; i++) {
+      usleep(INPUT_SPACING_US);
+      if (write(fds[1], "x", 1) != 1) _exit(1);
+    }
+    _exit(0);
+  }
+  close(fds[1]);
+
+  if (ssm_rt_init() < 0 || ssm_rt_add_input(fds[0], read_input, 0) < 0) {
+    perror("ssm_rt_init");
+    exit(1);
+  }
+  ssm_rt_set_lateness_handler(record_lateness);
+  ssm_rt_set_spin(margin);
+  measured = 0;
+  inputs = 0;
+
+  ssm_reset();
+  ssm_initialize_event(&timer);
+  ssm_initialize_event(&input);
+  ssm_depth_t new_depth = SSM_ROOT_DEPTH - 1;
+  ssm_priority_t pinc = 1 << new_depth;
+  ssm_activate((ssm_act_t *) enter_loop(&ssm_top_parent, SSM_ROOT_PRIORITY,
+					new_depth, step_tick, &timer));
+  ssm_activate((ssm_act_t *) enter_loop(&ssm_top_parent,
+					SSM_ROOT_PRIORITY + pinc, new_depth,
+					step_count, &input));
+  ssm_tick();
+  ssm_rt_run(instants * period);
+  waitpid(child, 0, 0);
+  close(fds[0]);
+
+  ssm_rt_stats_t stats = ssm_rt_stats();
+  qsort(lateness, measured, sizeof(ssm_time_t), compare_times);
+  printf("%s: %lu instants, %ld inputs in %.3f s\n", name,
+	 (unsigned long) stats.instants, inputs,
+	 (double) ssm_rt_wall_time() / SSM_SECOND);
+  if (measured) {
+    printf("lateness: mean %.1f us, median %.1f us, 99%% %.1f us, "
+	   "max %.1f us\n",
+	   (double) stats.total / stats.instants / SSM_MICROSECOND,
+	   (double) lateness[measured / 2] / SSM_MICROSECOND,
+	   (double) lateness[measured * 99 / 100] / SSM_MICROSECOND,
+	   (double) stats.max / SSM_MICROSECOND);
+    print_histogram();
+  }
+  ssm_rt_close();
+}
+
+int main(int argc, char *argv[])
+{
+  long instants = argc > 1 ? atol(argv[1]) : 2000;
+  period = (argc > 2 ? atol(argv[2]) : 1000) * SSM_MICROSECOND;
+  ssm_time_t margin = (argc > 3 ? atol(argv[3]) : 200) * SSM_MICROSECOND;
+  int cpu = argc > 4 ? atoi(argv[4]) : -1;
+  capacity = 2 * instants;
+  if (!(lateness = malloc(capacity * sizeof(ssm_time_t)))) {
+    perror("malloc");
+    return 1;
+  }
+
+  run_mode("sleep", instants, 0);
+
+  if (ssm_rt_realtime(cpu, cpu >= 0 ? 50 : 0) < 0)
+    perror("ssm_rt_realtime"); // Carry on without it
+  run_mode("spin", instants, margin);
+  return 0;
+}
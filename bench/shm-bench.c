@@ -0,0 +1,234 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "ssm.h"
+#include "ssm-linux.h"
+
+/* Benchmark the cross-process path of the shared-memory transport
+
+   Two partitions run in separate processes.
+
+   In the latency test, they bounce a counter back and forth: each
+   partition sends the counter plus one back with the minimum delay, so
+   every hop crosses the rings and waits for a channel clock.
+
+   In the throughput test, partition 0 streams batches of updates to
+   partition 1, which counts them.
+
+   Usage: shm-bench [round trips] [streamed messages]
+*/
+
+#define LOOKAHEAD 1
+#define BATCH 64
+#define CAPACITY 4096
+
+enum { ECHO_VAR, SINK_VAR };
+
+ssm_shm_t *shm;
+unsigned peer;
+i64 limit;
+i64 received;
+bool replying;
+
+/* echo(i64 &in) =
+ * loop
+ *   wait in
+ *   received = received + 1
+ *   if replying && in < limit then send (in + 1) to the peer's in after LOOKAHEAD
+ */
+typedef struct {
+  SSM_ACT_FIELDS;
+  ssm_trigger_t trigger;
+  ssm_i64_t *in;
+} echo_act_t;
+
+ssm_stepf_t step_echo;
+
+echo_act_t *enter_echo(ssm_act_t *parent, ssm_priority_t priority,
+		       ssm_depth_t depth, ssm_i64_t *in)
+{
+  echo_act_t *act = (echo_act_t *)
+    ssm_enter(sizeof(echo_act_t), step_echo, parent, priority, depth);
+  act->in = in;
+  act->trigger.act = (ssm_act_t *) act;
+  return act;
+}
+
+void step_echo(ssm_act_t *sact)
+{
+  echo_act_t *act = (echo_act_t *) sact;
+  switch (act->pc) {
+  case 0:
+    ssm_sensitize(&act->in->sv, &act->trigger);
+    act->pc = 1;
+    return;
+  case 1:
+    received++;
+    if (replying && act->in->value < limit) {
+      i64 next = act->in->value + 1;
+      ssm_shm_send(shm, peer, ECHO_VAR, ssm_now() + LOOKAHEAD,
+		   &next, sizeof(next));
+    }
+    return;
+  }
+}
+
+/* source() =
+ * loop
+ *   for i in 0 .. BATCH-1: send i to the peer's sink after LOOKAHEAD + i
+ *   after BATCH timer <- Event
+ *   wait timer
+ */
+typedef struct {
+  SSM_ACT_FIELDS;
+  ssm_trigger_t trigger;
+  ssm_event_t timer;
+  i64 sent;
+} source_act_t;
+
+ssm_stepf_t step_source;
+
+source_act_t *enter_source(ssm_act_t *parent, ssm_priority_t priority,
+			   ssm_depth_t depth)
+{
+  source_act_t *act = (source_act_t *)
+    ssm_enter(sizeof(source_act_t), step_source, parent, priority, depth);
+  ssm_initialize_event(&act->timer);
+  act->sent = 0;
+  act->trigger.act = (ssm_act_t *) act;
+  return act;
+}
+
+void step_source(ssm_act_t *sact)
+{
+  source_act_t *act = (source_act_t *) sact;
+  switch (act->pc) {
+  case 0:
+    ssm_sensitize(&act->timer.sv, &act->trigger);
+    act->pc = 1;
+    /* Fall through */
+  case 1:
+    for (i64 i = 0 ; i < BATCH && act->sent < limit ; i++, act->sent++)
+      ssm_shm_send(shm, peer, SINK_VAR, ssm_now() + LOOKAHEAD + i,
+		   &i, sizeof(i));
+    if (act->sent < limit)
+      ssm_later_event(&act->timer, ssm_now() + BATCH);
+    return;
+  }
+}
+
+ssm_i64_t echo_in, sink_in;
+
+double seconds_since(struct timespec *start)
+{
+  struct timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  return (end.tv_sec - start->tv_sec) + (end.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+/** Run one partition of a test in this process */
+void run_partition(const char *name, unsigned self, bool stream,
+		   ssm_time_t stop)
+{
+  if (!(shm = ssm_shm_attach(name, self))) {
+    perror("ssm_shm_attach");
+    exit(1);
+  }
+  peer = 1 - self;
+  received = 0;
+  replying = !stream;
+  ssm_reset();
+
+  ssm_initialize_i64(&echo_in);
+  ssm_initialize_i64(&sink_in);
+  ssm_shm_bind(shm, ECHO_VAR, &echo_in.sv, ssm_deliver_i64);
+  ssm_shm_bind(shm, SINK_VAR, &sink_in.sv, ssm_deliver_i64);
+
+  ssm_depth_t new_depth = SSM_ROOT_DEPTH - 1;
+  ssm_priority_t pinc = 1 << new_depth;
+  ssm_activate((ssm_act_t *) enter_echo(&ssm_top_parent, SSM_ROOT_PRIORITY,
+					new_depth,
+					stream ? &sink_in : &echo_in));
+  if (stream && self == 0)
+    ssm_activate((ssm_act_t *) enter_source(&ssm_top_parent,
+					    SSM_ROOT_PRIORITY + pinc,
+					    new_depth));
+  ssm_tick();
+
+  if (!stream && self == 0) {
+    i64 first = 0;
+    ssm_shm_send(shm, peer, ECHO_VAR, LOOKAHEAD, &first, sizeof(first));
+  }
+
+  ssm_shm_run(shm, stop);
+  ssm_shm_detach(shm);
+}
+
+/** Run a two-partition test; return seconds taken and messages received */
+double run_test(bool stream, ssm_time_t stop, i64 *count)
+{
+  char name[64];
+  snprintf(name, sizeof(name), "/ssm-bench-%d", (int) getpid());
+  ssm_shm_t *seg = ssm_shm_create(name, 2, CAPACITY);
+  if (!seg) {
+    perror("ssm_shm_create");
+    exit(1);
+  }
+  ssm_shm_set_lookahead(seg, 0, 1, LOOKAHEAD);
+  ssm_shm_set_lookahead(seg, 1, 0, LOOKAHEAD);
+
+  int fds[2];
+  if (pipe(fds) < 0) {
+    perror("pipe");
+    exit(1);
+  }
+
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  fflush(stdout); // Don't let the child print our buffered output
+  pid_t child = fork();
+  if (child == 0) {
+    run_partition(name, 1, stream, stop);
+    if (write(fds[1], &received, sizeof(received)) != sizeof(received))
+      exit(1);
+    exit(0);
+  }
+  run_partition(name, 0, stream, stop);
+  double elapsed = seconds_since(&start);
+
+  i64 child_received = 0;
+  if (read(fds[0], &child_received, sizeof(child_received)) !=
+      sizeof(child_received))
+    child_received = -1;
+  waitpid(child, 0, 0);
+  close(fds[0]);
+  close(fds[1]);
+
+  *count = received + child_received;
+  ssm_shm_detach(seg);
+  ssm_shm_unlink(name);
+  return elapsed;
+}
+
+int main(int argc, char *argv[])
+{
+  i64 round_trips = argc > 1 ? atol(argv[1]) : 100000;
+  i64 messages = argc > 2 ? atol(argv[2]) : 1000000;
+  i64 count;
+
+  limit = 2 * round_trips;
+  double t = run_test(false, (limit + 2) * LOOKAHEAD, &count);
+  printf("latency: %ld hops in %.3f s: %.0f ns per hop\n",
+	 (long) count, t, t * 1e9 / count);
+
+  limit = messages;
+  t = run_test(true, messages + LOOKAHEAD + BATCH, &count);
+  printf("throughput: %ld messages in %.3f s: %.0f messages per second\n",
+	 (long) count, t, count / t);
+
+  return 0;
+}
@@ -0,0 +1,186 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "ssm.h"
+
+/* Measure running many identical routines woken in the same instant with
+   and without a group step function
+
+   main =
+     var clk : event
+     par clock(clk)
+         acc(clk, 1, q[0])
+         ...
+         acc(clk, n, q[n-1])
+
+   clock(event &clk) =
+     loop
+       after 1 ms clk <- Event
+       wait clk
+
+   acc(event &clk, u64 inc, u64 &q) =
+     loop
+       wait clk
+       q <- q + inc
+
+   Groups only run as such when the library and the bench are compiled
+   with -DSSM_STEPV.
+
+   Usage: stepv-bench [accumulators] [instants]
+*/
+
+typedef struct {
+  SSM_ACT_FIELDS;
+  ssm_trigger_t trigger;
+  ssm_event_t *clk;
+} clock_act_t;
+
+ssm_stepf_t step_clock;
+
+clock_act_t *enter_clock(ssm_act_t *parent, ssm_priority_t priority,
+			 ssm_depth_t depth, ssm_event_t *clk)
+{
+  clock_act_t *act = (clock_act_t *)
+    ssm_enter(sizeof(clock_act_t), step_clock, parent, priority, depth);
+  act->clk = clk;
+  act->trigger.act = (ssm_act_t *) act;
+  return act;
+}
+
+void step_clock(ssm_act_t *sact)
+{
+  clock_act_t *act = (clock_act_t *) sact;
+  switch (act->pc) {
+  case 0:
+    ssm_sensitize(&act->clk->sv, &act->trigger);
+    for (;;) {
+      ssm_later_event(act->clk, ssm_now() + SSM_MILLISECOND);
+      act->pc = 1;
+      return;
+    case 1:
+      ;
+    }
+  }
+}
+
+typedef struct {
+  SSM_ACT_FIELDS;
+  ssm_trigger_t trigger;
+  ssm_event_t *clk;
+  u64 inc;
+  ssm_u64_t *q;
+} acc_act_t;
+
+ssm_stepf_t step_acc;
+
+acc_act_t *enter_acc(ssm_act_t *parent, ssm_priority_t priority,
+		     ssm_depth_t depth, ssm_event_t *clk, u64 inc,
+		     ssm_u64_t *q)
+{
+  acc_act_t *act = (acc_act_t *)
+    ssm_enter(sizeof(acc_act_t), step_acc, parent, priority, depth);
+  act->clk = clk;
+  act->inc = inc;
+  act->q = q;
+  act->trigger.act = (ssm_act_t *) act;
+  return act;
+}
+
+void step_acc(ssm_act_t *sact)
+{
+  acc_act_t *act = (acc_act_t *) sact;
+  switch (act->pc) {
+  case 0:
+    ssm_sensitize(&act->clk->sv, &act->trigger);
+    act->pc = 1;
+    return;
+  case 1:
+    ssm_assign_u64(act->q, act->priority, act->q->value + act->inc);
+    return;
+  }
+}
+
+#ifdef SSM_STEPV
+/* Nothing is sensitive to q, so the accumulators never activate each other
+   and the assignments reduce to stores */
+void stepv_acc(ssm_act_t **acts, size_t count)
+{
+  for (size_t i = 0 ; i < count ; i++) {
+    acc_act_t *act = (acc_act_t *) acts[i];
+    if (act->pc != 1) {
+      step_acc(acts[i]);
+      continue;
+    }
+    act->q->value += act->inc;
+    act->q->sv.last_updated = ssm_now();
+  }
+}
+#endif
+
+long accs;
+long instants;
+ssm_event_t clk;
+ssm_u64_t *q;
+
+/** Run the model; return the seconds taken and the sum of the q's */
+double run(u64 *sum, bool grouped)
+{
+  ssm_reset();
+#ifdef SSM_STEPV
+  if (grouped) ssm_register_stepv(step_acc, stepv_acc);
+#endif
+  ssm_initialize_event(&clk);
+  for (long i = 0 ; i < accs ; i++) {
+    ssm_initialize_u64(&q[i]);
+    q[i].value = 0;
+  }
+
+  /* Give every routine a distinct priority under one parent */
+  ssm_depth_t depth = SSM_ROOT_DEPTH - 1;
+  while ((1L << (SSM_ROOT_DEPTH - depth)) <= accs) depth--;
+  ssm_activate((ssm_act_t *) enter_clock(&ssm_top_parent, SSM_ROOT_PRIORITY,
+					 depth, &clk));
+  for (long i = 0 ; i < accs ; i++)
+    ssm_activate((ssm_act_t *)
+		 enter_acc(&ssm_top_parent,
+			   SSM_ROOT_PRIORITY + ((ssm_priority_t) (i + 1) << depth),
+			   depth, &clk, i + 1, &q[i]));
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  ssm_tick();
+  for (long n = 1 ; n < instants ; n++)
+    ssm_tick();
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  *sum = 0;
+  for (long i = 0 ; i < accs ; i++)
+    *sum += q[i].value;
+  return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
+}
+
+int main(int argc, char *argv[])
+{
+  accs = argc > 1 ? atol(argv[1]) : 1000;
+  instants = argc > 2 ? atol(argv[2]) : 10000;
+  if (!(q = malloc(accs * sizeof(ssm_u64_t)))) {
+    perror("malloc");
+    return 1;
+  }
+
+  u64 single_sum, group_sum;
+  double single = run(&single_sum, false);
+  double group = run(&group_sum, true);
+
+  double steps = (double) accs * instants;
+  printf("one at a time: %ld routines for %ld instants in %.3f s: "
+	 "%.1f ns per step\n", accs, instants, single, single * 1e9 / steps);
+  printf("grouped: %ld routines for %ld instants in %.3f s: "
+	 "%.1f ns per step\n", accs, instants, group, group * 1e9 / steps);
+#ifndef SSM_STEPV
+  printf("grouped: compiled without -DSSM_STEPV, so run one at a time\n");
+#endif
+  printf(single_sum == group_sum ? "results match\n" : "results differ\n");
+  return single_sum != group_sum;
+}
@@ -0,0 +1,150 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include "ssm.h"
+#include "ssm-linux.h"
+
+/* Drive a model from large recorded stimulus files
+
+   Writes several stimulus files of presorted records, each updating its
+   own set of variables at irregular times, then merges them into a model
+   in which a routine per variable adds every value it sees:
+
+   watch(i64 &v) =
+     loop
+       wait v
+       sum = sum + v
+
+   Only the records due next are ever in the event queue, so memory use
+   does not grow with the length of the trace.  The sum must match the
+   sum of the payloads written.
+
+   Usage: stimulus-bench [records per stream] [streams] [variables per stream]
+*/
+
+long records;
+int streams, vars;
+uint64_t sum;
+
+typedef struct {
+  SSM_ACT_FIELDS;
+  ssm_trigger_t trigger;
+  ssm_i64_t *var;
+} watch_act_t;
+
+ssm_stepf_t step_watch;
+
+void step_watch(ssm_act_t *sact)
+{
+  watch_act_t *act = (watch_act_t *) sact;
+  switch (act->pc) {
+  case 0:
+    ssm_sensitize(&act->var->sv, &act->trigger);
+    act->pc = 1;
+    return;
+  case 1:
+    sum += act->var->value;
+    return;
+  }
+}
+
+/** Write a stream of records and return the sum of their payloads */
+uint64_t write_stream(const char *path, int stream)
+{
+  FILE *f = fopen(path, "w");
+  if (!f) {
+    perror(path);
+    exit(1);
+  }
+  uint64_t total = 0;
+  ssm_time_t t = 0;
+  unsigned seed = stream + 1;
+  for (long i = 0 ; i < records ; i++) {
+    t += 1 + rand_r(&seed) % 1000;
+    ssm_stimulus_record_t r = {
+      .time = t,
+      .id = stream * vars + i % vars,
+      .payload = rand_r(&seed)
+    };
+    total += r.payload;
+    if (fwrite(&r, sizeof(r), 1, f) != 1) {
+      perror(path);
+      exit(1);
+    }
+  }
+  fclose(f);
+  return total;
+}
+
+int main(int argc, char *argv[])
+{
+  records = argc > 1 ? atol(argv[1]) : 1000000;
+  streams = argc > 2 ? atoi(argv[2]) : 4;
+  vars = argc > 3 ? atoi(argv[3]) : 4;
+  if (streams < 1 || streams > SSM_STIMULUS_MAX_STREAMS || vars < 1) {
+    fprintf(stderr, "need 1 to %d streams and at least 1 variable\n",
+	    SSM_STIMULUS_MAX_STREAMS);
+    return 1;
+  }
+
+  uint64_t expected = 0;
+  char paths[SSM_STIMULUS_MAX_STREAMS][64];
+  for (int s = 0 ; s < streams ; s++) {
+    snprintf(paths[s], sizeof(paths[s]), "/tmp/stimulus-bench-%d-%d",
+	     (int) getpid(), s);
+    expected += write_stream(paths[s], s);
+  }
+
+  ssm_reset();
+  ssm_i64_t *values = calloc(streams * vars, sizeof(ssm_i64_t));
+  ssm_depth_t depth = SSM_ROOT_DEPTH - 10;
+  for (int i = 0 ; i < streams * vars ; i++) {
+    ssm_initialize_i64(&values[i]);
+    watch_act_t *act = (watch_act_t *)
+      ssm_enter(sizeof(watch_act_t), step_watch, &ssm_top_parent,
+		SSM_ROOT_PRIORITY + ((ssm_priority_t) i << depth), depth);
+    act->trigger.act = (ssm_act_t *) act;
+    act->var = &values[i];
+    ssm_activate((ssm_act_t *) act);
+    ssm_stimulus_bind(i, &values[i].sv, ssm_deliver_i64);
+  }
+  for (int s = 0 ; s < streams ; s++)
+    if (ssm_stimulus_open(paths[s]) < 0) {
+      perror(paths[s]);
+      return 1;
+    }
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  long instants = 0;
+  ssm_tick();
+  for (;;) {
+    ssm_stimulus_feed();
+    if (ssm_next_event_time() == SSM_NEVER) break;
+    ssm_tick();
+    instants++;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  ssm_stimulus_close();
+  for (int s = 0 ; s < streams ; s++) unlink(paths[s]);
+
+  double seconds = (end.tv_sec - start.tv_sec) +
+    (end.tv_nsec - start.tv_nsec) * 1e-9;
+  long total = records * streams;
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  printf("%ld records in %ld instants, %.3f s, %.0f records/s, "
+	 "%.1f MB/s, max RSS %ld KB\n", total, instants, seconds,
+	 total / seconds,
+	 total * sizeof(ssm_stimulus_record_t) / seconds / 1e6,
+	 usage.ru_maxrss);
+  if (sum != expected) {
+    fprintf(stderr, "sum %lu should be %lu\n", (unsigned long) sum,
+	    (unsigned long) expected);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,206 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "ssm.h"
+#include "ssm-linux.h"
+
+/* Measure asynchronous file I/O through io_uring
+
+   Several routines each write a run of blocks to a temporary file and
+   read every one back, waiting on the result variable of each operation
+   and checking the data.
+
+   copy(i64 &result, int first) =
+     for block = first .. first + BLOCKS
+       write(block) -> result
+       wait result
+       read(block) -> result
+       wait result
+       check(block)
+
+   The routines run as plain operations, with registered buffers, with
+   a kernel submission thread, and with the submissions made on the I/O
+   thread (ssm_output_sink()) while the tick thread keeps queuing; each
+   run reports operations per second.  A run fails if any operation has
+   not completed after ten seconds.
+
+   Usage: uring-bench [blocks per routine] [routines]
+*/
+
+#define BLOCK_SIZE 4096
+
+long blocks;
+int routines, running;
+unsigned char *buffers;        // A write and a read buffer per routine
+bool fixed;
+int file;
+
+void timeout(int sig) { ssm_rt_stop(); }
+
+typedef struct {
+  SSM_ACT_FIELDS;
+  ssm_trigger_t trigger;
+  ssm_i64_t result;
+  long block;
+  long last;
+  unsigned char *out, *in;
+} copy_act_t;
+
+ssm_stepf_t step_copy;
+
+copy_act_t *enter_copy(ssm_act_t *parent, ssm_priority_t priority,
+		       ssm_depth_t depth, int routine)
+{
+  copy_act_t *act = (copy_act_t *)
+    ssm_enter(sizeof(copy_act_t), step_copy, parent, priority, depth);
+  ssm_initialize_i64(&act->result);
+  act->trigger.act = (ssm_act_t *) act;
+  act->block = routine * blocks;
+  act->last = act->block + blocks;
+  act->out = buffers + 2 * routine * BLOCK_SIZE;
+  act->in = act->out + BLOCK_SIZE;
+  return act;
+}
+
+void fail(const char *what, long block)
+{
+  fprintf(stderr, "%s failed on block %ld\n", what, block);
+  exit(1);
+}
+
+void step_copy(ssm_act_t *sact)
+{
+  copy_act_t *act = (copy_act_t *) sact;
+  switch (act->pc) {
+  case 0:
+    ssm_sensitize(&act->result.sv, &act->trigger);
+    for ( ; act->block < act->last ; act->block++) {
+      memset(act->out, (int) act->block, BLOCK_SIZE);
+      if (!(fixed
+	    ? ssm_uring_write_fixed(file, 0, act->out, BLOCK_SIZE,
+				    act->block * BLOCK_SIZE, &act->result)
+	    : ssm_uring_write(file, act->out, BLOCK_SIZE,
+			      act->block * BLOCK_SIZE, &act->result)))
+	fail("queueing write", act->block);
+      act->pc = 1;
+      return;
+    case 1:
+      if (act->result.value != BLOCK_SIZE) fail("write", act->block);
+
+      memset(act->in, 0, BLOCK_SIZE);
+      if (!(fixed
+	    ? ssm_uring_read_fixed(file, 0, act->in, BLOCK_SIZE,
+				   act->block * BLOCK_SIZE, &act->result)
+	    : ssm_uring_read(file, act->in, BLOCK_SIZE,
+			     act->block * BLOCK_SIZE, &act->result)))
+	fail("queueing read", act->block);
+      act->pc = 2;
+      return;
+    case 2:
+      if (act->result.value != BLOCK_SIZE ||
+	  memcmp(act->in, act->out, BLOCK_SIZE))
+	fail("read", act->block);
+    }
+  }
+  ssm_desensitize(&act->trigger);
+  if (--running == 0) ssm_rt_stop();
+  ssm_leave(sact, sizeof(copy_act_t));
+}
+
+void run_mode(const char *name, bool sqpoll, bool use_fixed, bool io_thread)
+{
+  char path[] = "/tmp/uring-benchXXXXXX";
+  if ((file = mkstemp(path)) < 0) {
+    perror("mkstemp");
+    exit(1);
+  }
+  unlink(path);
+
+  if (ssm_rt_init() < 0) {
+    perror("ssm_rt_init");
+    exit(1);
+  }
+  if (ssm_uring_init(2 * routines, sqpoll) < 0) {
+    perror("ssm_uring_init");
+    printf("%s: skipped\n", name);
+    ssm_rt_close();
+    close(file);
+    return;
+  }
+  fixed = use_fixed;
+  if (fixed) {
+    struct iovec iov = { buffers, 2 * routines * BLOCK_SIZE };
+    if (ssm_uring_register_buffers(&iov, 1) < 0) {
+      perror("ssm_uring_register_buffers");
+      exit(1);
+    }
+  }
+
+  ssm_action_sinkf_t *sink = 0;
+  if (io_thread) {
+    if (ssm_output_start() < 0) {
+      perror("ssm_output_start");
+      exit(1);
+    }
+    sink = ssm_output_sink;
+  }
+  ssm_rt_set_action_sink(sink);
+
+  ssm_reset();
+  running = routines;
+  ssm_depth_t new_depth = SSM_ROOT_DEPTH - 8;
+  for (int i = 0 ; i < routines ; i++)
+    ssm_activate((ssm_act_t *)
+		 enter_copy(&ssm_top_parent, SSM_ROOT_PRIORITY + (i << new_depth),
+			    new_depth, i));
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  ssm_tick();
+  ssm_flush_actions(sink);
+  alarm(10);
+  ssm_rt_run(SSM_NEVER);
+  alarm(0);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  if (io_thread) ssm_output_stop();
+  if (running) {
+    fprintf(stderr, "%s: %d routines still waiting on operations\n", name,
+	    running);
+    exit(1);
+  }
+
+  double seconds = (end.tv_sec - start.tv_sec) +
+    (end.tv_nsec - start.tv_nsec) * 1e-9;
+  long ops = 2 * blocks * routines;
+  printf("%s: %ld operations in %.3f s, %.0f ops/s\n", name, ops, seconds,
+	 ops / seconds);
+
+  ssm_uring_close();
+  ssm_rt_close();
+  close(file);
+}
+
+int main(int argc, char *argv[])
+{
+  blocks = argc > 1 ? atol(argv[1]) : 2000;
+  routines = argc > 2 ? atoi(argv[2]) : 16;
+  if (routines < 1 || routines > 256) {
+    fprintf(stderr, "routines must be between 1 and 256\n");
+    return 1;
+  }
+  if (!(buffers = aligned_alloc(BLOCK_SIZE, 2 * routines * BLOCK_SIZE))) {
+    perror("aligned_alloc");
+    return 1;
+  }
+
+  signal(SIGALRM, timeout);
+  run_mode("plain", false, false, false);
+  run_mode("fixed", false, true, false);
+  run_mode("sqpoll", true, true, false);
+  run_mode("thread", false, false, true);
+  return 0;
+}
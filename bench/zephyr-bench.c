@@ -0,0 +1,188 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "ssm.h"
+#include "zephyr/zephyr.h"
+#include "zephyr/drivers/counter.h"
+
+/* Measure the Zephyr tick loop against the emulated counter and queue
+
+   The tick thread is the one from examples/blink-platformio-zephyr:
+   it runs an instant, sets a counter alarm for the next event, and
+   blocks on a message queue until the alarm's callback posts to it.
+   Model time is in counter ticks, as there.
+
+   Three periodic routines with different periods keep the alarm busy:
+
+   beat(event &timer, period) =
+     loop
+       work(load)
+       after period timer <- Event
+       wait timer
+
+   Each instant also spins for a given load, so with a large enough load
+   alarms are set after their time has passed and must expire late.  The
+   bench reports the cost of setting each alarm, how many were late, the
+   delay from expiry to callback, and the tick latency: from the time an
+   instant was due to the time its tick started.
+
+   Usage: zephyr-bench [instants] [period in us] [load in us]
+*/
+
+long load_us;
+uint32_t periods[3];
+
+typedef struct {
+  SSM_ACT_FIELDS;
+  ssm_trigger_t trigger;
+  ssm_event_t timer;
+  uint32_t period;
+} beat_act_t;
+
+ssm_stepf_t step_beat;
+
+void spin_us(long us)
+{
+  struct timespec start, now;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  do
+    clock_gettime(CLOCK_MONOTONIC, &now);
+  while ((now.tv_sec - start.tv_sec) * 1000000L +
+	 (now.tv_nsec - start.tv_nsec) / 1000 < us);
+}
+
+void step_beat(ssm_act_t *sact)
+{
+  beat_act_t *act = (beat_act_t *) sact;
+  switch (act->pc) {
+  case 0:
+    ssm_sensitize(&act->timer.sv, &act->trigger);
+    for (;;) {
+      ssm_later_event(&act->timer, ssm_now() + act->period);
+      act->pc = 1;
+      return;
+    case 1:
+      ;
+    }
+  }
+}
+
+const struct device *ssm_timer_dev = 0;
+struct counter_alarm_cfg ssm_timer_cfg;
+
+typedef enum { SSM_TIMEOUT } ssm_event_type_t;
+
+typedef struct {
+  ssm_event_type_t type;
+} ssm_env_event_t;
+
+K_MSGQ_DEFINE(ssm_env_queue, sizeof(ssm_env_event_t), 100, 1);
+
+void send_timeout_event(const struct device *dev, uint8_t chan, uint32_t ticks,
+			void *user_data)
+{
+  static ssm_env_event_t timeout_msg = { .type = SSM_TIMEOUT };
+
+  k_msgq_put(&ssm_env_queue, &timeout_msg, K_NO_WAIT);
+}
+
+long instants;
+uint64_t set_ns, late;
+uint64_t latency_total, latency_max; // In counter ticks
+
+uint64_t elapsed_ns(const struct timespec *start, const struct timespec *end)
+{
+  return (end->tv_sec - start->tv_sec) * 1000000000L +
+    end->tv_nsec - start->tv_nsec;
+}
+
+void ssm_tick_thread_body(void *p1, void *p2, void *p3)
+{
+  ssm_env_event_t msg;
+
+  for (long i = 0 ; i < instants ; i++) {
+    ssm_tick();
+    if (load_us) spin_us(load_us);
+
+    ssm_time_t wake = ssm_next_event_time();
+    if (wake != SSM_NEVER) {
+      ssm_timer_cfg.ticks = wake;
+      struct timespec start, end;
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      int r = counter_set_channel_alarm(ssm_timer_dev, 0, &ssm_timer_cfg);
+      clock_gettime(CLOCK_MONOTONIC, &end);
+      set_ns += elapsed_ns(&start, &end);
+      if (r == -ETIME)
+	late++;
+      else if (r)
+	printk("counter_set_channel_alarm failed: %d\n", r);
+    }
+
+    k_msgq_get(&ssm_env_queue, &msg, K_FOREVER); // Block for the next event
+
+    uint32_t now;
+    counter_get_value(ssm_timer_dev, &now);
+    uint32_t latency = now - (uint32_t) wake;
+    latency_total += latency;
+    if (latency > latency_max) latency_max = latency;
+  }
+}
+
+K_THREAD_STACK_DEFINE(ssm_tick_thread_stack, 4096);
+struct k_thread ssm_tick_thread;
+
+int main(int argc, char *argv[])
+{
+  instants = argc > 1 ? atol(argv[1]) : 3000;
+  long period_us = argc > 2 ? atol(argv[2]) : 1000;
+  load_us = argc > 3 ? atol(argv[3]) : 0;
+
+  if (!(ssm_timer_dev = device_get_binding("SSM_TIMER"))) {
+    fprintf(stderr, "device_get_binding failed\n");
+    return 1;
+  }
+  ssm_timer_cfg.flags = COUNTER_ALARM_CFG_ABSOLUTE |
+    COUNTER_ALARM_CFG_EXPIRE_WHEN_LATE;
+  ssm_timer_cfg.callback = send_timeout_event;
+  ssm_timer_cfg.user_data = &ssm_timer_cfg;
+  counter_set_guard_period(ssm_timer_dev, UINT32_MAX / 2,
+			   COUNTER_GUARD_PERIOD_LATE_TO_SET);
+  if (counter_start(ssm_timer_dev)) {
+    fprintf(stderr, "counter_start failed\n");
+    return 1;
+  }
+
+  uint32_t period = counter_us_to_ticks(ssm_timer_dev, period_us);
+  ssm_depth_t new_depth = SSM_ROOT_DEPTH - 2;
+  for (int i = 0 ; i < 3 ; i++) {
+    beat_act_t *act = (beat_act_t *)
+      ssm_enter(sizeof(beat_act_t), step_beat, &ssm_top_parent,
+		SSM_ROOT_PRIORITY + (i << new_depth), new_depth);
+    ssm_initialize_event(&act->timer);
+    act->trigger.act = (ssm_act_t *) act;
+    act->period = period + i * period / 3;
+    ssm_activate((ssm_act_t *) act);
+  }
+
+  k_thread_create(&ssm_tick_thread, ssm_tick_thread_stack,
+		  K_THREAD_STACK_SIZEOF(ssm_tick_thread_stack),
+		  ssm_tick_thread_body, 0, 0, 0, 7, 0, K_NO_WAIT);
+  k_thread_join(&ssm_tick_thread, K_FOREVER);
+
+  struct counter_emu_stats stats;
+  counter_emu_get_stats(ssm_timer_dev, &stats);
+  counter_stop(ssm_timer_dev);
+
+  double us_per_tick = 1e6 / counter_get_frequency(ssm_timer_dev);
+  printf("%ld instants, load %ld us\n", instants, load_us);
+  printf("alarm set: %.0f ns mean, %lu late, %lu busy\n",
+	 (double) set_ns / stats.set, (unsigned long) late,
+	 (unsigned long) stats.busy);
+  printf("alarm callback delay: %.1f us mean, %.1f us max\n",
+	 (double) stats.total_delay_ns / stats.fired / 1000,
+	 (double) stats.max_delay_ns / 1000);
+  printf("tick latency: %.1f us mean, %.1f us max\n",
+	 latency_total * us_per_tick / instants, latency_max * us_per_tick);
+  return 0;
+}
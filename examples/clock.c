@@ -85,6 +85,12 @@ void step_second_clock(struct ssm_act *cont)
   ssm_leave((struct ssm_act *) act, sizeof(act_second_clock_t));
 }
 
+/* Printing is deferred to the end of the instant */
+void print_seconds(void *data, uint64_t seconds)
+{
+  printf("%d\n", (int) seconds);
+}
+
 ssm_stepf_t step_report_seconds;
 
 act_report_seconds_t *
@@ -123,7 +129,7 @@ void step_report_seconds(struct ssm_act *cont)
       ssm_assign_i32(&act->seconds, act->priority,
 		 act->seconds.value + 1);
 
-      printf("%d\n", act->seconds.value);
+      ssm_defer(print_seconds, 0, act->seconds.value); // print(seconds)
     } // end of loop
   }
   ssm_leave((struct ssm_act *) act, sizeof(act_report_seconds_t));
@@ -185,9 +191,12 @@ int main(int argc, char *argv[])
   ssm_activate((struct ssm_act *) act);
 
   ssm_tick();
+  ssm_flush_actions(0);
 
-  while (ssm_next_event_time() != SSM_NEVER && ssm_now() < stop_at)
+  while (ssm_next_event_time() != SSM_NEVER && ssm_now() < stop_at) {
     ssm_tick();
+    ssm_flush_actions(0);
+  }
   
   printf("simulated %lu seconds\n", ssm_now() / SSM_SECOND);
   
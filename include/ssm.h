@@ -45,6 +45,7 @@ See [the detailed documentation](@ref all)
 #include <stdlib.h>   /* For size_t */
 #include <assert.h>
 #include <stddef.h>   /* For offsetof */
+#include <string.h>   /* For memcpy */
 
 /** \defgroup all The SSM Runtime
  * \addtogroup all
@@ -114,6 +115,20 @@ enum ssm_error_t {
   SSM_EXHAUSTED_PRIORITY,
   /** Invalid time, e.g., scheduled delayed assignment at an earlier time. */
   SSM_INVALID_TIME,
+  /** Tried to save more state than fits in the undo log. */
+  SSM_EXHAUSTED_UNDO_LOG,
+  /** Ensemble lanes diverged on a platform that cannot split contexts. */
+  SSM_DIVERGED_LANES,
+  /** Tried to register too many group step functions. */
+  SSM_EXHAUSTED_STEPV_TABLE,
+  /** Tried to queue too many deferred actions in one instant. */
+  SSM_EXHAUSTED_ACTION_QUEUE,
+  /** Too many variables changed in one instant to journal. */
+  SSM_EXHAUSTED_JOURNAL,
+  /** Tried to queue more pending values than a delay line holds. */
+  SSM_EXHAUSTED_DELAY_LINE,
+  /** Used a byte buffer while running speculatively. */
+  SSM_SPECULATIVE_BUFFER,
   /** Start of platform-specific error code range. */
   SSM_PLATFORM_ERROR
 };
@@ -146,6 +161,108 @@ typedef uint64_t ssm_time_t;
  */
 #define SSM_NEVER UINT64_MAX
 
+#ifdef SSM_OPTIMISTIC
+/** True while the runtime is logging state changes so they can be undone
+ *
+ * Only available when the library is compiled with SSM_OPTIMISTIC.
+ * Platform code sets this before running ahead speculatively; while it
+ * is false, SSM_SAVE() does nothing.
+ */
+extern bool ssm_optimistic;
+
+/** Record the current contents of memory so ssm_rollback() can restore it
+ *
+ * Invokes #SSM_THROW(#SSM_EXHAUSTED_UNDO_LOG) if the undo log is full.
+ */
+void ssm_save(void *addr, /**< Start of the memory about to be modified */
+	      size_t size /**< Number of bytes about to be modified */);
+
+/** A function that frees an activation record */
+typedef void ssm_act_freef_t(void *ptr, size_t size);
+
+/** Free an activation record with the #SSM_ACT_FREE the program uses
+ *
+ * Compiled where ssm.h is included, so ssm_rollback() and
+ * ssm_fossil_collect(), which are compiled in the library, free records
+ * the same way the program allocated them (e.g., with ssm_batch_free()).
+ */
+static inline void ssm_act_free(void *ptr, size_t size)
+{
+  SSM_ACT_FREE(ptr, size);
+}
+
+/** Remember an activation record allocated while running speculatively
+ *
+ * Called by ssm_enter(); ssm_rollback() frees the record with `freef` if
+ * it undoes the instant in which the record was allocated.
+ */
+void ssm_save_alloc(void *ptr, size_t size, ssm_act_freef_t *freef);
+
+/** Free an activation record, but not until its instant is committed
+ *
+ * Called by ssm_leave() instead of #SSM_ACT_FREE while running
+ * speculatively.  ssm_fossil_collect() frees the record with `freef` once
+ * the instant can no longer be rolled back; ssm_rollback() simply forgets
+ * the request.
+ */
+void ssm_defer_free(void *ptr, size_t size, ssm_act_freef_t *freef);
+
+/** Undo every instant at or after the given time
+ *
+ * Restores the scheduler, every scheduled variable, and every activation
+ * record header to their state just before the earliest logged instant
+ * whose time is no earlier than `time`.  Afterwards, ssm_now() is less
+ * than `time`, so an event that arrived late (a "straggler") may be
+ * scheduled with ssm_schedule() and the instants replayed with ssm_tick().
+ *
+ * Inputs delivered from outside the SSM program after the restored point
+ * are also undone; the platform must redeliver them.
+ */
+void ssm_rollback(ssm_time_t time);
+
+/** Commit every instant before the global virtual time
+ *
+ * Discards the undo log for instants earlier than `gvt`, which can no
+ * longer be rolled back, and performs their deferred frees.
+ */
+void ssm_fossil_collect(ssm_time_t gvt);
+
+/** Return the time of the earliest instant that may still be rolled back
+ *
+ * Returns #SSM_NEVER if every instant run so far is committed.
+ */
+ssm_time_t ssm_uncommitted_time(void);
+
+/** Save the contents of an lvalue before modifying it */
+#define SSM_SAVE(lvalue) \
+  do \
+    if (ssm_optimistic) \
+      ssm_save(&(lvalue), sizeof(lvalue)); \
+  while (0)
+
+/** Save `size` bytes at `addr` before modifying them */
+#define SSM_SAVE_BYTES(addr, size) \
+  do \
+    if (ssm_optimistic) \
+      ssm_save((addr), (size)); \
+  while (0)
+#else
+#define SSM_SAVE(lvalue) do ; while (0)
+#define SSM_SAVE_BYTES(addr, size) do ; while (0)
+#endif
+
+/** Copy a value, inlining the copy for the common scalar sizes */
+static inline void ssm_copy_value(void *dst, const void *src, size_t size)
+{
+  switch (size) {
+  case 1: memcpy(dst, src, 1); break;
+  case 2: memcpy(dst, src, 2); break;
+  case 4: memcpy(dst, src, 4); break;
+  case 8: memcpy(dst, src, 8); break;
+  default: memcpy(dst, src, size); break;
+  }
+}
+
 /** Thread priority.
  *
  *  Lower numbers execute first in an instant
@@ -233,8 +350,10 @@ typedef struct ssm_trigger {
  * with triggers.
  *
  * The update field must point to code that copies the new value of
- * the scheduled variable into its current value.  For pure events,
- * this function may do nothing, but the pointer must be non-zero.
+ * the scheduled variable into its current value and returns true.  It
+ * may instead return false if the value did not change, in which case
+ * the update is not an event.  For pure events, this function need only
+ * return true, but the pointer must be non-zero.
  *
  * This can also be embedded in a wrapper struct/class to implement a scheduled
  * variable with a payload. In this case, the payload should also be embedded
@@ -245,12 +364,49 @@ typedef struct ssm_trigger {
  * `later_time` != #SSM_NEVER if and only if this variable in the event queue.
  */
 typedef struct ssm_sv {
-  void (*update)(struct ssm_sv *); /**< Update "virtual method" */
+  bool (*update)(struct ssm_sv *); /**< Update "virtual method" */
   ssm_trigger_t *triggers;    /**< List of sensitive continuations */
   ssm_time_t later_time;       /**< When the variable should be next updated */
   ssm_time_t last_updated;     /**< When the variable was last updated */
 } ssm_sv_t;
 
+/** Update function of pure events, which has nothing to copy */
+bool ssm_update_event(ssm_sv_t *var);
+
+#ifdef SSM_JOURNAL
+/** Record that a variable changes in the current instant
+ *
+ * Only available when the library is compiled with SSM_JOURNAL.  Called
+ * through SSM_JOURNAL_MARK() just before a variable's last_updated time
+ * is set; invokes #SSM_THROW(#SSM_EXHAUSTED_JOURNAL) if the journal is
+ * full.
+ */
+void ssm_journal_mark(ssm_sv_t *var);
+
+/** Return the variables that changed in the latest instant
+ *
+ * Lists each variable updated by an event or assigned in the most recent
+ * instant once, in the order they first changed, so a platform can
+ * mirror outputs in time proportional to the number of changes.  Sets
+ * `*count` to the length of the list.  ssm_tick() starts a new list when
+ * it advances time.  Only available when the library is compiled with
+ * SSM_JOURNAL.
+ *
+ * Every variable is journaled; a platform that mirrors only some can keep
+ * them in one array and pick them out of the list by address.
+ */
+ssm_sv_t *const *ssm_journal(size_t *count);
+
+/** Journal a variable unless it already changed in this instant */
+#define SSM_JOURNAL_MARK(var) \
+  do \
+    if ((var)->last_updated != ssm_now()) \
+      ssm_journal_mark(var); \
+  while (0)
+#else
+#define SSM_JOURNAL_MARK(var) do ; while (0)
+#endif
+
 
 /** Indicate writing to a variable should trigger a routine
  *
@@ -282,6 +438,40 @@ extern void ssm_desensitize(ssm_trigger_t *);
  */
 extern void ssm_activate(ssm_act_t *);
 
+#ifdef SSM_STEPV
+/** The function that does an instant's work for a group of routines
+ *
+ * Given activation records that all have the same step function, in
+ * priority order, must have the same effect as calling that step
+ * function on each in turn.
+ */
+typedef void ssm_stepvf_t(ssm_act_t **acts, size_t count);
+
+/** Register a group step function for a routine's step function
+ *
+ * When the next records in the activation record queue share a step
+ * function that has a group step function, ssm_tick() removes up to
+ * #SSM_STEPV_SIZE of them and passes them to the group step function in
+ * one call instead of calling the step function on each.
+ *
+ * The records are removed together, so no routine they activate runs
+ * before the last of them.  Every record but the first stays scheduled
+ * until the group step function returns, so a member that wakes a later
+ * member does not make it run twice, but one that wakes an earlier member
+ * (other than the first) has no effect.  Only register a group step
+ * function for a routine that cannot activate one of a priority between
+ * two of its own records, or an earlier record of its own, in the same
+ * instant; e.g., one that only assigns variables read by later routines,
+ * or only schedules delayed assignments.
+ *
+ * Invokes #SSM_THROW(#SSM_EXHAUSTED_STEPV_TABLE) if too many group step
+ * functions are registered.  ssm_reset() forgets every registration.
+ * Only available when the library is compiled with SSM_STEPV, which
+ * reserves #SSM_STEPV_SIZE pointers for the group.
+ */
+void ssm_register_stepv(ssm_stepf_t *step, ssm_stepvf_t *stepv);
+#endif
+
 /**
  * Execute a routine immediately.
  */
@@ -305,9 +495,13 @@ static inline ssm_act_t *ssm_enter(size_t bytes, /**< size of the activation rec
   assert(bytes > 0);
   assert(step);
   assert(parent);
+  SSM_SAVE(parent->children);
   ++parent->children;
   ssm_act_t *act = (ssm_act_t *)SSM_ACT_MALLOC(bytes);
   if (!act) SSM_THROW(SSM_EXHAUSTED_MEMORY);
+#ifdef SSM_OPTIMISTIC
+  if (ssm_optimistic) ssm_save_alloc(act, bytes, ssm_act_free);
+#endif
   *act = (ssm_act_t){
       .step = step,
       .caller = parent,
@@ -328,12 +522,20 @@ static inline void ssm_leave(ssm_act_t *act, size_t bytes) {
   assert(act->caller);
   assert(act->caller->step);
   ssm_act_t *caller = act->caller;
+#ifdef SSM_OPTIMISTIC
+  if (ssm_optimistic)
+    ssm_defer_free(act, bytes, ssm_act_free); /* Keep the record in case we roll back */
+  else
+#endif
   SSM_ACT_FREE(act, bytes); /* Free the whole activation record, not just the start */
+  SSM_SAVE(caller->children);
   if ((--caller->children) == 0)
     ssm_call(caller); /* If we were the last child, run our parent */
 }
 
 /** Return true if there is an event on the given variable in the current instant
+ *
+ * Commits a lazy variable's pending value first; see ssm_resolve().
  */
 bool ssm_event_on(ssm_sv_t *var /**< Variable: must be non-NULL */ );
 
@@ -343,7 +545,7 @@ bool ssm_event_on(ssm_sv_t *var /**< Variable: must be non-NULL */ );
  * variable, e.g., after ssm_enter()
  */
 void ssm_initialize(ssm_sv_t *var,
-		    void (*update)(ssm_sv_t *));
+		    bool (*update)(ssm_sv_t *));
 
 /** Schedule a future update to a variable
  *
@@ -378,10 +580,19 @@ void ssm_trigger(ssm_sv_t *var, /**< Variable being assigned */
 
 /** Return the time of the next event in the queue or #SSM_NEVER
  *
+ * Also accounts for an instant requested with ssm_schedule_instant().
  * Typically used by the platform code that ultimately invokes ssm_tick().
  */
 ssm_time_t ssm_next_event_time(void);
 
+/** Make an instant occur at `then` even if no variable is scheduled then
+ *
+ * For platform code that must see time reach a lazy variable's pending
+ * update, which is never in the event queue.  `then` must be in the
+ * future; the earliest of several requests wins.
+ */
+void ssm_schedule_instant(ssm_time_t then);
+
 /** Return the current model time */
 ssm_time_t ssm_now(void);
 
@@ -403,9 +614,19 @@ void ssm_tick();
 
 /** Reset the scheduler.
  *
- *  Set now to 0; clear the event and activation record queues.  This
- *  does not need to be called before calling ssm_tick() for the first
- *  time; the global state automatically starts initialized.
+ *  Set now to 0; clear the event and activation record queues and forget
+ *  the children of #ssm_top_parent.  This does not need to be called
+ *  before calling ssm_tick() for the first time; the global state
+ *  automatically starts initialized.
+ *
+ *  Takes constant time: it neither frees activation records nor touches
+ *  variables that were still in the queues, so initialize every scheduled
+ *  variable again before using it after a reset.  With SSM_STEPV, it also
+ *  forgets every group step function registered with ssm_register_stepv().
+ *
+ *  State kept by other modules (ssm_reset_actions(), ssm_reset_input(),
+ *  ssm_reset_lanes()) is left alone, so programs that do not use those
+ *  modules do not link them.
  */
 void ssm_reset();
 
@@ -445,10 +666,23 @@ extern ssm_act_t ssm_top_parent;
   ((type *)((char *)(member_type(type, member) *){ptr} -                       \
             offsetof(type, member)))
 
+/** Schedule a future update of a variable to a payload of its type
+ *
+ * Used by platform code that delivers values from outside the SSM program
+ * (other processes, interrupt handlers, files) without knowing the type of
+ * the variable.  Each scheduled variable type provides one, named
+ * ssm_deliver_<type>(), that behaves like its ssm_later_<type>() function.
+ */
+typedef void ssm_deliverf_t(ssm_sv_t *var, /**< Variable to schedule */
+			    ssm_time_t then, /**< Event time; in the future */
+			    const void *payload
+			    /**< Points to the new value; ignored for events */);
+
 typedef struct { ssm_sv_t sv; } ssm_event_t;
 #define ssm_later_event(var, then) ssm_schedule(&(var)->sv, (then))
 extern void ssm_assign_event(ssm_event_t *var, ssm_priority_t prio);
 extern void ssm_initialize_event(ssm_event_t *);
+extern ssm_deliverf_t ssm_deliver_event;
 
 
 #define SSM_DECLARE_SV_SCALAR(payload_t)                                       \
@@ -456,31 +690,67 @@ extern void ssm_initialize_event(ssm_event_t *);
     ssm_sv_t sv;                                                          \
     payload_t value;       /* Current value */                                 \
     payload_t later_value; /* Buffered value */                                \
+    bool changes_only;     /* Fire only when the value changes */              \
   } ssm_##payload_t##_t;                                                       \
   void ssm_assign_##payload_t(ssm_##payload_t##_t *sv, ssm_priority_t prio,    \
                           const payload_t value);                              \
   void ssm_later_##payload_t(ssm_##payload_t##_t *sv, ssm_time_t then,         \
                          const payload_t value);                               \
-  void ssm_initialize_##payload_t(ssm_##payload_t##_t *v);
+  void ssm_initialize_##payload_t(ssm_##payload_t##_t *v);                     \
+  ssm_deliverf_t ssm_deliver_##payload_t;
+
+/** Make a scalar fire only when its value changes
+ *
+ * Afterward, an update or assignment that leaves the value of `var`, a
+ * variable declared with SSM_DECLARE_SV_SCALAR(), the same does not count
+ * as an event: ssm_event_on() stays false and no routine waiting on the
+ * variable wakes, which prunes redundant work downstream in a dataflow
+ * graph.
+ */
+#define ssm_changes_only(var)                                                  \
+  do {                                                                         \
+    SSM_SAVE((var)->changes_only);                                             \
+    (var)->changes_only = true;                                                \
+  } while (0)
 
 #define SSM_DEFINE_SV_SCALAR(payload_t)                                        \
-  static void ssm_update_##payload_t(ssm_sv_t *sv) {                      \
+  static bool ssm_update_##payload_t(ssm_sv_t *sv) {                      \
     ssm_##payload_t##_t *v = container_of(sv, ssm_##payload_t##_t, sv);        \
+    if (v->changes_only &&                                                     \
+        !memcmp(&v->value, &v->later_value, sizeof(payload_t)))                \
+      return false;                                                            \
+    SSM_SAVE(v->value);                                                        \
     v->value = v->later_value;                                                 \
+    return true;                                                               \
   }                                                                            \
   void ssm_assign_##payload_t(ssm_##payload_t##_t *v, ssm_priority_t prio,     \
                               const payload_t value) {                         \
+    if (v->changes_only &&                                                     \
+        !memcmp(&v->value, &value, sizeof(payload_t)))                         \
+      return;                                                                  \
+    SSM_SAVE(v->value);                                                        \
+    SSM_SAVE(v->sv.last_updated);                                              \
+    SSM_JOURNAL_MARK(&v->sv);                                                  \
     v->value = value;					                       \
     v->sv.last_updated = ssm_now();			  		       \
     ssm_trigger(&v->sv, prio);                                                 \
   }                                                                            \
   void ssm_later_##payload_t(ssm_##payload_t##_t *v, ssm_time_t then,          \
                          const payload_t value) {                              \
+    SSM_SAVE(v->later_value);                                                  \
     v->later_value = value;                                                    \
     ssm_schedule(&v->sv, then);					               \
   }		 	 						       \
+  void ssm_deliver_##payload_t(ssm_sv_t *sv, ssm_time_t then,                  \
+                               const void *payload) {                          \
+    ssm_##payload_t##_t *v = container_of(sv, ssm_##payload_t##_t, sv);        \
+    SSM_SAVE(v->later_value);                                                  \
+    memcpy(&v->later_value, payload, sizeof(payload_t));                       \
+    ssm_schedule(&v->sv, then);                                                \
+  }                                                                            \
   void ssm_initialize_##payload_t(ssm_##payload_t##_t *v) {                    \
-    ssm_initialize(&v->sv, ssm_update_##payload_t);	     	               \
+    ssm_initialize(&v->sv, ssm_update_##payload_t);                            \
+    v->changes_only = false;                                                   \
   }
  
 typedef int8_t   i8;   /**< 8-bit Signed Integer */
@@ -521,6 +791,1095 @@ SSM_DECLARE_SV_SCALAR(u16)
 SSM_DECLARE_SV_SCALAR(u32)
 SSM_DECLARE_SV_SCALAR(u64)
 
+/** \defgroup lanes Ensembles
+ *
+ * An ensemble runs #SSM_LANES instances of the same program in lock step,
+ * e.g., for a parameter sweep.  One scheduler drives every lane: the event
+ * times and activation order are shared; only the data differ.  Scheduled
+ * variables declared with SSM_DECLARE_SV_LANES() hold one value per lane,
+ * so step functions can operate on every lane with loops the compiler
+ * vectorizes.
+ *
+ * Where lanes would take different branches, the step function calls
+ * ssm_diverge(), which splits off the lanes that disagree into a separate
+ * context with ssm_split().  Each context then keeps running only its
+ * ssm_active_lanes; values in other lanes are meaningless.
+ *
+ * \addtogroup lanes
+ * @{
+ */
+
+#ifndef SSM_LANES
+/** Number of instances an ensemble runs in lock step; at most 64
+ *
+ * Must be the same when compiling the library and the program.
+ */
+#define SSM_LANES 8
+#endif
+
+/** A set of ensemble lanes, one bit per lane */
+typedef uint64_t ssm_lanes_t;
+
+/** Every lane of an ensemble */
+#define SSM_ALL_LANES (~(ssm_lanes_t) 0 >> (64 - SSM_LANES))
+
+/** Lanes run by this context; starts as #SSM_ALL_LANES */
+extern ssm_lanes_t ssm_active_lanes;
+
+/** Make every lane active again, e.g., before starting a new run */
+void ssm_reset_lanes(void);
+
+/** Return the set of active lanes whose flag is true */
+ssm_lanes_t ssm_lanes_where(const bool cond[SSM_LANES]);
+
+/** Decide a branch that may go different ways in different lanes
+ *
+ * Given the lanes for which the branch condition holds, return whether to
+ * take the branch.  If some active lanes take it and some do not, split the
+ * context with ssm_split(): the new context runs the lanes that take the
+ * branch and gets true; the original runs the others and gets false.
+ *
+ * Invokes #SSM_THROW(#SSM_DIVERGED_LANES) if lanes disagree and the
+ * platform does not provide ssm_split().
+ */
+bool ssm_diverge(ssm_lanes_t taken);
+
+/** Duplicate the running SSM program into a new context; platform-provided
+ *
+ * Declared as a weak symbol like ssm_throw.  Returns true in the new
+ * context and false in the original, e.g., by calling fork().
+ */
+bool ssm_split(void) __attribute__((weak));
+
+#define SSM_DECLARE_SV_LANES(payload_t)                                        \
+  typedef struct {                                                             \
+    ssm_sv_t sv;                                                               \
+    payload_t value[SSM_LANES];       /* Current values */                     \
+    payload_t later_value[SSM_LANES]; /* Buffered values */                    \
+  } ssm_##payload_t##_lanes_t;                                                 \
+  void ssm_assign_##payload_t##_lanes(ssm_##payload_t##_lanes_t *v,            \
+                                      ssm_priority_t prio,                     \
+                                      const payload_t value[SSM_LANES]);       \
+  void ssm_later_##payload_t##_lanes(ssm_##payload_t##_lanes_t *v,             \
+                                     ssm_time_t then,                          \
+                                     const payload_t value[SSM_LANES]);        \
+  void ssm_initialize_##payload_t##_lanes(ssm_##payload_t##_lanes_t *v);       \
+  ssm_deliverf_t ssm_deliver_##payload_t##_lanes;
+
+/* Lanes outside ssm_active_lanes are copied too: their values are
+   meaningless in this context, and whole-array copies vectorize. */
+#define SSM_DEFINE_SV_LANES(payload_t)                                         \
+  static bool ssm_update_##payload_t##_lanes(ssm_sv_t *sv) {                   \
+    ssm_##payload_t##_lanes_t *v =                                             \
+      container_of(sv, ssm_##payload_t##_lanes_t, sv);                         \
+    SSM_SAVE(v->value);                                                        \
+    for (int i = 0 ; i < SSM_LANES ; i++)                                      \
+      v->value[i] = v->later_value[i];                                         \
+    return true;                                                               \
+  }                                                                            \
+  void ssm_assign_##payload_t##_lanes(ssm_##payload_t##_lanes_t *v,            \
+                                      ssm_priority_t prio,                     \
+                                      const payload_t value[SSM_LANES]) {      \
+    SSM_SAVE(v->value);                                                        \
+    SSM_SAVE(v->sv.last_updated);                                              \
+    SSM_JOURNAL_MARK(&v->sv);                                                  \
+    for (int i = 0 ; i < SSM_LANES ; i++)                                      \
+      v->value[i] = value[i];                                                  \
+    v->sv.last_updated = ssm_now();                                            \
+    ssm_trigger(&v->sv, prio);                                                 \
+  }                                                                            \
+  void ssm_later_##payload_t##_lanes(ssm_##payload_t##_lanes_t *v,             \
+                                     ssm_time_t then,                          \
+                                     const payload_t value[SSM_LANES]) {       \
+    SSM_SAVE(v->later_value);                                                  \
+    for (int i = 0 ; i < SSM_LANES ; i++)                                      \
+      v->later_value[i] = value[i];                                            \
+    ssm_schedule(&v->sv, then);                                                \
+  }                                                                            \
+  void ssm_deliver_##payload_t##_lanes(ssm_sv_t *sv, ssm_time_t then,          \
+                                       const void *payload) {                  \
+    ssm_##payload_t##_lanes_t *v =                                             \
+      container_of(sv, ssm_##payload_t##_lanes_t, sv);                         \
+    ssm_later_##payload_t##_lanes(v, then, (const payload_t *) payload);       \
+  }                                                                            \
+  void ssm_initialize_##payload_t##_lanes(ssm_##payload_t##_lanes_t *v) {      \
+    ssm_initialize(&v->sv, ssm_update_##payload_t##_lanes);                    \
+  }
+
+/** \struct ssm_bool_lanes_t
+    Scheduled Boolean variable with a value per lane */
+/** \struct ssm_i8_lanes_t
+    Scheduled 8-bit Signed Integer variable with a value per lane */
+/** \struct ssm_i16_lanes_t
+    Scheduled 16-bit Signed Integer variable with a value per lane */
+/** \struct ssm_i32_lanes_t
+    Scheduled 32-bit Signed Integer variable with a value per lane */
+/** \struct ssm_i64_lanes_t
+    Scheduled 64-bit Signed Integer variable with a value per lane */
+/** \struct ssm_u8_lanes_t
+    Scheduled 8-bit Unsigned Integer variable with a value per lane */
+/** \struct ssm_u16_lanes_t
+    Scheduled 16-bit Unsigned Integer variable with a value per lane */
+/** \struct ssm_u32_lanes_t
+    Scheduled 32-bit Unsigned Integer variable with a value per lane */
+/** \struct ssm_u64_lanes_t
+    Scheduled 64-bit Unsigned Integer variable with a value per lane */
+
+SSM_DECLARE_SV_LANES(bool)
+SSM_DECLARE_SV_LANES(i8)
+SSM_DECLARE_SV_LANES(i16)
+SSM_DECLARE_SV_LANES(i32)
+SSM_DECLARE_SV_LANES(i64)
+SSM_DECLARE_SV_LANES(u8)
+SSM_DECLARE_SV_LANES(u16)
+SSM_DECLARE_SV_LANES(u32)
+SSM_DECLARE_SV_LANES(u64)
+
+/** @} */
+
+/** \defgroup actions Deferred Actions
+ *
+ * Lets step functions queue side effects, such as printing or setting an
+ * output pin, instead of performing them in the middle of an instant.
+ * Queuing an action only copies a few words, so an instant takes the same
+ * time whatever the devices are doing.  After ssm_tick() returns, the
+ * platform calls ssm_flush_actions() to perform the instant's actions in
+ * the order they were queued, or to hand them to an I/O thread.
+ *
+ * \addtogroup actions
+ * @{
+ */
+
+#ifndef SSM_ACTION_QUEUE_SIZE
+/** Most actions that may be queued in one instant; override as necessary */
+#define SSM_ACTION_QUEUE_SIZE 256
+#endif
+
+/** Performs a deferred action; `arg` is the value given to ssm_defer() */
+typedef void ssm_actionf_t(void *data, uint64_t arg);
+
+/** A queued action */
+typedef struct {
+  ssm_actionf_t *fn;  /**< What to do */
+  void *data;         /**< First argument of fn, e.g., a device */
+  uint64_t arg;       /**< Second argument of fn, e.g., a value to write */
+  ssm_time_t time;    /**< The instant that queued the action */
+} ssm_action_t;
+
+/** Receives each action flushed by ssm_flush_actions() */
+typedef void ssm_action_sinkf_t(const ssm_action_t *action);
+
+/** Queue an action to be performed after the current instant
+ *
+ * Invokes #SSM_THROW(#SSM_EXHAUSTED_ACTION_QUEUE) if the queue is full.
+ */
+void ssm_defer(ssm_actionf_t *fn, void *data, uint64_t arg);
+
+/** Empty the action queue; call after ssm_tick()
+ *
+ * Passes each action, in the order it was queued, to `sink`, or performs
+ * it immediately if `sink` is 0.  Returns the number of actions.
+ *
+ * With #SSM_OPTIMISTIC, an action queued by an instant that may still be
+ * rolled back stays queued until ssm_fossil_collect() commits the
+ * instant, since it could not be undone once performed; ssm_rollback()
+ * drops the actions of the instants it undoes.
+ */
+size_t ssm_flush_actions(ssm_action_sinkf_t *sink);
+
+/** Forget every queued action without performing it
+ *
+ * ssm_reset() leaves the action queue alone; call this as well when
+ * starting a new run, as ssm_batch_reset() does.
+ */
+void ssm_reset_actions(void);
+
+/** @} */
+
+/** \defgroup input External Inputs
+ *
+ * Lets other threads and interrupt handlers deliver values to scheduled
+ * variables.  Producers post timestamped updates to a lock-free,
+ * multi-producer, single-consumer ring; the thread that calls ssm_tick()
+ * drains it with ssm_input_drain() before each instant.  Posting never
+ * blocks or allocates, so it is safe from interrupt handlers.
+ *
+ * \addtogroup input
+ * @{
+ */
+
+#ifndef SSM_INPUT_QUEUE_SIZE
+/** Number of entries in the input ring; must be a power of two
+ *
+ * Must be the same when compiling the library and the program.
+ */
+#define SSM_INPUT_QUEUE_SIZE 256
+#endif
+
+/** Post an update of a scheduled variable from any thread or interrupt
+ *
+ * The update takes effect at the capture time `then`, or just after the
+ * current instant if that has already passed when it is drained.
+ * `deliver` is the variable type's delivery function, e.g.,
+ * ssm_deliver_i32(); `payload` holds at most 8 bytes and is copied.
+ * Calls ssm_input_notify(), if defined, after posting.  Returns false,
+ * dropping the update, if the ring is full.
+ */
+bool ssm_input_post(ssm_sv_t *var, ssm_deliverf_t *deliver, ssm_time_t then,
+		    const void *payload, size_t size);
+
+/** Move posted updates into the event queue; call from the tick thread
+ *
+ * Delivers updates in the order they were posted.  Stops early, leaving
+ * the rest in the ring, at an update that would replace a still-pending
+ * earlier event on the same variable; the caller should run that instant
+ * and drain again.  Returns the number of updates delivered.
+ */
+size_t ssm_input_drain(void);
+
+/** Return true if any posted update has not been drained */
+bool ssm_input_pending(void);
+
+/** Discard every posted update that has not been drained
+ *
+ * ssm_reset() leaves the input ring alone; call this as well when
+ * starting a new run, as ssm_batch_reset() does.  No producer may be
+ * posting while the ring is reset.
+ */
+void ssm_reset_input(void);
+
+/** Wake the tick thread after ssm_input_post(); provided by the platform
+ *
+ * Declared weak: if no platform defines it, posting only fills the ring.
+ * Must be safe to call from an interrupt handler.
+ */
+void ssm_input_notify(void) __attribute__((weak));
+
+/** @} */
+
+/** \defgroup pulses Pulse Counters
+ *
+ * Counts input edges arriving faster than instants could be run for
+ * them, e.g., for a frequency counter.  Interrupt handlers and other
+ * threads add to the counter with ssm_pulses_add(), which is a single
+ * atomic increment that never touches the scheduler.  The model sees the
+ * count only when it samples the counter: ssm_later_pulses() schedules
+ * an ordinary update that, when it happens, commits the edges counted so
+ * far, so the instant rate depends on the sampling rate alone.
+ *
+ * \addtogroup pulses
+ * @{
+ */
+
+/** A scheduled pulse counter
+ *
+ * `count` wraps; sample more often than every 2^32 edges.
+ */
+typedef struct {
+  ssm_sv_t sv;
+  u64 value;          /**< Edges counted up to the last sample */
+  u32 delta;          /**< Edges counted between the last two samples */
+  u32 count;          /**< Running count; updated atomically by producers */
+  u32 sampled;        /**< `count` at the last sample */
+} ssm_pulses_t;
+
+/** Initialize a pulse counter to zero */
+void ssm_initialize_pulses(ssm_pulses_t *v);
+
+/** Count `n` edges; safe from any thread or interrupt handler */
+static inline void ssm_pulses_add(ssm_pulses_t *v, u32 n)
+{
+  __atomic_fetch_add(&v->count, n, __ATOMIC_RELAXED);
+}
+
+/** Commit the edges counted so far in the current instant */
+void ssm_assign_pulses(ssm_pulses_t *v, ssm_priority_t prio);
+
+/** Commit the edges counted up to the instant at `then` */
+void ssm_later_pulses(ssm_pulses_t *v, ssm_time_t then);
+
+/** @} */
+
+/** \defgroup blobs Aggregate Variables
+ *
+ * Scheduled variables holding a struct or other block of bytes of any
+ * size, e.g., a sensor frame.  The current and buffered values live in
+ * two buffers the program provides.  A writer fills the buffered copy in
+ * place, found with ssm_blob_buffer(), then commits it with
+ * ssm_later_blob() or ssm_assign_blob(); committing swaps the two
+ * pointers, so no update copies the payload.
+ *
+ * The undo log (#SSM_OPTIMISTIC) records the pointer swaps but not the
+ * bytes written into the buffers.
+ *
+ * \addtogroup blobs
+ * @{
+ */
+
+/** A scheduled aggregate */
+typedef struct {
+  ssm_sv_t sv;
+  void *value;       /**< Current value; read only */
+  void *later_value; /**< Buffered value, written in place */
+  size_t size;       /**< Bytes in each buffer */
+} ssm_blob_t;
+
+/** Initialize an aggregate over two buffers of `size` bytes each
+ *
+ * `value` holds the initial value; `later` starts as the buffered copy.
+ */
+void ssm_initialize_blob(ssm_blob_t *v, void *value, void *later, size_t size);
+
+/** Return the buffered copy to fill before committing it
+ *
+ * It holds whatever was last swapped out, not necessarily the current
+ * value.  A pending ssm_later_blob() commits this buffer, so writing it
+ * changes what that update will commit.
+ */
+static inline void *ssm_blob_buffer(ssm_blob_t *v) { return v->later_value; }
+
+/** Make the buffered copy the current value in this instant
+ *
+ * Cancels any pending ssm_later_blob(), since the two share the buffer.
+ */
+void ssm_assign_blob(ssm_blob_t *v, ssm_priority_t prio);
+
+/** Make the buffered copy the current value at `then` */
+void ssm_later_blob(ssm_blob_t *v, ssm_time_t then);
+
+/** @} */
+
+/** \defgroup arrays Scheduled Arrays
+ *
+ * An array of fixed-size elements, e.g., a register file or lookup
+ * table, that occupies a single event-queue entry.  Delayed assignments
+ * to elements go to a buffered copy of each element and set its bit in a
+ * dirty bitmap; the array's update commits only the dirty elements.
+ * Every pending element commits together at the array's one pending
+ * update time; delayed assignments for another time wait until it passes.
+ *
+ * Routines may wait on the whole array through its `sv`, or on a range
+ * of indices through an #ssm_array_range_t, whose `sv` is triggered only
+ * when an element in the range changes.
+ *
+ * \addtogroup arrays
+ * @{
+ */
+
+/** Words in the dirty bitmap of an array of `len` elements */
+#define SSM_ARRAY_DIRTY_WORDS(len) (((len) + 63) / 64)
+
+/** A range of indices of an array that routines may wait on */
+typedef struct ssm_array_range {
+  ssm_sv_t sv;                   /**< Triggered when the range changes */
+  size_t lo, hi;                 /**< First and one past the last index */
+  struct ssm_array_range *next;  /**< Next range on the same array */
+} ssm_array_range_t;
+
+/** A scheduled array */
+typedef struct {
+  ssm_sv_t sv;
+  void *value;                   /**< Current elements; read only */
+  void *later_value;             /**< Buffered elements */
+  uint64_t *dirty;               /**< Bit i set when element i is pending */
+  size_t len;                    /**< Number of elements */
+  size_t size;                   /**< Bytes in each element */
+  size_t dirty_lo, dirty_hi;     /**< Span of bitmap words with bits set */
+  ssm_array_range_t *ranges;     /**< Ranges being watched */
+} ssm_array_t;
+
+/** Initialize an array of `len` elements of `size` bytes each
+ *
+ * `value` and `later` each hold `len * size` bytes; `value` holds the
+ * initial elements.  `dirty` holds SSM_ARRAY_DIRTY_WORDS(len) words.
+ */
+void ssm_initialize_array(ssm_array_t *v, void *value, void *later,
+			  uint64_t *dirty, size_t len, size_t size);
+
+/** Let routines wait on elements `lo` up to but excluding `hi` */
+void ssm_array_watch(ssm_array_t *v, ssm_array_range_t *range,
+		     size_t lo, size_t hi);
+
+/** Stop watching a range */
+void ssm_array_unwatch(ssm_array_t *v, ssm_array_range_t *range);
+
+/** Return a pointer to element `i`'s current value */
+static inline void *ssm_array_elem(ssm_array_t *v, size_t i)
+{
+  return (char *) v->value + i * v->size;
+}
+
+/** Set element `i` to the `v->size` bytes at `value` in this instant */
+void ssm_assign_array(ssm_array_t *v, ssm_priority_t prio, size_t i,
+		      const void *value);
+
+/** Set element `i` to the `v->size` bytes at `value` at time `then`
+ *
+ * The array has one pending update time, so every element pending is
+ * due at the same `then`.  Invokes #SSM_THROW(#SSM_INVALID_TIME) if
+ * `then` is not in the future or differs from the time of elements
+ * already pending.
+ */
+void ssm_later_array(ssm_array_t *v, ssm_time_t then, size_t i,
+		     const void *value);
+
+/** @} */
+
+/** \defgroup pools Pools
+ *
+ * Many scalar variables of the same type stored as a structure of
+ * arrays: values, buffered values, and timestamps each sit in their own
+ * dense array, and the whole pool occupies a single event-queue entry
+ * scheduled at its earliest pending element.  The pool's update commits
+ * every element due in the instant with one loop, either over the due
+ * indices or, when many are due, over the whole pool with a blend the
+ * compiler vectorizes, instead of one update call per variable.
+ *
+ * Routines may wait on the whole pool through its `pool.sv`, which is
+ * updated whenever any element commits, or on a single element with
+ * ssm_pool_sensitize().  Unlike a scalar, an element's pending update may
+ * fall at a different time from the others'.
+ *
+ * The program provides every array, e.g., with SSM_POOL_STORAGE(), so a
+ * pool allocates nothing.
+ *
+ * \addtogroup pools
+ * @{
+ */
+
+#ifndef SSM_POOL_BLEND_RATIO
+/** Commit over the whole pool when at least 1 in this many elements is due */
+#define SSM_POOL_BLEND_RATIO 8
+#endif
+
+/** The part of a pool that does not depend on the element type */
+typedef struct {
+  ssm_sv_t sv;                 /**< Scheduled at the earliest pending time */
+  size_t len;                  /**< Number of elements */
+  ssm_time_t *later_time;      /**< Per element; #SSM_NEVER if not pending */
+  ssm_time_t *last_updated;    /**< Per element */
+  ssm_trigger_t **triggers;    /**< Per element; routines waiting on it */
+  uint32_t *pending;           /**< Pending elements, a heap by later_time */
+  uint32_t *position;          /**< Per element; its place in `pending` */
+  size_t pending_len;          /**< Number of pending elements */
+} ssm_pool_t;
+
+/** Indicate writing to element `i` of a pool should trigger a routine
+ *
+ * Remove the trigger with ssm_desensitize() as usual.
+ */
+void ssm_pool_sensitize(ssm_pool_t *p, size_t i, ssm_trigger_t *trigger);
+
+/** Return true if element `i` of a pool was written in this instant */
+static inline bool ssm_pool_event_on(ssm_pool_t *p, size_t i)
+{
+  return p->last_updated[i] == ssm_now();
+}
+
+/** Set up a pool's timestamps, trigger lists, and heap; for SSM_DEFINE_SV_POOL()
+ *
+ * `times` holds `2 * len` times, `triggers` holds `len` pointers, and
+ * `indices` holds `2 * len` indices, all provided by the program.
+ */
+void ssm_initialize_pool(ssm_pool_t *p, size_t len,
+			 bool (*update)(ssm_sv_t *), ssm_time_t *times,
+			 ssm_trigger_t **triggers, uint32_t *indices);
+
+/** Take the elements due now off the pending heap and count them
+ *
+ * Leaves their indices just past the heap, starting at
+ * `pending + pending_len`, for the update and ssm_pool_commit().
+ */
+size_t ssm_pool_due(ssm_pool_t *p);
+
+/** Finish committing the `due` elements ssm_pool_due() took off the heap
+ *
+ * Stamps them, wakes the routines waiting on them, and schedules the pool
+ * for the next pending element.
+ */
+void ssm_pool_commit(ssm_pool_t *p, size_t due);
+
+/** Record that element `i` was written in this instant */
+void ssm_pool_assign(ssm_pool_t *p, ssm_priority_t prio, size_t i);
+
+/** Record that element `i` has an update pending at time `then`
+ *
+ * Takes time logarithmic in the number of pending elements.  Invokes
+ * #SSM_THROW(#SSM_INVALID_TIME), before changing anything, if `then` is
+ * not in the future.
+ */
+void ssm_pool_later(ssm_pool_t *p, size_t i, ssm_time_t then);
+
+#define SSM_DECLARE_SV_POOL(payload_t)                                         \
+  typedef struct {                                                             \
+    ssm_pool_t pool;                                                           \
+    payload_t *value;       /* Current values */                               \
+    payload_t *later_value; /* Buffered values */                              \
+  } ssm_##payload_t##_pool_t;                                                  \
+  void ssm_assign_##payload_t##_pool(ssm_##payload_t##_pool_t *v,              \
+                                     ssm_priority_t prio, size_t i,            \
+                                     const payload_t value);                   \
+  void ssm_later_##payload_t##_pool(ssm_##payload_t##_pool_t *v,               \
+                                    ssm_time_t then, size_t i,                 \
+                                    const payload_t value);                    \
+  void ssm_initialize_##payload_t##_pool(ssm_##payload_t##_pool_t *v,          \
+                                         payload_t *value, payload_t *later,   \
+                                         ssm_time_t *times,                    \
+                                         ssm_trigger_t **triggers,             \
+                                         uint32_t *indices, size_t len);
+
+/** Storage for a pool of `len` elements of type `payload_t`
+ *
+ * E.g., `static SSM_POOL_STORAGE(i32, 100) s;` declares what
+ * SSM_INITIALIZE_POOL(i32, &pool, &s) needs.
+ */
+#define SSM_POOL_STORAGE(payload_t, len)                                       \
+  struct {                                                                     \
+    payload_t value[len];                                                      \
+    payload_t later_value[len];                                                \
+    ssm_time_t times[2 * (len)];                                               \
+    ssm_trigger_t *triggers[len];                                              \
+    uint32_t indices[2 * (len)];                                               \
+  }
+
+/** Initialize a pool in storage declared with SSM_POOL_STORAGE() */
+#define SSM_INITIALIZE_POOL(payload_t, v, storage)                             \
+  ssm_initialize_##payload_t##_pool((v), (storage)->value,                     \
+                                    (storage)->later_value, (storage)->times,  \
+                                    (storage)->triggers, (storage)->indices,   \
+                                    sizeof((storage)->value) /                 \
+                                    sizeof((storage)->value[0]))
+
+/* When many elements are due, a blend over the whole pool runs faster
+   than scattering through the index list, and it vectorizes. */
+#define SSM_DEFINE_SV_POOL(payload_t)                                          \
+  static bool ssm_update_##payload_t##_pool(ssm_sv_t *sv) {                    \
+    ssm_##payload_t##_pool_t *v =                                              \
+      container_of(sv, ssm_##payload_t##_pool_t, pool.sv);                     \
+    size_t due = ssm_pool_due(&v->pool);                                       \
+    const uint32_t *idx = v->pool.pending + v->pool.pending_len;               \
+    for (size_t k = 0 ; k < due ; k++)                                         \
+      SSM_SAVE(v->value[idx[k]]);                                              \
+    if (due * SSM_POOL_BLEND_RATIO >= v->pool.len) {                           \
+      payload_t *restrict value = v->value;                                    \
+      const payload_t *restrict later = v->later_value;                        \
+      const ssm_time_t *restrict when = v->pool.later_time;                    \
+      ssm_time_t now = ssm_now();                                              \
+      for (size_t i = 0 ; i < v->pool.len ; i++)                               \
+        value[i] = when[i] == now ? later[i] : value[i];                       \
+    } else                                                                     \
+      for (size_t k = 0 ; k < due ; k++)                                       \
+        v->value[idx[k]] = v->later_value[idx[k]];                             \
+    ssm_pool_commit(&v->pool, due);                                            \
+    return true;                                                               \
+  }                                                                            \
+  void ssm_assign_##payload_t##_pool(ssm_##payload_t##_pool_t *v,              \
+                                     ssm_priority_t prio, size_t i,            \
+                                     const payload_t value) {                  \
+    assert(i < v->pool.len);                                                   \
+    SSM_SAVE(v->value[i]);                                                     \
+    v->value[i] = value;                                                       \
+    ssm_pool_assign(&v->pool, prio, i);                                        \
+  }                                                                            \
+  void ssm_later_##payload_t##_pool(ssm_##payload_t##_pool_t *v,               \
+                                    ssm_time_t then, size_t i,                 \
+                                    const payload_t value) {                   \
+    assert(i < v->pool.len);                                                   \
+    ssm_pool_later(&v->pool, i, then);                                         \
+    SSM_SAVE(v->later_value[i]);                                               \
+    v->later_value[i] = value;                                                 \
+  }                                                                            \
+  void ssm_initialize_##payload_t##_pool(ssm_##payload_t##_pool_t *v,          \
+                                         payload_t *value, payload_t *later,   \
+                                         ssm_time_t *times,                    \
+                                         ssm_trigger_t **triggers,             \
+                                         uint32_t *indices, size_t len) {      \
+    assert(value && later);                                                    \
+    v->value = value;                                                          \
+    v->later_value = later;                                                    \
+    memset(value, 0, len * sizeof(payload_t));                                 \
+    ssm_initialize_pool(&v->pool, len, ssm_update_##payload_t##_pool, times,   \
+                        triggers, indices);                                    \
+  }
+
+/** \struct ssm_bool_pool_t
+    Pool of scheduled Boolean variables */
+/** \struct ssm_i8_pool_t
+    Pool of scheduled 8-bit Signed Integer variables */
+/** \struct ssm_i16_pool_t
+    Pool of scheduled 16-bit Signed Integer variables */
+/** \struct ssm_i32_pool_t
+    Pool of scheduled 32-bit Signed Integer variables */
+/** \struct ssm_i64_pool_t
+    Pool of scheduled 64-bit Signed Integer variables */
+/** \struct ssm_u8_pool_t
+    Pool of scheduled 8-bit Unsigned Integer variables */
+/** \struct ssm_u16_pool_t
+    Pool of scheduled 16-bit Unsigned Integer variables */
+/** \struct ssm_u32_pool_t
+    Pool of scheduled 32-bit Unsigned Integer variables */
+/** \struct ssm_u64_pool_t
+    Pool of scheduled 64-bit Unsigned Integer variables */
+
+SSM_DECLARE_SV_POOL(bool)
+SSM_DECLARE_SV_POOL(i8)
+SSM_DECLARE_SV_POOL(i16)
+SSM_DECLARE_SV_POOL(i32)
+SSM_DECLARE_SV_POOL(i64)
+SSM_DECLARE_SV_POOL(u8)
+SSM_DECLARE_SV_POOL(u16)
+SSM_DECLARE_SV_POOL(u32)
+SSM_DECLARE_SV_POOL(u64)
+
+/** @} */
+
+/** \defgroup bits Bit Vectors
+ *
+ * Boolean signals packed 64 to a word, e.g., the nets of a gate-level
+ * circuit, that occupy a single event-queue entry.  Delayed assignments
+ * write masked bits of a word into a buffered copy and set the same bits
+ * in a pending mask; the update commits each word with one masked
+ * operation.  As with a scheduled array, every pending bit commits at the
+ * vector's one pending update time.
+ *
+ * Routines may wait on the whole vector through its `sv`, or on some bits
+ * of one word through an #ssm_bits_watch_t, whose `sv` is triggered only
+ * when one of those bits is written.
+ *
+ * \addtogroup bits
+ * @{
+ */
+
+/** Words holding a vector of `len` bits */
+#define SSM_BITS_WORDS(len) (((len) + 63) / 64)
+
+/** Some bits of a vector that routines may wait on */
+typedef struct ssm_bits_watch {
+  ssm_sv_t sv;                   /**< Triggered when a watched bit is written */
+  size_t word;                   /**< Index of the word holding the bits */
+  uint64_t mask;                 /**< Which bits of the word */
+  struct ssm_bits_watch *next;   /**< Next watch on the same vector */
+} ssm_bits_watch_t;
+
+/** A scheduled bit vector */
+typedef struct {
+  ssm_sv_t sv;
+  uint64_t *value;               /**< Current bits; read only */
+  uint64_t *later_value;         /**< Buffered bits */
+  uint64_t *pending;             /**< Bits with an update pending */
+  size_t words;                  /**< Number of words */
+  size_t dirty_lo, dirty_hi;     /**< Span of words with pending bits */
+  ssm_bits_watch_t *watches;     /**< Bits being watched */
+} ssm_bits_t;
+
+/** Initialize a vector of `len` bits
+ *
+ * `value`, `later`, and `pending` each hold SSM_BITS_WORDS(len) words;
+ * `value` holds the initial bits.
+ */
+void ssm_initialize_bits(ssm_bits_t *v, uint64_t *value, uint64_t *later,
+			 uint64_t *pending, size_t len);
+
+/** Let routines wait on the bits in `mask` of word `word` */
+void ssm_bits_watch(ssm_bits_t *v, ssm_bits_watch_t *watch, size_t word,
+		    uint64_t mask);
+
+/** Stop watching bits */
+void ssm_bits_unwatch(ssm_bits_t *v, ssm_bits_watch_t *watch);
+
+/** Return the current value of bit `i` */
+static inline bool ssm_bits_get(ssm_bits_t *v, size_t i)
+{
+  return v->value[i / 64] >> (i % 64) & 1;
+}
+
+/** Set the bits in `mask` of word `word` to those of `bits` in this instant */
+void ssm_assign_bits(ssm_bits_t *v, ssm_priority_t prio, size_t word,
+		     uint64_t mask, uint64_t bits);
+
+/** Set the bits in `mask` of word `word` to those of `bits` at time `then`
+ *
+ * Every bit pending is due at the same `then`.  Invokes
+ * #SSM_THROW(#SSM_INVALID_TIME) if `then` is not in the future or differs
+ * from the time of bits already pending.
+ */
+void ssm_later_bits(ssm_bits_t *v, ssm_time_t then, size_t word,
+		    uint64_t mask, uint64_t bits);
+
+/** Set bit `i` to `bit` at time `then` */
+static inline void ssm_later_bit(ssm_bits_t *v, ssm_time_t then, size_t i,
+				 bool bit)
+{
+  ssm_later_bits(v, then, i / 64, (uint64_t) 1 << (i % 64),
+		 bit ? ~(uint64_t) 0 : 0);
+}
+
+/** @} */
+
+/** \defgroup delays Delay Lines
+ *
+ * A scheduled variable that, unlike the others, keeps every pending
+ * update instead of replacing it: an ordered queue of (time, value)
+ * pairs, e.g., the values in flight through a transport delay, a
+ * pipeline, or a network link.  The variable occupies one event-queue
+ * entry, at its earliest pending time; its update commits that value and
+ * schedules the next, so no helper routine is needed per value in flight.
+ *
+ * Values are fixed-size blocks of bytes, as in a scheduled array.  The
+ * program provides the storage for the current value and for the queue,
+ * which holds up to `capacity` pending values.
+ *
+ * \addtogroup delays
+ * @{
+ */
+
+/** A delay line */
+typedef struct {
+  ssm_sv_t sv;
+  void *value;             /**< Current value; read only */
+  ssm_time_t *times;       /**< When each queued value commits */
+  void *values;            /**< Queued values, `size` bytes each */
+  size_t size;             /**< Bytes in each value */
+  size_t capacity;         /**< Most values that may be pending */
+  size_t head;             /**< Slot of the earliest pending value */
+  size_t count;            /**< Number of pending values */
+} ssm_delay_t;
+
+/** Initialize a delay line of `size`-byte values
+ *
+ * `value` holds `size` bytes, the initial value.  `times` holds
+ * `capacity` times and `values` holds `capacity * size` bytes.
+ */
+void ssm_initialize_delay(ssm_delay_t *v, void *value, ssm_time_t *times,
+			  void *values, size_t size, size_t capacity);
+
+/** Set the current value to the `v->size` bytes at `value` in this instant
+ *
+ * Leaves pending values in place.
+ */
+void ssm_assign_delay(ssm_delay_t *v, ssm_priority_t prio, const void *value);
+
+/** Queue the `v->size` bytes at `value` to become the value at `then`
+ *
+ * Replaces the value already pending at `then`, if any, and keeps every
+ * other.  Appending in time order takes constant time.
+ *
+ * Invokes #SSM_THROW(#SSM_EXHAUSTED_DELAY_LINE) if `capacity` values are
+ * already pending.
+ */
+void ssm_later_delay(ssm_delay_t *v, ssm_time_t then, const void *value);
+
+/** @} */
+
+/** \defgroup lazy Lazy Variables
+ *
+ * Scalar variables that no routine waits on and that are written more
+ * often than read, e.g., a sample a background routine overwrites every
+ * tick and another checks now and then.  A delayed assignment to a lazy
+ * variable stays out of the event queue: it only records the buffered
+ * value and its time, and the first read at or after that time commits
+ * it.  ssm_tick() never updates the variable, so the update phase costs
+ * only what the program observes.
+ *
+ * Read a lazy variable with ssm_read_<type>_lazy(); ssm_event_on() commits
+ * a pending value first as well, so an event at the pending time is seen
+ * if and only if an instant occurs at that time.  Since a lazy variable's
+ * pending update cannot wake anything, do not sensitize routines to one
+ * or pass it to ssm_schedule() or ssm_unschedule().
+ *
+ * \addtogroup lazy
+ * @{
+ */
+
+/** Commit a lazy variable's pending value if its time has come
+ *
+ * Sets `last_updated` to the time of the pending update, not the current
+ * time, so ssm_event_on() is true only in that instant.
+ */
+void ssm_resolve(ssm_sv_t *var);
+
+#define SSM_DECLARE_SV_LAZY(payload_t)                                         \
+  typedef struct {                                                             \
+    ssm_sv_t sv;                                                               \
+    payload_t value;       /* Current value; read with ssm_read_*_lazy() */    \
+    payload_t later_value; /* Buffered value */                                \
+  } ssm_##payload_t##_lazy_t;                                                  \
+  static inline payload_t                                                      \
+  ssm_read_##payload_t##_lazy(ssm_##payload_t##_lazy_t *v) {                   \
+    if (v->sv.later_time != SSM_NEVER) ssm_resolve(&v->sv);                    \
+    return v->value;                                                           \
+  }                                                                            \
+  void ssm_assign_##payload_t##_lazy(ssm_##payload_t##_lazy_t *v,              \
+                                     ssm_priority_t prio,                      \
+                                     const payload_t value);                   \
+  void ssm_later_##payload_t##_lazy(ssm_##payload_t##_lazy_t *v,               \
+                                    ssm_time_t then, const payload_t value);   \
+  void ssm_initialize_##payload_t##_lazy(ssm_##payload_t##_lazy_t *v);         \
+  ssm_deliverf_t ssm_deliver_##payload_t##_lazy;
+
+#define SSM_DEFINE_SV_LAZY(payload_t)                                          \
+  static bool ssm_update_##payload_t##_lazy(ssm_sv_t *sv) {                    \
+    ssm_##payload_t##_lazy_t *v =                                              \
+      container_of(sv, ssm_##payload_t##_lazy_t, sv);                          \
+    SSM_SAVE(v->value);                                                        \
+    v->value = v->later_value;                                                 \
+    return true;                                                               \
+  }                                                                            \
+  void ssm_assign_##payload_t##_lazy(ssm_##payload_t##_lazy_t *v,              \
+                                     ssm_priority_t prio,                      \
+                                     const payload_t value) {                  \
+    ssm_resolve(&v->sv);                                                       \
+    SSM_SAVE(v->value);                                                        \
+    SSM_SAVE(v->sv.last_updated);                                              \
+    SSM_JOURNAL_MARK(&v->sv);                                                  \
+    v->value = value;                                                          \
+    v->sv.last_updated = ssm_now();                                            \
+  }                                                                            \
+  void ssm_later_##payload_t##_lazy(ssm_##payload_t##_lazy_t *v,               \
+                                    ssm_time_t then, const payload_t value) {  \
+    assert(!v->sv.triggers);                                                   \
+    if (then <= ssm_now()) SSM_THROW(SSM_INVALID_TIME);                        \
+    ssm_resolve(&v->sv);                                                       \
+    SSM_SAVE(v->later_value);                                                  \
+    SSM_SAVE(v->sv.later_time);                                                \
+    v->later_value = value;                                                    \
+    v->sv.later_time = then;                                                   \
+  }                                                                            \
+  void ssm_deliver_##payload_t##_lazy(ssm_sv_t *sv, ssm_time_t then,           \
+                                      const void *payload) {                   \
+    payload_t value;                                                           \
+    memcpy(&value, payload, sizeof(payload_t));                                \
+    ssm_later_##payload_t##_lazy(container_of(sv, ssm_##payload_t##_lazy_t,    \
+                                              sv), then, value);               \
+  }                                                                            \
+  void ssm_initialize_##payload_t##_lazy(ssm_##payload_t##_lazy_t *v) {        \
+    ssm_initialize(&v->sv, ssm_update_##payload_t##_lazy);                     \
+  }
+
+/** \struct ssm_bool_lazy_t
+    Lazy Boolean variable */
+/** \struct ssm_i8_lazy_t
+    Lazy 8-bit Signed Integer variable */
+/** \struct ssm_i16_lazy_t
+    Lazy 16-bit Signed Integer variable */
+/** \struct ssm_i32_lazy_t
+    Lazy 32-bit Signed Integer variable */
+/** \struct ssm_i64_lazy_t
+    Lazy 64-bit Signed Integer variable */
+/** \struct ssm_u8_lazy_t
+    Lazy 8-bit Unsigned Integer variable */
+/** \struct ssm_u16_lazy_t
+    Lazy 16-bit Unsigned Integer variable */
+/** \struct ssm_u32_lazy_t
+    Lazy 32-bit Unsigned Integer variable */
+/** \struct ssm_u64_lazy_t
+    Lazy 64-bit Unsigned Integer variable */
+
+SSM_DECLARE_SV_LAZY(bool)
+SSM_DECLARE_SV_LAZY(i8)
+SSM_DECLARE_SV_LAZY(i16)
+SSM_DECLARE_SV_LAZY(i32)
+SSM_DECLARE_SV_LAZY(i64)
+SSM_DECLARE_SV_LAZY(u8)
+SSM_DECLARE_SV_LAZY(u16)
+SSM_DECLARE_SV_LAZY(u32)
+SSM_DECLARE_SV_LAZY(u64)
+
+/** @} */
+
+/** \defgroup channels Channels
+ *
+ * A bounded FIFO of fixed-size items between routines, backed by a ring
+ * of slots the program provides.  Unlike a scalar, which keeps only the
+ * last value written in an instant, a channel keeps every item enqueued:
+ * producers reserve a slot with ssm_channel_reserve(), fill it in place,
+ * and enqueue it with ssm_later_channel() or ssm_assign_channel().  Each
+ * item enqueued for later keeps its own time, as in a delay line, and
+ * items due at the same time become visible together, so the consumer
+ * waiting on the channel's `sv` wakes once for all of them.  It reads
+ * items in place with ssm_channel_peek() and frees their slots with
+ * ssm_channel_pop().
+ *
+ * With #SSM_OPTIMISTIC, reserving a slot logs its bytes, so rolling back
+ * a pop and the items later written over the freed slot restores the
+ * popped item.
+ *
+ * \addtogroup channels
+ * @{
+ */
+
+/** A channel */
+typedef struct {
+  ssm_sv_t sv;
+  void *slots;        /**< `capacity` slots of `size` bytes each */
+  ssm_time_t *times;  /**< When each slot's pending item becomes visible */
+  size_t size;        /**< Bytes in each item */
+  size_t capacity;    /**< Number of slots */
+  size_t head;        /**< Slot of the oldest visible item */
+  size_t count;       /**< Items the consumer may read */
+  size_t pending;     /**< Items enqueued but not yet visible */
+} ssm_channel_t;
+
+/** Initialize a channel of `capacity` items of `size` bytes each
+ *
+ * `slots` holds `capacity * size` bytes and `times` holds `capacity`
+ * times.
+ */
+void ssm_initialize_channel(ssm_channel_t *c, void *slots, ssm_time_t *times,
+			    size_t size, size_t capacity);
+
+/** Return the slot for the next item to enqueue, or 0 if the channel is full
+ *
+ * Fill the slot in place, then enqueue it.  Reserving again before
+ * enqueueing returns the same slot.
+ */
+void *ssm_channel_reserve(ssm_channel_t *c);
+
+/** Enqueue the reserved item to become visible at `then`
+ *
+ * Items pending for earlier times stay due then.  Invokes
+ * #SSM_THROW(#SSM_INVALID_TIME) if `then` is not in the future or is
+ * before the time of the last item pending, which would overtake it.
+ */
+void ssm_later_channel(ssm_channel_t *c, ssm_time_t then);
+
+/** Enqueue the reserved item and make it visible in this instant
+ *
+ * Makes every pending item visible as well, since items stay in order,
+ * and cancels the pending update.
+ */
+void ssm_assign_channel(ssm_channel_t *c, ssm_priority_t prio);
+
+/** Copy `item` into the channel to become visible at `then`
+ *
+ * Returns false, enqueueing nothing, if the channel is full.  See
+ * ssm_later_channel() for the restrictions on `then`.
+ */
+bool ssm_channel_send(ssm_channel_t *c, ssm_time_t then, const void *item);
+
+/** Return the oldest visible item, or 0 if there is none */
+static inline void *ssm_channel_peek(ssm_channel_t *c)
+{
+  return c->count ? (char *) c->slots + c->head * c->size : 0;
+}
+
+/** Remove the oldest visible item, freeing its slot */
+void ssm_channel_pop(ssm_channel_t *c);
+
+/** @} */
+
+/** \defgroup buffers Byte Buffers
+ *
+ * Scheduled variables holding variable-length byte payloads, e.g.,
+ * packets from a network or serial adapter, without copying them.  A
+ * payload lives in a reference-counted slice taken from a pool carved
+ * out of storage the program provides, so moving data allocates nothing
+ * in steady state.
+ *
+ * An adapter takes a slice with ssm_slice_alloc(), fills its `data` and
+ * sets its `len`, then hands its reference to a buffer variable with
+ * ssm_later_buffer() or ssm_assign_buffer(), or posts the slice pointer
+ * with ssm_input_post() and ssm_deliver_buffer().  The variable releases
+ * the slice when a new one replaces it, whether current or pending; a
+ * routine that keeps a payload beyond that calls ssm_slice_retain() and
+ * later ssm_slice_release().  A slice returns to its pool when its last
+ * reference is released.
+ *
+ * Allocating, retaining, and releasing slices is safe from any thread
+ * and from interrupt handlers: the pool's free list is lock-free.
+ *
+ * Buffers do not support speculative execution: rolling back could bring
+ * back a pointer to a slice already returned to its pool and handed out
+ * again.  Every buffer operation invokes
+ * #SSM_THROW(#SSM_SPECULATIVE_BUFFER) while #ssm_optimistic is set, as
+ * does ssm_tick() when it would update a buffer then.
+ *
+ * \addtogroup buffers
+ * @{
+ */
+
+struct ssm_slice_pool;
+
+/** A reference-counted slice of bytes */
+typedef struct ssm_slice {
+  uint32_t refs;                  /**< References; 0 while in the pool */
+  uint32_t next;                  /**< Number of the next free slice, or 0 */
+  size_t len;                     /**< Bytes of `data` in use */
+  struct ssm_slice_pool *pool;    /**< Where the slice returns */
+  unsigned char data[];           /**< `pool->slice_size` bytes */
+} ssm_slice_t;
+
+/** A pool of equal-size slices
+ *
+ * Slices are numbered from 1 in address order.  The low half of `free`
+ * holds the number of the first free slice, or 0 if none; the high half
+ * counts changes to the list, so a compare-and-swap that raced with
+ * another thread or an interrupt fails even if the same slice is back on
+ * top.
+ */
+typedef struct ssm_slice_pool {
+  uintptr_t free;                 /**< Tagged free list head */
+  unsigned char *base;            /**< Storage the slices were carved from */
+  size_t stride;                  /**< Bytes between slices */
+  size_t slice_size;              /**< Bytes of data in each slice */
+  size_t available;               /**< Number of free slices */
+} ssm_slice_pool_t;
+
+/** Bytes a pool needs for each slice of `size` data bytes */
+#define SSM_SLICE_STRIDE(size) \
+  ((offsetof(ssm_slice_t, data) + (size) + 7) & ~(size_t) 7)
+
+/** Carve `bytes` of storage into slices of `slice_size` data bytes
+ *
+ * `storage` is aligned for a pointer; the pool holds
+ * `bytes / SSM_SLICE_STRIDE(slice_size)` slices, fewer than 2^16 on
+ * targets with 32-bit pointers.
+ */
+void ssm_initialize_slice_pool(ssm_slice_pool_t *p, void *storage,
+			       size_t bytes, size_t slice_size);
+
+/** Take a slice with one reference and no bytes in use, or 0 if none left */
+ssm_slice_t *ssm_slice_alloc(ssm_slice_pool_t *p);
+
+/** Add a reference to a slice */
+void ssm_slice_retain(ssm_slice_t *s);
+
+/** Drop a reference to a slice, returning it to its pool after the last */
+void ssm_slice_release(ssm_slice_t *s);
+
+/** A scheduled byte buffer */
+typedef struct {
+  ssm_sv_t sv;
+  ssm_slice_t *value;             /**< Current payload, or 0; read only */
+  ssm_slice_t *later_value;       /**< Pending payload, or 0 */
+} ssm_buffer_t;
+
+/** Initialize a buffer with no payload */
+void ssm_initialize_buffer(ssm_buffer_t *v);
+
+/** Make `slice` the payload in this instant, taking the caller's reference
+ *
+ * Leaves a pending payload in place.
+ */
+void ssm_assign_buffer(ssm_buffer_t *v, ssm_priority_t prio,
+		       ssm_slice_t *slice);
+
+/** Make `slice` the payload at `then`, taking the caller's reference
+ *
+ * Releases the payload it replaces as the pending one, if any, but only
+ * after scheduling: if `then` is not in the future, it invokes
+ * #SSM_THROW(#SSM_INVALID_TIME) and leaves the pending payload in place.
+ */
+void ssm_later_buffer(ssm_buffer_t *v, ssm_time_t then, ssm_slice_t *slice);
+
+/** Deliver a posted slice pointer, taking the poster's reference */
+ssm_deliverf_t ssm_deliver_buffer;
+
+/** Drop a buffer's current and pending payloads */
+void ssm_drop_buffer(ssm_buffer_t *v);
+
+/** @} */
+
 /** @} */
 
 #endif
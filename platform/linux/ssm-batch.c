@@ -0,0 +1,108 @@
+#define _GNU_SOURCE
+#include "ssm-linux.h"
+
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/** Alignment of every activation record in the arena */
+#define ARENA_ALIGN 16
+
+/** Activation record arena; each worker process has its own copy */
+static unsigned char arena[SSM_BATCH_ARENA_SIZE]
+  __attribute__((aligned(ARENA_ALIGN)));
+
+/** Bytes of the arena in use */
+static size_t arena_top = 0;
+
+static inline size_t arena_round(size_t bytes)
+{
+  return (bytes + ARENA_ALIGN - 1) & ~(size_t) (ARENA_ALIGN - 1);
+}
+
+void *ssm_batch_alloc(size_t bytes)
+{
+  bytes = arena_round(bytes);
+  if (bytes > SSM_BATCH_ARENA_SIZE - arena_top) return 0;
+  void *ptr = arena + arena_top;
+  arena_top += bytes;
+  return ptr;
+}
+
+void ssm_batch_free(void *ptr, size_t bytes)
+{
+  bytes = arena_round(bytes);
+  if ((unsigned char *) ptr + bytes == arena + arena_top)
+    arena_top -= bytes;
+}
+
+void ssm_batch_reset(void)
+{
+  ssm_reset();
+  ssm_reset_actions();
+  ssm_reset_input();
+  ssm_reset_lanes();
+  arena_top = 0;
+}
+
+/** Take chunks of runs from the shared counter until none are left */
+static void batch_work(size_t *next, size_t runs, ssm_batch_runf_t *run,
+		       unsigned char *summaries, size_t summary_size)
+{
+  for (;;) {
+    size_t first = __atomic_fetch_add(next, SSM_BATCH_CHUNK, __ATOMIC_RELAXED);
+    if (first >= runs) return;
+    size_t last = first + SSM_BATCH_CHUNK < runs ? first + SSM_BATCH_CHUNK
+						 : runs;
+    for (size_t i = first ; i < last ; i++) {
+      ssm_batch_reset();
+      run(i, summaries + i * summary_size);
+    }
+  }
+}
+
+int ssm_batch_run(size_t runs, unsigned workers, ssm_batch_runf_t *run,
+		  void *summaries, size_t summary_size)
+{
+  assert(run);
+  assert(summaries || !runs || !summary_size);
+  if (!workers) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    workers = n > 0 ? n : 1;
+  }
+
+  /* The counter and the summaries are shared with the workers */
+  size_t bytes = sizeof(size_t) + runs * summary_size;
+  void *shared = mmap(0, bytes, PROT_READ | PROT_WRITE,
+		      MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (shared == MAP_FAILED) return -1;
+  size_t *next = shared;
+  unsigned char *results = (unsigned char *) (next + 1);
+  *next = 0;
+
+  /* This process is the last worker */
+  fflush(0); // Don't let the workers repeat our buffered output
+  unsigned started = 0;
+  for ( ; started < workers - 1 ; started++) {
+    pid_t pid = fork();
+    if (pid < 0) break;
+    if (pid == 0) {
+      batch_work(next, runs, run, results, summary_size);
+      fflush(0);
+      _exit(0);
+    }
+  }
+  batch_work(next, runs, run, results, summary_size);
+
+  int failed = 0;
+  for ( ; started ; started--) {
+    int status;
+    if (wait(&status) < 0) SSM_THROW(SSM_SYSTEM_ERROR);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) failed++;
+  }
+
+  memcpy(summaries, results, runs * summary_size);
+  munmap(shared, bytes);
+  return failed;
+}
@@ -0,0 +1,49 @@
+#define _GNU_SOURCE
+#include "ssm-linux.h"
+
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/** Contexts split off from this process that have not been joined */
+static unsigned children = 0;
+
+/** True in a context created by ssm_split() */
+static bool split_off = false;
+
+bool ssm_split(void)
+{
+  fflush(0); // Don't let the new context repeat our buffered output
+  pid_t pid = fork();
+  if (pid < 0) SSM_THROW(SSM_SYSTEM_ERROR);
+  if (pid == 0) {
+    children = 0;
+    split_off = true;
+    return true;
+  }
+  children++;
+  return false;
+}
+
+void *ssm_ensemble_shared(size_t bytes)
+{
+  void *p = mmap(0, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS,
+		 -1, 0);
+  return p == MAP_FAILED ? 0 : p;
+}
+
+int ssm_ensemble_join(void)
+{
+  int failed = 0;
+  for ( ; children ; children--) {
+    int status;
+    if (wait(&status) < 0) SSM_THROW(SSM_SYSTEM_ERROR);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) failed++;
+  }
+  if (split_off) {
+    fflush(0);
+    _exit(failed ? 1 : 0);
+  }
+  return failed;
+}
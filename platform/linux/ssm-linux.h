@@ -0,0 +1,604 @@
+#ifndef _SSM_LINUX_H
+#define _SSM_LINUX_H
+
+/** \defgroup linux Linux Platform
+ *
+ * Support for running SSM programs as ordinary Linux processes.
+ * Link with build/libssm-linux.a (and -lpthread -lrt) in addition to
+ * build/libssm.a.
+ *
+ * \addtogroup linux
+ * @{
+ */
+
+#include <stddef.h>
+#include <sys/uio.h>  /* For struct iovec */
+
+/** Allocate an activation record from the batch arena; 0 when it is full
+ *
+ * For programs run by ssm_batch_run(), which rewinds the arena before
+ * every run.  Declared ahead of ssm.h so a program can define
+ *
+ * ~~~{.c}
+ * #define SSM_ACT_MALLOC(size) ssm_batch_alloc(size)
+ * #define SSM_ACT_FREE(ptr, size) ssm_batch_free(ptr, size)
+ * #include "ssm-linux.h"
+ * ~~~
+ */
+void *ssm_batch_alloc(size_t bytes);
+
+/** Return an activation record to the batch arena
+ *
+ * Only reclaims the space if it was the last record allocated; the rest
+ * is reclaimed when the arena is rewound.
+ */
+void ssm_batch_free(void *ptr, size_t bytes);
+
+#include "ssm.h"
+
+/** Error codes raised by the Linux platform through #SSM_THROW */
+enum ssm_linux_error_t {
+  /** Tried to send a message on a full shared-memory ring. */
+  SSM_EXHAUSTED_RING = SSM_PLATFORM_ERROR,
+  /** A system call the platform relies on failed. */
+  SSM_SYSTEM_ERROR,
+  /** Start of the application-specific error code range. */
+  SSM_LINUX_PLATFORM_ERROR
+};
+
+/** \defgroup shm Shared-Memory Partitions
+ *
+ * Run the partitions of an SSM model in separate processes that exchange
+ * timestamped value updates through lock-free single-producer,
+ * single-consumer rings in a shared-memory segment; one ring for each
+ * ordered pair of partitions.
+ *
+ * Synchronization is conservative.  Each channel has a lookahead L > 0: a
+ * partition sending on it at time t must deliver the update at t + L or
+ * later.  After every round, a partition publishes a channel clock on each
+ * outgoing ring, a promise that no future message on it will be earlier.
+ * A partition may only run instants earlier than the minimum of its
+ * incoming channel clocks, its "safe time."
+ *
+ * A message is only handed to ssm_schedule() just before the instant it is
+ * for, so scalar variables, which hold a single pending value, never lose
+ * an update that is still in flight.
+ *
+ * \addtogroup shm
+ * @{
+ */
+
+/** A timestamped value update in flight between two partitions */
+typedef struct {
+  ssm_time_t time;  /**< When the update takes effect at the receiver */
+  uint32_t var;     /**< Variable number at the receiver; see ssm_shm_bind() */
+  uint32_t size;    /**< Bytes of payload used */
+  uint64_t payload; /**< The new value; copied with memcpy */
+} ssm_shm_msg_t;
+
+/** A process's view of a shared-memory segment */
+typedef struct ssm_shm ssm_shm_t;
+
+/** Create and map a named segment connecting the given number of partitions
+ *
+ * The creator becomes partition 0.  Each ring holds `capacity` messages,
+ * which must be a power of two.  Every lookahead starts at #SSM_NEVER,
+ * meaning the channel is unused.  Returns 0 and sets errno on failure.
+ */
+ssm_shm_t *ssm_shm_create(const char *name, unsigned partitions,
+			  unsigned capacity);
+
+/** Map an existing segment as the given partition; 0 on failure */
+ssm_shm_t *ssm_shm_attach(const char *name, unsigned self);
+
+/** Unmap a segment and free the process's bindings */
+void ssm_shm_detach(ssm_shm_t *shm);
+
+/** Remove the name of a segment; mappings remain valid */
+int ssm_shm_unlink(const char *name);
+
+/** Declare that partition `from` sends to partition `to` with a lookahead */
+void ssm_shm_set_lookahead(ssm_shm_t *shm, unsigned from, unsigned to,
+			   ssm_time_t lookahead);
+
+/** Make messages for variable number `var` update a local variable */
+void ssm_shm_bind(ssm_shm_t *shm, uint32_t var, ssm_sv_t *sv,
+		  ssm_deliverf_t *deliver);
+
+/** Send an update of variable `var` in partition `to` at time `then`
+ *
+ * Must be called from the partition's own process, usually from a step
+ * function.  `then` must be at least ssm_now() plus the lookahead.
+ * Invokes #SSM_THROW(#SSM_EXHAUSTED_RING) if the ring is full.
+ */
+void ssm_shm_send(ssm_shm_t *shm, unsigned to, uint32_t var, ssm_time_t then,
+		  const void *payload, size_t size);
+
+/** Return the time before which this partition may run instants */
+ssm_time_t ssm_shm_safe_time(ssm_shm_t *shm);
+
+/** Take in messages and prepare the next instant if it is safe to run
+ *
+ * Moves every message out of the incoming rings; rings are in sending
+ * order, not time order, so they wait in a local queue.  If the next
+ * instant, counting those messages, is earlier than the safe time, hands
+ * the messages for that instant to ssm_schedule() and returns true;
+ * the caller should then run ssm_tick().
+ */
+bool ssm_shm_receive(ssm_shm_t *shm);
+
+/** Publish this partition's channel clocks on its outgoing rings */
+void ssm_shm_publish(ssm_shm_t *shm);
+
+/** Run this partition until every instant before `stop` is done
+ *
+ * Alternates ssm_shm_receive(), ssm_tick() on every safe instant, and
+ * ssm_shm_publish(), yielding the processor when it must wait for others.
+ * Call this after the program's first ssm_tick() at time 0.
+ */
+void ssm_shm_run(ssm_shm_t *shm, ssm_time_t stop);
+
+/** @} */
+
+/** \defgroup ensemble Ensemble Contexts
+ *
+ * Provides ssm_split() for ensembles (see SSM_DECLARE_SV_LANES()): when
+ * lanes diverge, the process forks, and the child continues with the lanes
+ * that split off.  Every context runs the rest of the program, so results
+ * should go to memory from ssm_ensemble_shared(), indexed by lane.
+ *
+ * \addtogroup ensemble
+ * @{
+ */
+
+/** Allocate memory that every context of an ensemble shares; 0 on failure
+ *
+ * Call before running the ensemble so every context inherits it.
+ */
+void *ssm_ensemble_shared(size_t bytes);
+
+/** Finish this context of an ensemble
+ *
+ * Waits for every context split off from this one.  In a split-off
+ * context, then exits the process.  In the original context, returns the
+ * number of split-off contexts that failed, i.e., did not exit normally
+ * with status 0.
+ */
+int ssm_ensemble_join(void);
+
+/** @} */
+
+/** \defgroup rt Real-Time Driver
+ *
+ * Run an SSM program against the wall clock.  Model time 0 is the moment
+ * ssm_rt_init() is called and model time advances with CLOCK_MONOTONIC.
+ * A timerfd is armed for ssm_next_event_time(), and epoll waits on it
+ * and on any input file descriptors the program registers.  Every
+ * instant runs as soon as its time has passed.  The driver measures how
+ * late it was, i.e., the wall time at which the instant started minus
+ * the instant's model time.
+ *
+ * Other threads may deliver inputs with ssm_input_post(); the driver
+ * defines ssm_input_notify() to wake itself and drains the input ring
+ * before every instant.
+ *
+ * Only one driver runs per process, since the scheduler is global.
+ *
+ * \addtogroup rt
+ * @{
+ */
+
+/** Called when a registered input file descriptor is readable
+ *
+ * Should read from `fd` and schedule the corresponding updates, e.g.,
+ * with ssm_later_i32(var, ssm_rt_input_time(), value).
+ */
+typedef void ssm_rt_inputf_t(int fd, void *data);
+
+/** Called after every instant with its model time and lateness */
+typedef void ssm_rt_latenessf_t(ssm_time_t instant, ssm_time_t lateness);
+
+/** Called before every instant with its model time */
+typedef size_t ssm_rt_collectf_t(ssm_time_t instant);
+
+/** Called after ssm_rt_run() drains the input ring */
+typedef void ssm_rt_drainedf_t(void);
+
+/** Lateness of the instants run so far */
+typedef struct {
+  uint64_t instants;       /**< Number of instants run */
+  ssm_time_t total;        /**< Sum of their lateness */
+  ssm_time_t max;          /**< Worst lateness */
+  ssm_time_t last;         /**< Lateness of the most recent instant */
+} ssm_rt_stats_t;
+
+/** Start the wall clock at model time 0 and set up the timer and epoll
+ *
+ * Returns 0 on success; -1 and sets errno on failure.
+ */
+int ssm_rt_init(void);
+
+/** Release the timer, the epoll instance, and every input */
+void ssm_rt_close(void);
+
+/** Return the current wall time as a model time */
+ssm_time_t ssm_rt_wall_time(void);
+
+/** Return the time at which an input arriving now should be scheduled
+ *
+ * This is the wall time, or just after ssm_now() if the model is still
+ * running the current instant.
+ */
+ssm_time_t ssm_rt_input_time(void);
+
+/** Call `handler` whenever `fd` becomes readable
+ *
+ * Returns 0 on success; -1 and sets errno on failure.
+ */
+int ssm_rt_add_input(int fd, ssm_rt_inputf_t *handler, void *data);
+
+/** Stop watching an input file descriptor; 0 or -1 and errno */
+int ssm_rt_remove_input(int fd);
+
+/** Call `handler` after each instant with its lateness; 0 for none */
+void ssm_rt_set_lateness_handler(ssm_rt_latenessf_t *handler);
+
+/** Return the lateness measured so far */
+ssm_rt_stats_t ssm_rt_stats(void);
+
+/** Call `collect` before each instant with its time; 0, the default, for none
+ *
+ * Pass ssm_offload_collect() when using the compute offload.  Lateness is
+ * measured after `collect` returns, so waiting for results counts.
+ */
+void ssm_rt_set_collector(ssm_rt_collectf_t *collect);
+
+/** Call `handler` each time ssm_rt_run() drains the input ring; 0 for none
+ *
+ * Lets an input that stopped for want of room in the input ring, e.g.,
+ * ssm_uring_reap(), post the rest once there is room.
+ */
+void ssm_rt_set_drain_handler(ssm_rt_drainedf_t *handler);
+
+/** Choose where ssm_rt_run() sends each instant's deferred actions
+ *
+ * After every instant, the driver calls ssm_flush_actions() with `sink`;
+ * 0, the default, performs the actions right away on the tick thread.
+ * Pass ssm_output_sink() to perform them on the I/O thread instead.
+ */
+void ssm_rt_set_action_sink(ssm_action_sinkf_t *sink);
+
+/** Make ssm_rt_run() return after the current instant or input
+ *
+ * May be called from any thread or signal handler.  The stop lasts until
+ * the next ssm_rt_init(), so one made before ssm_rt_run() starts is not
+ * lost: ssm_rt_run() then returns after draining the input ring.
+ */
+void ssm_rt_stop(void);
+
+/** Wake early and spin for the last stretch before each instant
+ *
+ * With a nonzero `margin`, ssm_rt_run() sleeps until `margin` before the
+ * next instant, then busy-waits on the clock until the instant's time.
+ * This trades a core's worth of CPU for the kernel's wakeup jitter.
+ * Inputs that arrive while spinning are taken in after the instant.
+ * A `margin` of 0, the default, always sleeps.
+ */
+void ssm_rt_set_spin(ssm_time_t margin);
+
+/** Prepare the calling thread for low-latency deadlines
+ *
+ * Pins the thread to processor `cpu` unless it is negative, locks the
+ * process's memory so page faults cannot stall an instant, and, if
+ * `fifo_priority` is positive, switches the thread to SCHED_FIFO at that
+ * priority, which usually needs CAP_SYS_NICE.  Returns 0 on success; -1
+ * and sets errno on the first step that fails.
+ */
+int ssm_rt_realtime(int cpu, int fifo_priority);
+
+/** Run instants at their wall times until model time `stop`
+ *
+ * Call this after the program's first ssm_tick() at time 0.  Returns
+ * once the wall time has reached `stop` and no instant before it is
+ * pending, or after ssm_rt_stop(); with no pending event, it waits for
+ * inputs indefinitely.  Invokes #SSM_THROW(#SSM_SYSTEM_ERROR) if waiting
+ * fails.
+ */
+void ssm_rt_run(ssm_time_t stop);
+
+/** @} */
+
+/** \defgroup uring Asynchronous I/O
+ *
+ * Lets routines read and write files and pipes through io_uring without
+ * blocking the thread running instants.  A routine starts an operation
+ * with, e.g., ssm_uring_read(), then waits on its result variable.  The
+ * operations started in an instant are submitted together after the
+ * instant, as a deferred action (see ssm_defer()).  When an operation
+ * completes, its result, the number of bytes transferred or a negated
+ * errno, is posted with ssm_input_post() to the result variable,
+ * timestamped with the wall time at which the completion was reaped.
+ *
+ * Works with the real-time driver, which watches the ring for
+ * completions.  With a kernel submission thread (`sqpoll`), steady-state
+ * submission takes no system calls at all.
+ *
+ * \addtogroup uring
+ * @{
+ */
+
+/** Set up a ring with room for `entries` operations in flight
+ *
+ * Call after ssm_rt_init().  If `sqpoll` is true, a kernel thread polls
+ * for submissions.  Returns 0 on success; -1 and sets errno on failure.
+ */
+int ssm_uring_init(unsigned entries, bool sqpoll);
+
+/** Tear down the ring; operations still in flight are abandoned */
+void ssm_uring_close(void);
+
+/** Register buffers for ssm_uring_read_fixed() and ssm_uring_write_fixed()
+ *
+ * The kernel maps them once instead of on every operation.  Returns 0 on
+ * success; -1 and sets errno on failure.
+ */
+int ssm_uring_register_buffers(const struct iovec *iovecs, unsigned count);
+
+/** Start reading `len` bytes from `fd` at `offset` into `buf`
+ *
+ * Use an `offset` of -1 for the current file position, e.g., on a pipe.
+ * The result goes to `result` when the read completes.  Returns false if
+ * the ring is full.
+ */
+bool ssm_uring_read(int fd, void *buf, size_t len, uint64_t offset,
+		    ssm_i64_t *result);
+
+/** Start writing `len` bytes from `buf` to `fd` at `offset`; see
+ * ssm_uring_read() */
+bool ssm_uring_write(int fd, const void *buf, size_t len, uint64_t offset,
+		     ssm_i64_t *result);
+
+/** Like ssm_uring_read() into part of registered buffer `index` */
+bool ssm_uring_read_fixed(int fd, unsigned index, void *buf, size_t len,
+			  uint64_t offset, ssm_i64_t *result);
+
+/** Like ssm_uring_write() from part of registered buffer `index` */
+bool ssm_uring_write_fixed(int fd, unsigned index, const void *buf,
+			   size_t len, uint64_t offset, ssm_i64_t *result);
+
+/** Submit every operation started so far
+ *
+ * Happens automatically after each instant that starts an operation, on
+ * whichever thread performs the instant's deferred actions, e.g., the I/O
+ * thread with ssm_output_sink().
+ */
+void ssm_uring_submit(void);
+
+/** Post the results of completed operations; returns how many
+ *
+ * The real-time driver calls this when the ring has completions.
+ * Leaves completions in the ring while the input ring is full; the driver
+ * then stops watching the ring, which would stay readable, and calls this
+ * again after each drain of the input ring until every completion fits.
+ */
+size_t ssm_uring_reap(void);
+
+/** @} */
+
+/** \defgroup offload Compute Offload
+ *
+ * Runs expensive pure computations, e.g., an FFT over a window of
+ * samples, on a pool of worker threads so they overlap later instants
+ * instead of stretching the one that starts them.
+ *
+ * A routine calls ssm_offload() with the function, its argument, and the
+ * variable that should receive the result at a model time in the future.
+ * This schedules the assignment right away, as ssm_later_i32() would,
+ * and fills in its value when the worker finishes.  The result therefore
+ * appears at exactly the requested time however fast the workers are.
+ * Before running an instant, the driver calls ssm_offload_collect(),
+ * which waits for any computation due by then that is still running and
+ * reports it as late; a slow worker delays the instant, not the result.
+ *
+ * The function must not touch the scheduler or any scheduled variable;
+ * it reads `arg` and writes at most 8 bytes of result.
+ *
+ * \addtogroup offload
+ * @{
+ */
+
+#ifndef SSM_OFFLOAD_QUEUE_SIZE
+/** Most computations that may be outstanding at once */
+#define SSM_OFFLOAD_QUEUE_SIZE 64
+#endif
+
+#ifndef SSM_OFFLOAD_MAX_WORKERS
+/** Most worker threads in the pool */
+#define SSM_OFFLOAD_MAX_WORKERS 16
+#endif
+
+/** A computation run on a worker; writes its result to `result` */
+typedef void ssm_offloadf_t(void *arg, void *result);
+
+/** Called with the due time of a late result and how long it was waited for */
+typedef void ssm_offload_latef_t(ssm_time_t due, ssm_time_t late);
+
+/** Start `workers` worker threads
+ *
+ * Returns 0 on success; -1 and sets errno on failure.
+ */
+int ssm_offload_start(unsigned workers);
+
+/** Stop the workers once they finish what they are running
+ *
+ * Computations never collected are abandoned.
+ */
+void ssm_offload_stop(void);
+
+/** Run `fn(arg, result)` on a worker and assign the result to `var` at `due`
+ *
+ * `deliver` stores the result in `var`, e.g., ssm_deliver_i64.  `due`
+ * must be after ssm_now().  The computation owns the variable's pending
+ * update: a later assignment scheduled on `var` before `due` is
+ * overridden.  Returns false if #SSM_OFFLOAD_QUEUE_SIZE computations are
+ * already outstanding.
+ */
+bool ssm_offload(ssm_offloadf_t *fn, void *arg, ssm_sv_t *var,
+		 ssm_deliverf_t *deliver, ssm_time_t due);
+
+/** Assign the results of every computation due at or before `when`
+ *
+ * Waits for those still running.  Call it before each ssm_tick() with
+ * ssm_next_event_time(); ssm_rt_run() does after
+ * ssm_rt_set_collector(ssm_offload_collect).  Returns how many results it
+ * assigned.
+ */
+size_t ssm_offload_collect(ssm_time_t when);
+
+/** Call `handler` for each result that was waited for; 0 for none */
+void ssm_offload_set_late_handler(ssm_offload_latef_t *handler);
+
+/** @} */
+
+/** \defgroup output I/O Thread
+ *
+ * Performs deferred actions (see ssm_defer()) on a separate thread so the
+ * thread running instants never waits on a device.  Actions travel over
+ * a single-producer, single-consumer ring and run in the order they were
+ * queued.
+ *
+ * \addtogroup output
+ * @{
+ */
+
+#ifndef SSM_OUTPUT_RING_SIZE
+/** Number of actions in flight to the I/O thread; a power of two */
+#define SSM_OUTPUT_RING_SIZE 4096
+#endif
+
+/** Start the I/O thread; 0 on success, -1 and errno on failure */
+int ssm_output_start(void);
+
+/** Hand an action to the I/O thread; an #ssm_action_sinkf_t
+ *
+ * Call from one thread only, e.g., as
+ * ssm_flush_actions(ssm_output_sink).  Yields the processor until there
+ * is room if the ring is full.
+ */
+void ssm_output_sink(const ssm_action_t *action);
+
+/** Wait for the I/O thread to perform every action it was given, then
+ * stop it */
+void ssm_output_stop(void);
+
+/** @} */
+
+/** \defgroup batch Batch Runs
+ *
+ * Run many independent configurations of a program, e.g., a parameter
+ * sweep, on every core.  Worker processes take runs in chunks from a
+ * shared counter.  Before each run, a worker calls ssm_reset() and
+ * rewinds its activation record arena, both in constant time, instead
+ * of tearing down what the previous run left behind.
+ *
+ * \addtogroup batch
+ * @{
+ */
+
+#ifndef SSM_BATCH_ARENA_SIZE
+/** Bytes in each worker's activation record arena; override as necessary */
+#define SSM_BATCH_ARENA_SIZE (1 << 20)
+#endif
+
+#ifndef SSM_BATCH_CHUNK
+/** Number of consecutive runs a worker takes at a time */
+#define SSM_BATCH_CHUNK 256
+#endif
+
+/** One run of a batch
+ *
+ * Set up the program for configuration number `run`, which should
+ * initialize every scheduled variable it uses, tick it as long as
+ * desired, and write the results to the `summary`.
+ */
+typedef void ssm_batch_runf_t(size_t run, void *summary);
+
+/** Start a run: reset the scheduler, the action queue, the input ring,
+ * and the active lanes, and rewind the arena */
+void ssm_batch_reset(void);
+
+/** Run configurations 0 through runs - 1 on a number of worker processes
+ *
+ * Uses one worker per online processor if `workers` is 0.  Run `i` writes
+ * its results to the `summary_size` bytes at `summaries + i *
+ * summary_size`.  Returns the number of workers that failed, i.e., did
+ * not exit normally with status 0, or -1 and sets errno if the workers
+ * could not be started.
+ */
+int ssm_batch_run(size_t runs, unsigned workers, ssm_batch_runf_t *run,
+		  void *summaries, size_t summary_size);
+
+/** @} */
+
+/** \defgroup stimulus Recorded Stimuli
+ *
+ * Drives a program from recorded traces too large to schedule up front.
+ * Each stream is a file of #ssm_stimulus_record_t records sorted by
+ * time, which is memory-mapped and read sequentially.  Before each
+ * instant, ssm_stimulus_feed() merges the streams and delivers only the
+ * records due next, so the event queue holds at most one instant's worth
+ * of stimulus and memory stays constant however long the trace is.
+ *
+ * \addtogroup stimulus
+ * @{
+ */
+
+#ifndef SSM_STIMULUS_MAX_STREAMS
+/** Most streams that may be open at once */
+#define SSM_STIMULUS_MAX_STREAMS 16
+#endif
+
+/** One update in a stimulus file, in host byte order */
+typedef struct {
+  uint64_t time;       /**< Model time of the update */
+  uint32_t id;         /**< Variable to update; see ssm_stimulus_bind() */
+  uint32_t reserved;   /**< Write as zero */
+  uint64_t payload;    /**< New value, as passed to the delivery function */
+} ssm_stimulus_record_t;
+
+/** Map a stimulus file and add it to the streams being merged
+ *
+ * Records at the same time are delivered in the order the streams were
+ * opened, then in file order.  Returns 0 on success; -1 and sets errno on
+ * failure, e.g., EINVAL if the file is not a whole number of records or
+ * EMFILE if #SSM_STIMULUS_MAX_STREAMS are already open.
+ */
+int ssm_stimulus_open(const char *path);
+
+/** Deliver records for `id` to `var` with `deliver`, e.g., ssm_deliver_i32
+ *
+ * Records for unbound ids are skipped.
+ */
+void ssm_stimulus_bind(uint32_t id, ssm_sv_t *var, ssm_deliverf_t *deliver);
+
+/** Schedule the records due next; call before each ssm_tick()
+ *
+ * Delivers every record at the earliest time left in any stream, unless
+ * the program already has an earlier event pending.  Stops early at a
+ * record that would replace a still-pending earlier update of the same
+ * variable.  A record whose time has already passed is delivered just
+ * after the current instant.  Returns the number of records delivered.
+ */
+size_t ssm_stimulus_feed(void);
+
+/** Return true if any stream has records left */
+bool ssm_stimulus_pending(void);
+
+/** Unmap and close every stream and forget every binding */
+void ssm_stimulus_close(void);
+
+/** @} */
+
+/** @} */
+
+#endif
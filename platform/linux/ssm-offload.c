@@ -0,0 +1,170 @@
+#define _GNU_SOURCE
+#include "ssm-linux.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+
+/** Nanoseconds in a second, independent of #SSM_SECOND */
+#define NS_PER_SEC 1000000000L
+
+typedef enum { FREE, QUEUED, RUNNING, DONE } job_state_t;
+
+/** An outstanding computation */
+typedef struct {
+  job_state_t state;
+  uint64_t seq;              /**< Order of submission, to break ties */
+  ssm_offloadf_t *fn;
+  void *arg;
+  ssm_sv_t *var;
+  ssm_deliverf_t *deliver;
+  ssm_time_t due;
+  uint64_t result;
+} job_t;
+
+static job_t jobs[SSM_OFFLOAD_QUEUE_SIZE];
+static size_t outstanding = 0; /**< Jobs not FREE; only the tick thread writes */
+static uint64_t next_seq = 0;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queued = PTHREAD_COND_INITIALIZER; /**< For workers */
+static pthread_cond_t done = PTHREAD_COND_INITIALIZER;   /**< For collect */
+static bool quitting = false;
+
+static pthread_t workers[SSM_OFFLOAD_MAX_WORKERS];
+static unsigned worker_count = 0;
+
+static ssm_offload_latef_t *late_handler = 0;
+
+/** Return the queued job due soonest, or 0; call with the lock held */
+static job_t *earliest_queued(void)
+{
+  job_t *best = 0;
+  for (job_t *j = jobs ; j < jobs + SSM_OFFLOAD_QUEUE_SIZE ; j++)
+    if (j->state == QUEUED &&
+	(!best || j->due < best->due ||
+	 (j->due == best->due && j->seq < best->seq)))
+      best = j;
+  return best;
+}
+
+static void *worker(void *arg)
+{
+  pthread_mutex_lock(&lock);
+  for (;;) {
+    job_t *j;
+    while (!(j = earliest_queued()) && !quitting)
+      pthread_cond_wait(&queued, &lock);
+    if (!j) break;
+    j->state = RUNNING;
+    pthread_mutex_unlock(&lock);
+
+    j->result = 0;
+    j->fn(j->arg, &j->result);
+
+    pthread_mutex_lock(&lock);
+    j->state = DONE;
+    pthread_cond_broadcast(&done);
+  }
+  pthread_mutex_unlock(&lock);
+  return 0;
+}
+
+int ssm_offload_start(unsigned count)
+{
+  assert(count > 0 && count <= SSM_OFFLOAD_MAX_WORKERS);
+  quitting = false;
+  for (worker_count = 0 ; worker_count < count ; worker_count++) {
+    int r = pthread_create(&workers[worker_count], 0, worker, 0);
+    if (r) {
+      ssm_offload_stop();
+      errno = r;
+      return -1;
+    }
+  }
+  return 0;
+}
+
+void ssm_offload_stop(void)
+{
+  pthread_mutex_lock(&lock);
+  quitting = true;
+  pthread_cond_broadcast(&queued);
+  pthread_mutex_unlock(&lock);
+  while (worker_count)
+    pthread_join(workers[--worker_count], 0);
+
+  for (job_t *j = jobs ; j < jobs + SSM_OFFLOAD_QUEUE_SIZE ; j++)
+    j->state = FREE;
+  outstanding = 0;
+}
+
+bool ssm_offload(ssm_offloadf_t *fn, void *arg, ssm_sv_t *var,
+		 ssm_deliverf_t *deliver, ssm_time_t due)
+{
+  assert(fn);
+  assert(var);
+  assert(deliver);
+  assert(due > ssm_now());
+  assert(worker_count > 0);
+  if (outstanding == SSM_OFFLOAD_QUEUE_SIZE) return false;
+
+  /* Claim the update now so the instant at `due` is scheduled */
+  ssm_schedule(var, due);
+
+  pthread_mutex_lock(&lock);
+  job_t *j = jobs;
+  while (j->state != FREE) j++;
+  *j = (job_t) { .state = QUEUED, .seq = next_seq++, .fn = fn, .arg = arg,
+		 .var = var, .deliver = deliver, .due = due };
+  outstanding++;
+  pthread_cond_signal(&queued);
+  pthread_mutex_unlock(&lock);
+  return true;
+}
+
+/** Return the outstanding job due soonest at or before `when`, or 0 */
+static job_t *earliest_due(ssm_time_t when)
+{
+  job_t *best = 0;
+  for (job_t *j = jobs ; j < jobs + SSM_OFFLOAD_QUEUE_SIZE ; j++)
+    if (j->state != FREE && j->due <= when &&
+	(!best || j->due < best->due ||
+	 (j->due == best->due && j->seq < best->seq)))
+      best = j;
+  return best;
+}
+
+size_t ssm_offload_collect(ssm_time_t when)
+{
+  if (!outstanding) return 0;
+
+  size_t collected = 0;
+  pthread_mutex_lock(&lock);
+  job_t *j;
+  while ((j = earliest_due(when))) {
+    if (j->state != DONE) {
+      struct timespec start, end;
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      while (j->state != DONE)
+	pthread_cond_wait(&done, &lock);
+      clock_gettime(CLOCK_MONOTONIC, &end);
+      if (late_handler)
+	late_handler(j->due,
+		     ((end.tv_sec - start.tv_sec) * NS_PER_SEC +
+		      end.tv_nsec - start.tv_nsec) * SSM_SECOND / NS_PER_SEC);
+    }
+    /* Deliver in due-then-submission order so results are deterministic */
+    j->deliver(j->var, j->due, &j->result);
+    j->state = FREE;
+    outstanding--;
+    collected++;
+  }
+  pthread_mutex_unlock(&lock);
+  return collected;
+}
+
+void ssm_offload_set_late_handler(ssm_offload_latef_t *handler)
+{
+  late_handler = handler;
+}
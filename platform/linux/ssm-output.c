@@ -0,0 +1,96 @@
+#define _GNU_SOURCE
+#include "ssm-linux.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#if SSM_OUTPUT_RING_SIZE & (SSM_OUTPUT_RING_SIZE - 1)
+#error "SSM_OUTPUT_RING_SIZE must be a power of two"
+#endif
+
+static ssm_action_t ring[SSM_OUTPUT_RING_SIZE];
+static uint64_t head = 0;  /**< Next action to perform; I/O thread writes */
+static uint64_t tail = 0;  /**< Next free slot; producer writes */
+
+static int wake_fd = -1;   /**< Written when the I/O thread may be asleep */
+static bool sleeping = false;
+static bool quitting = false;
+static pthread_t thread;
+
+static void *output_thread(void *arg)
+{
+  uint64_t count;
+  for (;;) {
+    uint64_t t = __atomic_load_n(&tail, __ATOMIC_ACQUIRE);
+    if (head != t) {
+      for ( ; head != t ; head++) {
+	ssm_action_t *a = &ring[head & (SSM_OUTPUT_RING_SIZE - 1)];
+	a->fn(a->data, a->arg);
+      }
+      __atomic_store_n(&head, head, __ATOMIC_RELEASE);
+      continue;
+    }
+    if (__atomic_load_n(&quitting, __ATOMIC_ACQUIRE)) return 0;
+
+    /* Announce we are going to sleep, then check again so a producer
+       that missed the announcement cannot leave us asleep */
+    __atomic_store_n(&sleeping, true, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&tail, __ATOMIC_SEQ_CST) == head &&
+	!__atomic_load_n(&quitting, __ATOMIC_SEQ_CST))
+      if (read(wake_fd, &count, sizeof(count)) < 0 && errno != EINTR)
+	return 0;
+    __atomic_store_n(&sleeping, false, __ATOMIC_RELAXED);
+  }
+}
+
+static void wake(void)
+{
+  uint64_t one = 1;
+  if (__atomic_exchange_n(&sleeping, false, __ATOMIC_SEQ_CST) &&
+      write(wake_fd, &one, sizeof(one)) < 0) {
+    // The counter is saturated, so a wakeup is already pending
+  }
+}
+
+int ssm_output_start(void)
+{
+  if ((wake_fd = eventfd(0, EFD_CLOEXEC)) < 0) return -1;
+  head = tail = 0;
+  sleeping = quitting = false;
+  int r = pthread_create(&thread, 0, output_thread, 0);
+  if (r) {
+    close(wake_fd);
+    wake_fd = -1;
+    errno = r;
+    return -1;
+  }
+  return 0;
+}
+
+void ssm_output_sink(const ssm_action_t *action)
+{
+  while (tail - __atomic_load_n(&head, __ATOMIC_ACQUIRE) ==
+	 SSM_OUTPUT_RING_SIZE) {
+    wake();
+    sched_yield();
+  }
+  ring[tail & (SSM_OUTPUT_RING_SIZE - 1)] = *action;
+  __atomic_store_n(&tail, tail + 1, __ATOMIC_SEQ_CST);
+  wake();
+}
+
+void ssm_output_stop(void)
+{
+  if (wake_fd < 0) return;
+  __atomic_store_n(&quitting, true, __ATOMIC_SEQ_CST);
+  uint64_t one = 1;
+  if (write(wake_fd, &one, sizeof(one)) < 0) {
+    // A wakeup is already pending
+  }
+  pthread_join(thread, 0);
+  close(wake_fd);
+  wake_fd = -1;
+}
@@ -0,0 +1,297 @@
+#define _GNU_SOURCE
+#include "ssm-linux.h"
+
+#include <errno.h>
+#include <sched.h>
+#include <stdint.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifndef SSM_RT_MAX_INPUTS
+/** Number of input file descriptors that may be registered */
+#define SSM_RT_MAX_INPUTS 64
+#endif
+
+/** Nanoseconds in a second, independent of #SSM_SECOND */
+#define NS_PER_SEC 1000000000L
+
+/** A registered input */
+typedef struct {
+  int fd;                    /**< -1 if the slot is free */
+  ssm_rt_inputf_t *handler;
+  void *data;
+} input_t;
+
+static input_t inputs[SSM_RT_MAX_INPUTS];
+static unsigned input_count = 0; /**< Number of slots in use */
+
+static int epoll_fd = -1;
+static int timer_fd = -1;
+static int notify_fd = -1; /**< Signaled by ssm_input_notify() */
+
+/** Wall time of model time 0 */
+static struct timespec epoch;
+
+static ssm_rt_latenessf_t *lateness_handler = 0;
+static ssm_rt_stats_t stats;
+static bool stopping = false; /**< Accessed atomically; see stopped() */
+static ssm_time_t spin_margin = 0;
+static ssm_action_sinkf_t *action_sink = 0;
+static ssm_rt_collectf_t *collector = 0;
+static ssm_rt_drainedf_t *drain_handler = 0;
+
+/** epoll data for the timer and notifications; inputs use their slot */
+#define TIMER_TAG UINT32_MAX
+#define NOTIFY_TAG (UINT32_MAX - 1)
+
+static ssm_time_t to_model(const struct timespec *ts)
+{
+  int64_t sec = ts->tv_sec - epoch.tv_sec;
+  int64_t nsec = ts->tv_nsec - epoch.tv_nsec;
+  if (nsec < 0) {
+    sec--;
+    nsec += NS_PER_SEC;
+  }
+  return (ssm_time_t) sec * SSM_SECOND +
+    (ssm_time_t) nsec * SSM_SECOND / NS_PER_SEC;
+}
+
+static struct timespec to_wall(ssm_time_t t)
+{
+  struct timespec ts = {
+    .tv_sec = epoch.tv_sec + t / SSM_SECOND,
+    .tv_nsec = epoch.tv_nsec + (t % SSM_SECOND) * NS_PER_SEC / SSM_SECOND
+  };
+  if (ts.tv_nsec >= NS_PER_SEC) {
+    ts.tv_sec++;
+    ts.tv_nsec -= NS_PER_SEC;
+  }
+  return ts;
+}
+
+int ssm_rt_init(void)
+{
+  ssm_rt_close();
+  if ((epoll_fd = epoll_create1(EPOLL_CLOEXEC)) < 0) return -1;
+  if ((timer_fd = timerfd_create(CLOCK_MONOTONIC,
+				 TFD_NONBLOCK | TFD_CLOEXEC)) < 0) {
+    ssm_rt_close();
+    return -1;
+  }
+  struct epoll_event ev = { .events = EPOLLIN, .data.u32 = TIMER_TAG };
+  if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, timer_fd, &ev) < 0) {
+    ssm_rt_close();
+    return -1;
+  }
+  if ((notify_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0) {
+    ssm_rt_close();
+    return -1;
+  }
+  ev.data.u32 = NOTIFY_TAG;
+  if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, notify_fd, &ev) < 0) {
+    ssm_rt_close();
+    return -1;
+  }
+  for (unsigned i = 0 ; i < SSM_RT_MAX_INPUTS ; i++)
+    inputs[i].fd = -1;
+  input_count = 0;
+  stats = (ssm_rt_stats_t) { 0 };
+  __atomic_store_n(&stopping, false, __ATOMIC_RELAXED);
+  clock_gettime(CLOCK_MONOTONIC, &epoch);
+  return 0;
+}
+
+void ssm_rt_close(void)
+{
+  if (notify_fd >= 0) close(notify_fd);
+  if (timer_fd >= 0) close(timer_fd);
+  if (epoll_fd >= 0) close(epoll_fd);
+  notify_fd = timer_fd = epoll_fd = -1;
+  input_count = 0;
+}
+
+ssm_time_t ssm_rt_wall_time(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return to_model(&ts);
+}
+
+ssm_time_t ssm_rt_input_time(void)
+{
+  ssm_time_t wall = ssm_rt_wall_time();
+  return wall > ssm_now() ? wall : ssm_now() + 1;
+}
+
+int ssm_rt_add_input(int fd, ssm_rt_inputf_t *handler, void *data)
+{
+  assert(handler);
+  unsigned i;
+  for (i = 0 ; i < SSM_RT_MAX_INPUTS && inputs[i].fd >= 0 ; i++)
+    ;
+  if (i == SSM_RT_MAX_INPUTS) {
+    errno = ENOSPC;
+    return -1;
+  }
+  struct epoll_event ev = { .events = EPOLLIN, .data.u32 = i };
+  if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) return -1;
+  inputs[i] = (input_t) { .fd = fd, .handler = handler, .data = data };
+  input_count++;
+  return 0;
+}
+
+int ssm_rt_remove_input(int fd)
+{
+  for (unsigned i = 0 ; i < SSM_RT_MAX_INPUTS ; i++)
+    if (inputs[i].fd == fd) {
+      inputs[i].fd = -1;
+      input_count--;
+      return epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, 0);
+    }
+  errno = ENOENT;
+  return -1;
+}
+
+void ssm_rt_set_lateness_handler(ssm_rt_latenessf_t *handler)
+{
+  lateness_handler = handler;
+}
+
+ssm_rt_stats_t ssm_rt_stats(void) { return stats; }
+
+void ssm_rt_stop(void)
+{
+  __atomic_store_n(&stopping, true, __ATOMIC_RELAXED);
+  ssm_input_notify();
+}
+
+void ssm_rt_set_spin(ssm_time_t margin) { spin_margin = margin; }
+
+void ssm_rt_set_action_sink(ssm_action_sinkf_t *sink) { action_sink = sink; }
+
+void ssm_rt_set_collector(ssm_rt_collectf_t *collect) { collector = collect; }
+
+void ssm_rt_set_drain_handler(ssm_rt_drainedf_t *handler)
+{
+  drain_handler = handler;
+}
+
+int ssm_rt_realtime(int cpu, int fifo_priority)
+{
+  if (cpu >= 0) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) < 0) return -1;
+  }
+  if (mlockall(MCL_CURRENT | MCL_FUTURE) < 0) return -1;
+  if (fifo_priority > 0) {
+    struct sched_param param = { .sched_priority = fifo_priority };
+    if (sched_setscheduler(0, SCHED_FIFO, &param) < 0) return -1;
+  }
+  return 0;
+}
+
+/** Return true once ssm_rt_stop() has been called, from any thread */
+static inline bool stopped(void)
+{
+  return __atomic_load_n(&stopping, __ATOMIC_RELAXED);
+}
+
+/** Wake ssm_rt_run() after another thread posts an input */
+void ssm_input_notify(void)
+{
+  uint64_t one = 1;
+  if (notify_fd >= 0 && write(notify_fd, &one, sizeof(one)) < 0) {
+    // The counter is saturated, so a wakeup is already pending
+  }
+}
+
+/** Busy-wait until the wall time reaches the given model time */
+static void spin_until(ssm_time_t when)
+{
+  while (ssm_rt_wall_time() < when && !stopped()) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+  }
+}
+
+/** Arm the timer for the given model time, or disarm it for #SSM_NEVER */
+static void arm_timer(ssm_time_t when)
+{
+  struct itimerspec its = { 0 };
+  if (when != SSM_NEVER) {
+    its.it_value = to_wall(when);
+    if (its.it_value.tv_sec == 0 && its.it_value.tv_nsec == 0)
+      its.it_value.tv_nsec = 1; // Zero would disarm the timer
+  }
+  if (timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &its, 0) < 0)
+    SSM_THROW(SSM_SYSTEM_ERROR);
+}
+
+/** Run every instant whose time has passed and is before stop */
+static void run_due(ssm_time_t stop)
+{
+  for (;;) {
+    ssm_input_drain();
+    if (drain_handler) drain_handler();
+    ssm_time_t next = ssm_next_event_time();
+    if (next >= stop || stopped()) return;
+    if (next > ssm_rt_wall_time()) return;
+
+    if (collector) collector(next);
+    ssm_time_t late = ssm_rt_wall_time() - next; // Includes the collector
+    ssm_tick();
+    ssm_flush_actions(action_sink);
+
+    stats.instants++;
+    stats.total += late;
+    stats.last = late;
+    if (late > stats.max) stats.max = late;
+    if (lateness_handler) lateness_handler(next, late);
+  }
+}
+
+void ssm_rt_run(ssm_time_t stop)
+{
+  struct epoll_event events[SSM_RT_MAX_INPUTS + 1];
+
+  for (;;) {
+    run_due(stop);
+    if (stopped()) return;
+
+    ssm_time_t next = ssm_next_event_time();
+    ssm_time_t wake = next < stop ? next : stop;
+    if (wake == stop && stop != SSM_NEVER && ssm_rt_wall_time() >= stop)
+      return;
+    if (spin_margin && wake != SSM_NEVER) {
+      if (wake <= ssm_rt_wall_time() + spin_margin) {
+	spin_until(wake);
+	continue;
+      }
+      arm_timer(wake - spin_margin);
+    } else
+      arm_timer(wake);
+
+    int n = epoll_wait(epoll_fd, events, SSM_RT_MAX_INPUTS + 1, -1);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      SSM_THROW(SSM_SYSTEM_ERROR);
+    }
+    for (int i = 0 ; i < n && !stopped() ; i++) {
+      uint32_t tag = events[i].data.u32;
+      if (tag == TIMER_TAG || tag == NOTIFY_TAG) {
+	uint64_t count;
+	if (read(tag == TIMER_TAG ? timer_fd : notify_fd, &count,
+		 sizeof(count)) < 0 && errno != EAGAIN)
+	  SSM_THROW(SSM_SYSTEM_ERROR);
+      } else if (inputs[tag].fd >= 0)
+	inputs[tag].handler(inputs[tag].fd, inputs[tag].data);
+    }
+  }
+}
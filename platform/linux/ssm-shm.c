@@ -0,0 +1,353 @@
+#define _GNU_SOURCE
+#include "ssm-linux.h"
+
+#include <errno.h>
+#include <fcntl.h>     /* For O_* constants */
+#include <sched.h>     /* For sched_yield */
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/** Magic number at the start of every segment: "SSM1" */
+#define SSM_SHM_MAGIC 0x53534d31
+
+/** Rings are laid out so producer and consumer fields never share a line */
+#define CACHE_LINE 64
+
+/** Start of a shared-memory segment; followed by the rings */
+typedef struct {
+  uint32_t magic;
+  uint32_t partitions;  /**< Number of partitions */
+  uint32_t capacity;    /**< Messages in each ring; a power of two */
+  uint32_t unused;
+  uint64_t ring_bytes;  /**< Distance between consecutive rings */
+  uint64_t bytes;       /**< Size of the whole segment */
+} __attribute__((aligned(CACHE_LINE))) segment_t;
+
+/** Header of a ring from one partition to another; followed by messages
+ *
+ * head and tail count messages ever consumed and produced, so the ring is
+ * empty when they are equal and full when they differ by the capacity.
+ */
+typedef struct {
+  uint64_t head __attribute__((aligned(CACHE_LINE))); /**< Written by receiver */
+  uint64_t tail __attribute__((aligned(CACHE_LINE))); /**< Written by sender */
+  ssm_time_t clock __attribute__((aligned(CACHE_LINE))); /**< Sender's promise */
+  ssm_time_t lookahead; /**< Minimum delay of messages; #SSM_NEVER if unused */
+} ring_t;
+
+/** A message waiting in the receiver for its instant */
+typedef struct {
+  ssm_shm_msg_t msg;
+  uint32_t from;  /**< Sending partition; breaks ties between senders */
+  uint64_t seq;   /**< Position in the sender's ring; breaks remaining ties */
+} pending_t;
+
+/** Where messages for a variable number go */
+typedef struct {
+  ssm_sv_t *sv;
+  ssm_deliverf_t *deliver;
+} binding_t;
+
+struct ssm_shm {
+  segment_t *seg;
+  unsigned self;          /**< The partition this process runs */
+
+  binding_t *bindings;    /**< Indexed by variable number */
+  uint32_t bindings_len;
+
+  pending_t *pending;     /**< Binary heap of received messages; 1-based */
+  size_t pending_len;
+  size_t pending_size;
+
+  ssm_time_t safe;        /**< Safe time seen by the last ssm_shm_receive() */
+};
+
+static inline ring_t *ring(ssm_shm_t *shm, unsigned from, unsigned to)
+{
+  segment_t *seg = shm->seg;
+  return (ring_t *) ((char *) (seg + 1) +
+		     (from * seg->partitions + to) * seg->ring_bytes);
+}
+
+static inline ssm_shm_msg_t *slot(ssm_shm_t *shm, ring_t *r, uint64_t pos)
+{
+  return (ssm_shm_msg_t *) (r + 1) + (pos & (shm->seg->capacity - 1));
+}
+
+static inline ssm_time_t add_time(ssm_time_t t, ssm_time_t d)
+{
+  return t >= SSM_NEVER - d ? SSM_NEVER : t + d;
+}
+
+static ssm_shm_t *map_segment(int fd, size_t bytes, unsigned self)
+{
+  ssm_shm_t *shm = calloc(1, sizeof(ssm_shm_t));
+  if (!shm) return 0;
+  void *base = mmap(0, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (base == MAP_FAILED) {
+    free(shm);
+    return 0;
+  }
+  shm->seg = base;
+  shm->self = self;
+  shm->safe = 0;
+  return shm;
+}
+
+ssm_shm_t *ssm_shm_create(const char *name, unsigned partitions,
+			  unsigned capacity)
+{
+  assert(name);
+  if (partitions == 0 || capacity == 0 || (capacity & (capacity - 1))) {
+    errno = EINVAL;
+    return 0;
+  }
+
+  size_t ring_bytes = sizeof(ring_t) + capacity * sizeof(ssm_shm_msg_t);
+  ring_bytes = (ring_bytes + CACHE_LINE - 1) & ~(size_t) (CACHE_LINE - 1);
+  size_t bytes = sizeof(segment_t) + partitions * partitions * ring_bytes;
+
+  int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0) return 0;
+  if (ftruncate(fd, bytes) < 0) {
+    close(fd);
+    shm_unlink(name);
+    return 0;
+  }
+  ssm_shm_t *shm = map_segment(fd, bytes, 0);
+  close(fd);
+  if (!shm) {
+    shm_unlink(name);
+    return 0;
+  }
+
+  /* ftruncate zeroed everything, so heads, tails, and clocks start at 0 */
+  *shm->seg = (segment_t) {
+    .magic = SSM_SHM_MAGIC,
+    .partitions = partitions,
+    .capacity = capacity,
+    .ring_bytes = ring_bytes,
+    .bytes = bytes
+  };
+  for (unsigned from = 0 ; from < partitions ; from++)
+    for (unsigned to = 0 ; to < partitions ; to++)
+      ring(shm, from, to)->lookahead = SSM_NEVER;
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  return shm;
+}
+
+ssm_shm_t *ssm_shm_attach(const char *name, unsigned self)
+{
+  assert(name);
+  int fd = shm_open(name, O_RDWR, 0);
+  if (fd < 0) return 0;
+  struct stat st;
+  if (fstat(fd, &st) < 0 || (size_t) st.st_size < sizeof(segment_t)) {
+    close(fd);
+    errno = EINVAL;
+    return 0;
+  }
+  ssm_shm_t *shm = map_segment(fd, st.st_size, self);
+  close(fd);
+  if (!shm) return 0;
+  if (shm->seg->magic != SSM_SHM_MAGIC || self >= shm->seg->partitions) {
+    ssm_shm_detach(shm);
+    errno = EINVAL;
+    return 0;
+  }
+  return shm;
+}
+
+void ssm_shm_detach(ssm_shm_t *shm)
+{
+  assert(shm);
+  munmap(shm->seg, shm->seg->bytes);
+  free(shm->bindings);
+  free(shm->pending);
+  free(shm);
+}
+
+int ssm_shm_unlink(const char *name)
+{
+  return shm_unlink(name);
+}
+
+void ssm_shm_set_lookahead(ssm_shm_t *shm, unsigned from, unsigned to,
+			   ssm_time_t lookahead)
+{
+  assert(shm);
+  assert(from < shm->seg->partitions && to < shm->seg->partitions);
+  assert(from != to);
+  assert(lookahead > 0); // Zero lookahead could deadlock a cycle
+  ring(shm, from, to)->lookahead = lookahead;
+}
+
+void ssm_shm_bind(ssm_shm_t *shm, uint32_t var, ssm_sv_t *sv,
+		  ssm_deliverf_t *deliver)
+{
+  assert(shm);
+  assert(sv);
+  assert(deliver);
+  if (var >= shm->bindings_len) {
+    uint32_t len = shm->bindings_len ? shm->bindings_len : 16;
+    while (len <= var) len <<= 1;
+    binding_t *b = realloc(shm->bindings, len * sizeof(binding_t));
+    if (!b) SSM_THROW(SSM_EXHAUSTED_MEMORY);
+    for (uint32_t i = shm->bindings_len ; i < len ; i++)
+      b[i] = (binding_t) { 0, 0 };
+    shm->bindings = b;
+    shm->bindings_len = len;
+  }
+  shm->bindings[var] = (binding_t) { sv, deliver };
+}
+
+void ssm_shm_send(ssm_shm_t *shm, unsigned to, uint32_t var, ssm_time_t then,
+		  const void *payload, size_t size)
+{
+  assert(shm);
+  assert(size <= sizeof(uint64_t));
+  ring_t *r = ring(shm, shm->self, to);
+  assert(r->lookahead != SSM_NEVER); // Channel must be declared
+  if (then < add_time(ssm_now(), r->lookahead))
+    SSM_THROW(SSM_INVALID_TIME);
+
+  uint64_t tail = r->tail; // Only we write it
+  if (tail - __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) ==
+      shm->seg->capacity)
+    SSM_THROW(SSM_EXHAUSTED_RING);
+
+  ssm_shm_msg_t *m = slot(shm, r, tail);
+  m->time = then;
+  m->var = var;
+  m->size = size;
+  m->payload = 0;
+  memcpy(&m->payload, payload, size);
+  __atomic_store_n(&r->tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+ssm_time_t ssm_shm_safe_time(ssm_shm_t *shm)
+{
+  assert(shm);
+  ssm_time_t safe = SSM_NEVER;
+  for (unsigned from = 0 ; from < shm->seg->partitions ; from++) {
+    ring_t *r = ring(shm, from, shm->self);
+    if (r->lookahead == SSM_NEVER) continue;
+    ssm_time_t clock = __atomic_load_n(&r->clock, __ATOMIC_ACQUIRE);
+    if (clock < safe) safe = clock;
+  }
+  return safe;
+}
+
+/** True if pending message a should be delivered before b */
+static inline bool pending_before(pending_t *a, pending_t *b)
+{
+  if (a->msg.time != b->msg.time) return a->msg.time < b->msg.time;
+  if (a->from != b->from) return a->from < b->from;
+  return a->seq < b->seq;
+}
+
+static void pending_push(ssm_shm_t *shm, pending_t *p)
+{
+  if (shm->pending_len + 1 >= shm->pending_size) {
+    size_t size = shm->pending_size ? shm->pending_size << 1 : 64;
+    pending_t *heap = realloc(shm->pending, size * sizeof(pending_t));
+    if (!heap) SSM_THROW(SSM_EXHAUSTED_MEMORY);
+    shm->pending = heap;
+    shm->pending_size = size;
+  }
+  size_t hole = ++shm->pending_len;
+  for ( ; hole > 1 && pending_before(p, &shm->pending[hole >> 1]) ;
+	hole >>= 1)
+    shm->pending[hole] = shm->pending[hole >> 1];
+  shm->pending[hole] = *p;
+}
+
+static void pending_pop(ssm_shm_t *shm)
+{
+  pending_t *heap = shm->pending;
+  pending_t last = heap[shm->pending_len--];
+  size_t hole = 1;
+  for (;;) {
+    size_t child = hole << 1;
+    if (child > shm->pending_len) break;
+    if (child + 1 <= shm->pending_len &&
+	pending_before(&heap[child + 1], &heap[child]))
+      child++;
+    if (pending_before(&last, &heap[child])) break;
+    heap[hole] = heap[child];
+    hole = child;
+  }
+  heap[hole] = last;
+}
+
+/** Time of the next instant this partition knows about */
+static inline ssm_time_t next_instant(ssm_shm_t *shm)
+{
+  ssm_time_t next = ssm_next_event_time();
+  if (shm->pending_len && shm->pending[1].msg.time < next)
+    next = shm->pending[1].msg.time;
+  return next;
+}
+
+bool ssm_shm_receive(ssm_shm_t *shm)
+{
+  assert(shm);
+
+  /* Read the clocks before the rings: every message sent before a clock
+     was published is then visible, and later ones are no earlier. */
+  shm->safe = ssm_shm_safe_time(shm);
+
+  for (unsigned from = 0 ; from < shm->seg->partitions ; from++) {
+    ring_t *r = ring(shm, from, shm->self);
+    if (r->lookahead == SSM_NEVER) continue;
+    uint64_t head = r->head; // Only we write it
+    uint64_t tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+    for ( ; head != tail ; head++) {
+      pending_t p = { .msg = *slot(shm, r, head), .from = from, .seq = head };
+      pending_push(shm, &p);
+    }
+    __atomic_store_n(&r->head, head, __ATOMIC_RELEASE);
+  }
+
+  ssm_time_t next = next_instant(shm);
+  if (next >= shm->safe) return false;
+
+  while (shm->pending_len && shm->pending[1].msg.time == next) {
+    ssm_shm_msg_t *m = &shm->pending[1].msg;
+    assert(m->var < shm->bindings_len && shm->bindings[m->var].deliver);
+    binding_t *b = &shm->bindings[m->var];
+    (*b->deliver)(b->sv, m->time, &m->payload);
+    pending_pop(shm);
+  }
+  return true;
+}
+
+void ssm_shm_publish(ssm_shm_t *shm)
+{
+  assert(shm);
+  ssm_time_t next = next_instant(shm);
+  if (shm->safe < next) next = shm->safe;
+  for (unsigned to = 0 ; to < shm->seg->partitions ; to++) {
+    ring_t *r = ring(shm, shm->self, to);
+    if (r->lookahead == SSM_NEVER) continue;
+    __atomic_store_n(&r->clock, add_time(next, r->lookahead),
+		     __ATOMIC_RELEASE);
+  }
+}
+
+void ssm_shm_run(ssm_shm_t *shm, ssm_time_t stop)
+{
+  assert(shm);
+  for (;;) {
+    bool progress = false;
+    while (ssm_shm_receive(shm) && ssm_next_event_time() < stop) {
+      ssm_tick();
+      progress = true;
+    }
+    ssm_shm_publish(shm);
+
+    if (next_instant(shm) >= stop && shm->safe >= stop) return;
+    if (!progress) sched_yield();
+  }
+}
@@ -0,0 +1,155 @@
+#define _GNU_SOURCE
+#include "ssm-linux.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/** Bytes consumed before releasing their pages of the mapping */
+#define RELEASE_BYTES (16 << 20)
+
+/** A mapped stimulus file */
+typedef struct {
+  const ssm_stimulus_record_t *records;
+  size_t count;
+  size_t next;               /**< Index of the next record to deliver */
+  size_t released;           /**< Records whose pages have been released */
+} stream_t;
+
+/** Where records for a variable id go */
+typedef struct {
+  ssm_sv_t *var;
+  ssm_deliverf_t *deliver;
+} binding_t;
+
+static stream_t streams[SSM_STIMULUS_MAX_STREAMS];
+static unsigned stream_count = 0;
+
+static binding_t *bindings = 0;  /**< Indexed by variable id */
+static uint32_t bindings_len = 0;
+
+int ssm_stimulus_open(const char *path)
+{
+  if (stream_count == SSM_STIMULUS_MAX_STREAMS) {
+    errno = EMFILE;
+    return -1;
+  }
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return -1;
+  struct stat st;
+  if (fstat(fd, &st) < 0) {
+    close(fd);
+    return -1;
+  }
+  if (st.st_size % sizeof(ssm_stimulus_record_t)) {
+    close(fd);
+    errno = EINVAL;
+    return -1;
+  }
+
+  stream_t *s = &streams[stream_count];
+  *s = (stream_t) { 0, st.st_size / sizeof(ssm_stimulus_record_t), 0, 0 };
+  if (s->count) {
+    void *map = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+      int e = errno;
+      close(fd);
+      errno = e;
+      return -1;
+    }
+    madvise(map, st.st_size, MADV_SEQUENTIAL);
+    s->records = map;
+  }
+  close(fd); // The mapping keeps the file open
+  stream_count++;
+  return 0;
+}
+
+void ssm_stimulus_bind(uint32_t id, ssm_sv_t *var, ssm_deliverf_t *deliver)
+{
+  assert(var);
+  assert(deliver);
+  if (id >= bindings_len) {
+    uint32_t len = bindings_len ? bindings_len : 16;
+    while (len <= id) len <<= 1;
+    binding_t *b = realloc(bindings, len * sizeof(binding_t));
+    if (!b) SSM_THROW(SSM_EXHAUSTED_MEMORY);
+    for (uint32_t i = bindings_len ; i < len ; i++)
+      b[i] = (binding_t) { 0, 0 };
+    bindings = b;
+    bindings_len = len;
+  }
+  bindings[id] = (binding_t) { var, deliver };
+}
+
+/** Return the stream whose next record is earliest, or 0 if all are done */
+static stream_t *earliest(void)
+{
+  stream_t *best = 0;
+  for (stream_t *s = streams ; s < streams + stream_count ; s++)
+    if (s->next < s->count &&
+	(!best || s->records[s->next].time < best->records[best->next].time))
+      best = s;
+  return best;
+}
+
+/** Step past a stream's next record, releasing the pages behind it */
+static void advance(stream_t *s)
+{
+  s->next++;
+  size_t behind = (s->next - s->released) * sizeof(ssm_stimulus_record_t);
+  if (behind >= RELEASE_BYTES) {
+    uintptr_t page = sysconf(_SC_PAGESIZE);
+    uintptr_t start = (uintptr_t) (s->records + s->released) & ~(page - 1);
+    uintptr_t end = (uintptr_t) (s->records + s->next) & ~(page - 1);
+    madvise((void *) start, end - start, MADV_DONTNEED);
+    s->released = s->next;
+  }
+}
+
+size_t ssm_stimulus_feed(void)
+{
+  size_t delivered = 0;
+  stream_t *s;
+  while ((s = earliest())) {
+    const ssm_stimulus_record_t *r = &s->records[s->next];
+    binding_t *b = r->id < bindings_len ? &bindings[r->id] : 0;
+    if (!b || !b->deliver) {
+      advance(s);
+      continue;
+    }
+    ssm_time_t then = r->time > ssm_now() ? r->time : ssm_now() + 1;
+    ssm_resolve(b->var);
+    if (b->var->later_time < then) {
+      /* Would replace an earlier pending update; as in ssm_input_drain() */
+      if (b->var->later_time < ssm_next_event_time())
+	ssm_schedule_instant(b->var->later_time);
+      break;
+    }
+    if (then > ssm_next_event_time())
+      break; // Not due until after the next instant
+    b->deliver(b->var, then, &r->payload);
+    advance(s);
+    delivered++;
+  }
+  return delivered;
+}
+
+bool ssm_stimulus_pending(void)
+{
+  return earliest() != 0;
+}
+
+void ssm_stimulus_close(void)
+{
+  for (stream_t *s = streams ; s < streams + stream_count ; s++)
+    if (s->records)
+      munmap((void *) s->records, s->count * sizeof(ssm_stimulus_record_t));
+  stream_count = 0;
+  free(bindings);
+  bindings = 0;
+  bindings_len = 0;
+}
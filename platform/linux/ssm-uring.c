@@ -0,0 +1,233 @@
+#define _GNU_SOURCE
+#include "ssm-linux.h"
+
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/* io_uring through its system calls directly, without liburing */
+
+static int ring_fd = -1;
+static bool polled = false;    /**< Using a kernel submission thread */
+static unsigned sq_entries;
+
+/* Submission queue, shared with the kernel */
+static void *sq_map;
+static size_t sq_map_size;
+static unsigned *sq_head, *sq_tail, *sq_mask, *sq_flags, *sq_array;
+static struct io_uring_sqe *sqes;
+static size_t sqes_size;
+
+/* Completion queue, shared with the kernel */
+static void *cq_map;
+static size_t cq_map_size;
+static unsigned *cq_head, *cq_tail, *cq_mask;
+static struct io_uring_cqe *cqes;
+
+/* The tick thread queues operations and the thread performing deferred
+   actions, possibly the I/O thread, submits them.  `submitted` is the
+   submission queue tail as of the last submit; `submit_deferred` is set
+   while a submit action is queued and cleared before the submit reads
+   the tail, so every operation is either seen by a pending submit or
+   queues a new one. */
+static unsigned submitted = 0;
+static bool submit_deferred = false;
+
+/** True while completions wait for room in the input ring; the ring is
+    then not watched, since level-triggered epoll would report it forever */
+static bool backpressured = false;
+
+static void uring_input(int fd, void *data) { ssm_uring_reap(); }
+
+static void uring_drained(void) { ssm_uring_reap(); }
+
+static void submit_action(void *data, uint64_t arg) { ssm_uring_submit(); }
+
+int ssm_uring_init(unsigned entries, bool sqpoll)
+{
+  struct io_uring_params p = { 0 };
+  if (sqpoll) {
+    p.flags = IORING_SETUP_SQPOLL;
+    p.sq_thread_idle = 1000; // Milliseconds before the poller sleeps
+  }
+  ssm_uring_close();
+  ring_fd = syscall(__NR_io_uring_setup, entries, &p);
+  if (ring_fd < 0) return -1;
+  polled = sqpoll;
+  sq_entries = p.sq_entries;
+
+  sq_map_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  cq_map_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  bool single = p.features & IORING_FEAT_SINGLE_MMAP;
+  if (single && cq_map_size > sq_map_size) sq_map_size = cq_map_size;
+
+  sq_map = mmap(0, sq_map_size, PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+  if (sq_map == MAP_FAILED) goto fail;
+  cq_map = single ? sq_map
+    : mmap(0, cq_map_size, PROT_READ | PROT_WRITE,
+	   MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+  if (cq_map == MAP_FAILED) goto fail;
+  sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+  sqes = mmap(0, sqes_size, PROT_READ | PROT_WRITE,
+	      MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) goto fail;
+
+  unsigned char *sq = sq_map, *cq = cq_map;
+  sq_head = (unsigned *) (sq + p.sq_off.head);
+  sq_tail = (unsigned *) (sq + p.sq_off.tail);
+  sq_mask = (unsigned *) (sq + p.sq_off.ring_mask);
+  sq_flags = (unsigned *) (sq + p.sq_off.flags);
+  sq_array = (unsigned *) (sq + p.sq_off.array);
+  cq_head = (unsigned *) (cq + p.cq_off.head);
+  cq_tail = (unsigned *) (cq + p.cq_off.tail);
+  cq_mask = (unsigned *) (cq + p.cq_off.ring_mask);
+  cqes = (struct io_uring_cqe *) (cq + p.cq_off.cqes);
+  submitted = *sq_tail;
+  submit_deferred = false;
+  backpressured = false;
+
+  if (ssm_rt_add_input(ring_fd, uring_input, 0) < 0) goto fail;
+  return 0;
+
+ fail: {
+    int e = errno;
+    ssm_uring_close();
+    errno = e;
+    return -1;
+  }
+}
+
+void ssm_uring_close(void)
+{
+  if (ring_fd < 0) return;
+  if (backpressured)
+    ssm_rt_set_drain_handler(0);
+  else
+    ssm_rt_remove_input(ring_fd);
+  if (sqes && sqes != MAP_FAILED) munmap(sqes, sqes_size);
+  if (cq_map && cq_map != MAP_FAILED && cq_map != sq_map)
+    munmap(cq_map, cq_map_size);
+  if (sq_map && sq_map != MAP_FAILED) munmap(sq_map, sq_map_size);
+  sqes = 0;
+  sq_map = cq_map = 0;
+  close(ring_fd);
+  ring_fd = -1;
+}
+
+int ssm_uring_register_buffers(const struct iovec *iovecs, unsigned count)
+{
+  return syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_BUFFERS,
+		 iovecs, count) < 0 ? -1 : 0;
+}
+
+/** Queue an operation; false if the submission queue is full */
+static bool queue(uint8_t opcode, int fd, const void *buf, size_t len,
+		  uint64_t offset, int index, ssm_i64_t *result)
+{
+  assert(ring_fd >= 0);
+  assert(result);
+  unsigned tail = *sq_tail; // Only we write the tail
+  if (tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) == sq_entries)
+    return false;
+
+  unsigned i = tail & *sq_mask;
+  struct io_uring_sqe *sqe = &sqes[i];
+  *sqe = (struct io_uring_sqe) {
+    .opcode = opcode,
+    .fd = fd,
+    .off = offset,
+    .addr = (uint64_t) (uintptr_t) buf,
+    .len = len,
+    .user_data = (uint64_t) (uintptr_t) result
+  };
+  if (index >= 0) sqe->buf_index = index;
+  sq_array[i] = i;
+  __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+  if (!__atomic_exchange_n(&submit_deferred, true, __ATOMIC_SEQ_CST))
+    ssm_defer(submit_action, 0, 0); // Submit the instant's batch after it
+  return true;
+}
+
+bool ssm_uring_read(int fd, void *buf, size_t len, uint64_t offset,
+		    ssm_i64_t *result)
+{
+  return queue(IORING_OP_READ, fd, buf, len, offset, -1, result);
+}
+
+bool ssm_uring_write(int fd, const void *buf, size_t len, uint64_t offset,
+		     ssm_i64_t *result)
+{
+  return queue(IORING_OP_WRITE, fd, buf, len, offset, -1, result);
+}
+
+bool ssm_uring_read_fixed(int fd, unsigned index, void *buf, size_t len,
+			  uint64_t offset, ssm_i64_t *result)
+{
+  return queue(IORING_OP_READ_FIXED, fd, buf, len, offset, index, result);
+}
+
+bool ssm_uring_write_fixed(int fd, unsigned index, const void *buf,
+			   size_t len, uint64_t offset, ssm_i64_t *result)
+{
+  return queue(IORING_OP_WRITE_FIXED, fd, buf, len, offset, index, result);
+}
+
+void ssm_uring_submit(void)
+{
+  __atomic_store_n(&submit_deferred, false, __ATOMIC_SEQ_CST);
+  unsigned tail = __atomic_load_n(sq_tail, __ATOMIC_SEQ_CST);
+  unsigned to_submit =
+    tail - __atomic_exchange_n(&submitted, tail, __ATOMIC_ACQ_REL);
+  if (!to_submit) return;
+  unsigned flags = 0;
+  if (polled) {
+    /* The kernel thread picks up the new tail; wake it if it dozed off */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (!(__atomic_load_n(sq_flags, __ATOMIC_RELAXED) &
+	  IORING_SQ_NEED_WAKEUP))
+      return;
+    flags = IORING_ENTER_SQ_WAKEUP;
+  }
+  long r;
+  do
+    r = syscall(__NR_io_uring_enter, ring_fd, to_submit, 0, flags, 0, 0);
+  while (r < 0 && (errno == EINTR || errno == EAGAIN || errno == EBUSY));
+  if (r < 0) SSM_THROW(SSM_SYSTEM_ERROR);
+}
+
+size_t ssm_uring_reap(void)
+{
+  size_t reaped = 0;
+  unsigned head = *cq_head; // Only we write the head
+  unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+  bool full = false;
+
+  ssm_time_t then = head != tail ? ssm_rt_wall_time() : 0;
+  for ( ; head != tail ; head++, reaped++) {
+    struct io_uring_cqe *cqe = &cqes[head & *cq_mask];
+    ssm_i64_t *result = (ssm_i64_t *) (uintptr_t) cqe->user_data;
+    i64 res = cqe->res;
+    if (!ssm_input_post(&result->sv, ssm_deliver_i64, then, &res,
+			sizeof(res))) {
+      full = true;
+      break;
+    }
+  }
+  __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+
+  if (full && !backpressured) { // Try again once the input ring drains
+    backpressured = true;
+    if (ssm_rt_remove_input(ring_fd) < 0) SSM_THROW(SSM_SYSTEM_ERROR);
+    ssm_rt_set_drain_handler(uring_drained);
+  } else if (!full && backpressured) { // Caught up; watch the ring again
+    backpressured = false;
+    ssm_rt_set_drain_handler(0);
+    if (ssm_rt_add_input(ring_fd, uring_input, 0) < 0)
+      SSM_THROW(SSM_SYSTEM_ERROR);
+  }
+  return reaped;
+}
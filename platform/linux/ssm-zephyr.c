@@ -0,0 +1,400 @@
+#define _GNU_SOURCE
+#include "zephyr/zephyr.h"
+#include "zephyr/drivers/counter.h"
+
+#include <assert.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Emulation of the Zephyr kernel and counter API on POSIX threads */
+
+/** Nanoseconds in a second */
+#define NS_PER_SEC 1000000000LL
+
+#define COUNTER_TOP UINT32_MAX
+
+static int64_t mono_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+}
+
+static struct timespec to_timespec(int64_t ns)
+{
+  struct timespec ts = { .tv_sec = ns / NS_PER_SEC, .tv_nsec = ns % NS_PER_SEC };
+  return ts;
+}
+
+/*** Kernel */
+
+static int64_t boot_ns;
+
+static void __attribute__((constructor)) boot(void) { boot_ns = mono_ns(); }
+
+int64_t k_uptime_get(void) { return (mono_ns() - boot_ns) / 1000000; }
+
+int32_t k_sleep(k_timeout_t timeout)
+{
+  if (timeout.ns < 0)
+    for (;;) pause();
+  struct timespec ts = to_timespec(mono_ns() + timeout.ns);
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, 0) == EINTR)
+    ;
+  return 0;
+}
+
+void printk(const char *fmt, ...)
+{
+  va_list args;
+  va_start(args, fmt);
+  vprintf(fmt, args);
+  va_end(args);
+}
+
+static void *thread_main(void *arg)
+{
+  struct k_thread *t = arg;
+  t->entry(t->p1, t->p2, t->p3);
+  return 0;
+}
+
+k_tid_t k_thread_create(struct k_thread *thread, char *stack,
+			size_t stack_size, k_thread_entry_t entry,
+			void *p1, void *p2, void *p3,
+			int prio, uint32_t options, k_timeout_t delay)
+{
+  assert(thread);
+  assert(entry);
+  assert(delay.ns == 0);
+  thread->entry = entry;
+  thread->p1 = p1;
+  thread->p2 = p2;
+  thread->p3 = p3;
+  return pthread_create(&thread->thread, 0, thread_main, thread) ? 0 : thread;
+}
+
+int k_thread_join(struct k_thread *thread, k_timeout_t timeout)
+{
+  if (timeout.ns >= 0) return -EAGAIN;
+  pthread_join(thread->thread, 0);
+  return 0;
+}
+
+/*** Message queues */
+
+void k_msgq_init(struct k_msgq *q, char *buffer, size_t msg_size,
+		 uint32_t max_msgs)
+{
+  q->buffer = buffer;
+  q->msg_size = msg_size;
+  q->max_msgs = max_msgs;
+  q->read = q->used = 0;
+  pthread_mutex_init(&q->lock, 0);
+  pthread_cond_init(&q->changed, 0);
+}
+
+/** Wait on the queue until `deadline` on the real-time clock; false at
+ * the deadline.  Call with the lock held. */
+static bool msgq_wait(struct k_msgq *q, k_timeout_t timeout,
+		      const struct timespec *deadline)
+{
+  if (timeout.ns < 0) {
+    pthread_cond_wait(&q->changed, &q->lock);
+    return true;
+  }
+  return pthread_cond_timedwait(&q->changed, &q->lock, deadline) != ETIMEDOUT;
+}
+
+/** Return when a wait of `timeout` from now ends on the real-time clock,
+ * which the queues' default condition variables use */
+static struct timespec msgq_deadline(k_timeout_t timeout)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  return to_timespec(now.tv_sec * NS_PER_SEC + now.tv_nsec +
+		     (timeout.ns > 0 ? timeout.ns : 0));
+}
+
+int k_msgq_put(struct k_msgq *q, const void *data, k_timeout_t timeout)
+{
+  struct timespec deadline = msgq_deadline(timeout);
+  pthread_mutex_lock(&q->lock);
+  while (q->used == q->max_msgs) {
+    if (timeout.ns == 0 || !msgq_wait(q, timeout, &deadline)) {
+      pthread_mutex_unlock(&q->lock);
+      return timeout.ns == 0 ? -ENOMSG : -EAGAIN;
+    }
+  }
+  uint32_t slot = (q->read + q->used) % q->max_msgs;
+  memcpy(q->buffer + slot * q->msg_size, data, q->msg_size);
+  q->used++;
+  pthread_cond_broadcast(&q->changed);
+  pthread_mutex_unlock(&q->lock);
+  return 0;
+}
+
+int k_msgq_get(struct k_msgq *q, void *data, k_timeout_t timeout)
+{
+  struct timespec deadline = msgq_deadline(timeout);
+  pthread_mutex_lock(&q->lock);
+  while (q->used == 0) {
+    if (timeout.ns == 0 || !msgq_wait(q, timeout, &deadline)) {
+      pthread_mutex_unlock(&q->lock);
+      return timeout.ns == 0 ? -ENOMSG : -EAGAIN;
+    }
+  }
+  memcpy(data, q->buffer + q->read * q->msg_size, q->msg_size);
+  q->read = (q->read + 1) % q->max_msgs;
+  q->used--;
+  pthread_cond_broadcast(&q->changed);
+  pthread_mutex_unlock(&q->lock);
+  return 0;
+}
+
+uint32_t k_msgq_num_used_get(struct k_msgq *q)
+{
+  pthread_mutex_lock(&q->lock);
+  uint32_t used = q->used;
+  pthread_mutex_unlock(&q->lock);
+  return used;
+}
+
+void k_msgq_purge(struct k_msgq *q)
+{
+  pthread_mutex_lock(&q->lock);
+  q->read = q->used = 0;
+  pthread_cond_broadcast(&q->changed);
+  pthread_mutex_unlock(&q->lock);
+}
+
+/*** Counter
+ *
+ * A free-running 32-bit counter derived from CLOCK_MONOTONIC.  A thread
+ * stands in for the alarm interrupt: it sleeps until the armed alarm's
+ * expiry and makes its callback.
+ */
+
+typedef struct {
+  bool running;
+  int64_t start_ns;          /**< Monotonic time of count 0 */
+  uint32_t guard;
+  uint32_t guard_flags;
+
+  bool armed;
+  struct counter_alarm_cfg alarm;
+  int64_t expiry_ns;         /**< Monotonic time the armed alarm expires */
+
+  bool quitting;
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t changed;    /**< Timed on CLOCK_MONOTONIC */
+  struct counter_emu_stats stats;
+} counter_t;
+
+static counter_t counter = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static const struct device counter_dev = { .name = "SSM_TIMER",
+					   .data = &counter };
+
+const struct device *device_get_binding(const char *name)
+{
+  return name && !strcmp(name, counter_dev.name) ? &counter_dev : 0;
+}
+
+/** Return the counter's value at monotonic time `ns`, without wrapping */
+static uint64_t ticks_at(const counter_t *c, int64_t ns)
+{
+  int64_t elapsed = ns - c->start_ns;
+  return (elapsed / NS_PER_SEC) * SSM_ZEPHYR_COUNTER_FREQUENCY +
+    (elapsed % NS_PER_SEC) * SSM_ZEPHYR_COUNTER_FREQUENCY / NS_PER_SEC;
+}
+
+/** Return the monotonic time at which the counter reaches `ticks` */
+static int64_t ns_at(const counter_t *c, uint64_t ticks)
+{
+  return c->start_ns + (int64_t) (ticks / SSM_ZEPHYR_COUNTER_FREQUENCY) *
+    NS_PER_SEC + ((int64_t) (ticks % SSM_ZEPHYR_COUNTER_FREQUENCY) *
+		  NS_PER_SEC + SSM_ZEPHYR_COUNTER_FREQUENCY - 1) /
+    SSM_ZEPHYR_COUNTER_FREQUENCY;
+}
+
+static void *alarm_thread(void *arg)
+{
+  counter_t *c = arg;
+  pthread_mutex_lock(&c->lock);
+  while (!c->quitting) {
+    if (!c->armed) {
+      pthread_cond_wait(&c->changed, &c->lock);
+      continue;
+    }
+    int64_t now = mono_ns();
+    if (now < c->expiry_ns) {
+      struct timespec ts = to_timespec(c->expiry_ns);
+      pthread_cond_timedwait(&c->changed, &c->lock, &ts);
+      continue;
+    }
+
+    /* Disarm before the callback so it may set the next alarm */
+    struct counter_alarm_cfg alarm = c->alarm;
+    uint64_t delay = now - c->expiry_ns;
+    c->armed = false;
+    c->stats.fired++;
+    c->stats.total_delay_ns += delay;
+    if (delay > c->stats.max_delay_ns) c->stats.max_delay_ns = delay;
+    uint32_t value = (uint32_t) ticks_at(c, now);
+    pthread_mutex_unlock(&c->lock);
+    if (alarm.callback)
+      alarm.callback(&counter_dev, 0, value, alarm.user_data);
+    pthread_mutex_lock(&c->lock);
+  }
+  pthread_mutex_unlock(&c->lock);
+  return 0;
+}
+
+int counter_start(const struct device *dev)
+{
+  counter_t *c = dev->data;
+  pthread_mutex_lock(&c->lock);
+  if (c->running) {
+    pthread_mutex_unlock(&c->lock);
+    return -EALREADY;
+  }
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(&c->changed, &attr);
+  pthread_condattr_destroy(&attr);
+  c->start_ns = mono_ns();
+  c->armed = c->quitting = false;
+  memset(&c->stats, 0, sizeof(c->stats));
+  int r = pthread_create(&c->thread, 0, alarm_thread, c);
+  c->running = !r;
+  pthread_mutex_unlock(&c->lock);
+  return -r;
+}
+
+int counter_stop(const struct device *dev)
+{
+  counter_t *c = dev->data;
+  pthread_mutex_lock(&c->lock);
+  if (!c->running) {
+    pthread_mutex_unlock(&c->lock);
+    return 0;
+  }
+  c->quitting = true;
+  c->armed = false;
+  pthread_cond_broadcast(&c->changed);
+  pthread_mutex_unlock(&c->lock);
+  pthread_join(c->thread, 0);
+  c->running = false;
+  pthread_cond_destroy(&c->changed);
+  return 0;
+}
+
+int counter_get_value(const struct device *dev, uint32_t *ticks)
+{
+  *ticks = (uint32_t) ticks_at(dev->data, mono_ns());
+  return 0;
+}
+
+uint32_t counter_get_frequency(const struct device *dev)
+{
+  return SSM_ZEPHYR_COUNTER_FREQUENCY;
+}
+
+uint32_t counter_get_top_value(const struct device *dev) { return COUNTER_TOP; }
+
+uint8_t counter_get_num_of_channels(const struct device *dev) { return 1; }
+
+int counter_set_guard_period(const struct device *dev, uint32_t ticks,
+			     uint32_t flags)
+{
+  counter_t *c = dev->data;
+  pthread_mutex_lock(&c->lock);
+  c->guard = ticks;
+  c->guard_flags = flags;
+  pthread_mutex_unlock(&c->lock);
+  return 0;
+}
+
+int counter_set_channel_alarm(const struct device *dev, uint8_t chan_id,
+			      const struct counter_alarm_cfg *alarm_cfg)
+{
+  counter_t *c = dev->data;
+  if (chan_id != 0) return -ENOTSUP;
+  // Every 32-bit ticks value is at or below the top, so none is -EINVAL
+
+  pthread_mutex_lock(&c->lock);
+  if (c->armed) {
+    c->stats.busy++;
+    pthread_mutex_unlock(&c->lock);
+    return -EBUSY;
+  }
+  c->stats.set++;
+
+  int64_t now = mono_ns();
+  uint64_t value = ticks_at(c, now);
+  uint32_t ahead = alarm_cfg->ticks; // Ticks until the alarm expires
+  int r = 0;
+  if (alarm_cfg->flags & COUNTER_ALARM_CFG_ABSOLUTE) {
+    uint32_t behind = (uint32_t) value - alarm_cfg->ticks;
+    ahead = alarm_cfg->ticks - (uint32_t) value;
+    if ((c->guard_flags & COUNTER_GUARD_PERIOD_LATE_TO_SET) &&
+	behind < c->guard) {
+      c->stats.late++;
+      r = -ETIME;
+      ahead = 0;
+    }
+  }
+
+  if (r == 0 || (alarm_cfg->flags & COUNTER_ALARM_CFG_EXPIRE_WHEN_LATE)) {
+    c->alarm = *alarm_cfg;
+    c->expiry_ns = ahead ? ns_at(c, value + ahead) : now;
+    c->armed = true;
+    pthread_cond_broadcast(&c->changed);
+  }
+  pthread_mutex_unlock(&c->lock);
+  return r;
+}
+
+int counter_cancel_channel_alarm(const struct device *dev, uint8_t chan_id)
+{
+  counter_t *c = dev->data;
+  if (chan_id != 0) return -ENOTSUP;
+  pthread_mutex_lock(&c->lock);
+  c->armed = false;
+  pthread_cond_broadcast(&c->changed);
+  pthread_mutex_unlock(&c->lock);
+  return 0;
+}
+
+uint32_t counter_us_to_ticks(const struct device *dev, uint64_t us)
+{
+  return (uint32_t) (us * SSM_ZEPHYR_COUNTER_FREQUENCY / 1000000);
+}
+
+uint64_t counter_ticks_to_us(const struct device *dev, uint32_t ticks)
+{
+  return (uint64_t) ticks * 1000000 / SSM_ZEPHYR_COUNTER_FREQUENCY;
+}
+
+void counter_emu_get_stats(const struct device *dev,
+			   struct counter_emu_stats *stats)
+{
+  counter_t *c = dev->data;
+  pthread_mutex_lock(&c->lock);
+  *stats = c->stats;
+  pthread_mutex_unlock(&c->lock);
+}
+
+void counter_emu_reset_stats(const struct device *dev)
+{
+  counter_t *c = dev->data;
+  pthread_mutex_lock(&c->lock);
+  memset(&c->stats, 0, sizeof(c->stats));
+  pthread_mutex_unlock(&c->lock);
+}
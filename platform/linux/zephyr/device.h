@@ -0,0 +1,22 @@
+#ifndef _SSM_ZEPHYR_EMU_DEVICE_H
+#define _SSM_ZEPHYR_EMU_DEVICE_H
+
+/** \addtogroup zephyr
+ * @{
+ */
+
+/** An emulated device */
+struct device {
+  const char *name;
+  void *data;                /**< State of the emulation */
+};
+
+/** Return the emulated device with the given name, or 0
+ *
+ * The only device is the counter, named "SSM_TIMER".
+ */
+const struct device *device_get_binding(const char *name);
+
+/** @} */
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef _SSM_ZEPHYR_EMU_COUNTER_H
+#define _SSM_ZEPHYR_EMU_COUNTER_H
+
+/** \addtogroup zephyr
+ * @{
+ */
+
+#include <stdint.h>
+#include "../device.h"
+
+/** Frequency of the emulated counter in Hz */
+#ifndef SSM_ZEPHYR_COUNTER_FREQUENCY
+#define SSM_ZEPHYR_COUNTER_FREQUENCY 16000000
+#endif
+
+/** The alarm's ticks are a counter value rather than a delay */
+#define COUNTER_ALARM_CFG_ABSOLUTE (1u << 0)
+
+/** Fire an absolute alarm right away if its ticks have already passed */
+#define COUNTER_ALARM_CFG_EXPIRE_WHEN_LATE (1u << 1)
+
+/** The guard period decides when an absolute alarm is too late to set */
+#define COUNTER_GUARD_PERIOD_LATE_TO_SET (1u << 0)
+
+typedef void (*counter_alarm_callback_t)(const struct device *dev,
+					 uint8_t chan_id, uint32_t ticks,
+					 void *user_data);
+
+struct counter_alarm_cfg {
+  counter_alarm_callback_t callback;
+  uint32_t ticks;
+  void *user_data;
+  uint32_t flags;
+};
+
+/** What the emulated counter has seen since it started */
+struct counter_emu_stats {
+  uint64_t set;              /**< Alarms set, including late ones */
+  uint64_t late;             /**< Absolute alarms whose ticks had passed */
+  uint64_t busy;             /**< Attempts to set an alarm already set */
+  uint64_t fired;            /**< Callbacks made */
+  uint64_t total_delay_ns;   /**< Sum of time from expiry to callback */
+  uint64_t max_delay_ns;     /**< Longest time from expiry to callback */
+};
+
+/** Start the free-running counter at 0; 0 or -EALREADY */
+int counter_start(const struct device *dev);
+
+/** Stop the counter and cancel its alarm; always 0 */
+int counter_stop(const struct device *dev);
+
+/** Store the counter's current value in `ticks`; always 0 */
+int counter_get_value(const struct device *dev, uint32_t *ticks);
+
+/** Return the counter frequency in Hz */
+uint32_t counter_get_frequency(const struct device *dev);
+
+/** Return the value after which the counter wraps to 0 */
+uint32_t counter_get_top_value(const struct device *dev);
+
+/** Return the number of alarm channels: one */
+uint8_t counter_get_num_of_channels(const struct device *dev);
+
+/** Set how far behind the counter an absolute alarm is considered late
+ *
+ * Only matters with #COUNTER_GUARD_PERIOD_LATE_TO_SET; without it, an
+ * absolute alarm whose ticks have passed fires after the counter wraps.
+ */
+int counter_set_guard_period(const struct device *dev, uint32_t ticks,
+			     uint32_t flags);
+
+/** Set a one-shot alarm on channel `chan_id`
+ *
+ * Returns 0; -ENOTSUP for a channel other than 0; -EBUSY if the channel
+ * already has an alarm; or -ETIME if an absolute alarm is late, in which
+ * case the alarm fires right away if its flags include
+ * #COUNTER_ALARM_CFG_EXPIRE_WHEN_LATE and is dropped otherwise.  Callbacks
+ * run on a separate thread, as if from an interrupt.
+ */
+int counter_set_channel_alarm(const struct device *dev, uint8_t chan_id,
+			      const struct counter_alarm_cfg *alarm_cfg);
+
+/** Cancel the alarm on channel `chan_id`; 0 or -ENOTSUP */
+int counter_cancel_channel_alarm(const struct device *dev, uint8_t chan_id);
+
+/** Convert between microseconds and counter ticks */
+uint32_t counter_us_to_ticks(const struct device *dev, uint64_t us);
+uint64_t counter_ticks_to_us(const struct device *dev, uint32_t ticks);
+
+/** Copy the counter's statistics into `stats` (emulation only) */
+void counter_emu_get_stats(const struct device *dev,
+			   struct counter_emu_stats *stats);
+
+/** Clear the counter's statistics (emulation only) */
+void counter_emu_reset_stats(const struct device *dev);
+
+/** @} */
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef _SSM_ZEPHYR_EMU_H
+#define _SSM_ZEPHYR_EMU_H
+
+/** \defgroup zephyr Zephyr Emulation
+ *
+ * A stand-in for the part of the Zephyr kernel and driver API that SSM's
+ * Zephyr tick loop uses, so the same driver code can run and be measured
+ * on a Linux host.  Put platform/linux/zephyr on the include path so
+ * `#include <zephyr.h>`, `<device.h>`, and `<drivers/counter.h>` find
+ * these headers, and link with build/libssm-linux.a and -lpthread.
+ *
+ * Threads are POSIX threads; message queues are a mutex and condition
+ * variable around a ring; the counter is described in drivers/counter.h.
+ * Devicetree, GPIO, and thread priorities are not emulated.
+ *
+ * \addtogroup zephyr
+ * @{
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "device.h"
+
+/** A timeout in nanoseconds; negative waits forever */
+typedef struct { int64_t ns; } k_timeout_t;
+
+#define K_NO_WAIT ((k_timeout_t) { 0 })
+#define K_FOREVER ((k_timeout_t) { -1 })
+#define K_NSEC(t) ((k_timeout_t) { (int64_t) (t) })
+#define K_USEC(t) K_NSEC((int64_t) (t) * 1000)
+#define K_MSEC(t) K_NSEC((int64_t) (t) * 1000000)
+#define K_SECONDS(t) K_NSEC((int64_t) (t) * 1000000000)
+
+/** A bounded queue of fixed-size messages */
+struct k_msgq {
+  char *buffer;
+  size_t msg_size;
+  uint32_t max_msgs;
+  uint32_t read, used;       /**< Index of the oldest message; count */
+  pthread_mutex_t lock;
+  pthread_cond_t changed;
+};
+
+/** Define a message queue `name` of `max_msgs` messages of `msg_size` bytes */
+#define K_MSGQ_DEFINE(name, msg_size_, max_msgs_, align)		\
+  static char _k_msgq_buf_##name[(msg_size_) * (max_msgs_)];		\
+  struct k_msgq name = {						\
+    .buffer = _k_msgq_buf_##name, .msg_size = (msg_size_),		\
+    .max_msgs = (max_msgs_),						\
+    .lock = PTHREAD_MUTEX_INITIALIZER,					\
+    .changed = PTHREAD_COND_INITIALIZER }
+
+/** Initialize a message queue over `buffer` at run time */
+void k_msgq_init(struct k_msgq *q, char *buffer, size_t msg_size,
+		 uint32_t max_msgs);
+
+/** Copy a message into the queue
+ *
+ * Returns 0, -ENOMSG if the queue is full and `timeout` is #K_NO_WAIT, or
+ * -EAGAIN if it stayed full until `timeout`.  May be called from an alarm
+ * callback.
+ */
+int k_msgq_put(struct k_msgq *q, const void *data, k_timeout_t timeout);
+
+/** Remove the oldest message from the queue into `data`
+ *
+ * Returns 0, -ENOMSG if the queue is empty and `timeout` is #K_NO_WAIT, or
+ * -EAGAIN if it stayed empty until `timeout`.
+ */
+int k_msgq_get(struct k_msgq *q, void *data, k_timeout_t timeout);
+
+/** Return the number of messages in the queue */
+uint32_t k_msgq_num_used_get(struct k_msgq *q);
+
+/** Discard every message in the queue */
+void k_msgq_purge(struct k_msgq *q);
+
+typedef void (*k_thread_entry_t)(void *p1, void *p2, void *p3);
+
+/** A thread; only its POSIX thread is kept */
+struct k_thread {
+  pthread_t thread;
+  k_thread_entry_t entry;
+  void *p1, *p2, *p3;
+};
+
+typedef struct k_thread *k_tid_t;
+
+/** Stacks belong to the host's threads, so this only names a placeholder */
+#define K_THREAD_STACK_DEFINE(sym, size) static char sym[1]
+#define K_THREAD_STACK_SIZEOF(sym) sizeof(sym)
+
+/** Start `entry(p1, p2, p3)` on a new thread
+ *
+ * The stack, priority, and options are ignored and `delay` must be
+ * #K_NO_WAIT.  Returns the thread, or 0 if it could not be started.
+ */
+k_tid_t k_thread_create(struct k_thread *thread, char *stack,
+			size_t stack_size, k_thread_entry_t entry,
+			void *p1, void *p2, void *p3,
+			int prio, uint32_t options, k_timeout_t delay);
+
+/** Wait for a thread to return; 0 or -EAGAIN if `timeout` is not forever */
+int k_thread_join(struct k_thread *thread, k_timeout_t timeout);
+
+/** Sleep for `timeout`; always returns 0 */
+int32_t k_sleep(k_timeout_t timeout);
+
+/** Return the milliseconds since the process started */
+int64_t k_uptime_get(void);
+
+/** Print to standard output */
+void printk(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+/** @} */
+
+#endif
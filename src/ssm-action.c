@@ -0,0 +1,56 @@
+#include "ssm.h"
+
+/** Actions not yet performed, oldest first
+ *
+ * A ring indexed by running counts: action_head actions have been
+ * performed and action_tail queued.  Only ssm_defer() moves the tail and
+ * logs it, so rolling back drops the actions of undone instants; the
+ * head only passes committed actions, so it never passes a restored tail.
+ */
+static ssm_action_t action_queue[SSM_ACTION_QUEUE_SIZE];
+static size_t action_head = 0;
+static size_t action_tail = 0;
+
+static inline ssm_action_t *action(size_t i)
+{
+  return &action_queue[i % SSM_ACTION_QUEUE_SIZE];
+}
+
+void ssm_defer(ssm_actionf_t *fn, void *data, uint64_t arg)
+{
+  assert(fn);
+  if (action_tail - action_head == SSM_ACTION_QUEUE_SIZE)
+    SSM_THROW(SSM_EXHAUSTED_ACTION_QUEUE);
+  SSM_SAVE(action_tail); // Rolling back drops uncommitted actions
+  *action(action_tail++) = (ssm_action_t) {
+    .fn = fn,
+    .data = data,
+    .arg = arg,
+    .time = ssm_now()
+  };
+}
+
+size_t ssm_flush_actions(ssm_action_sinkf_t *sink)
+{
+  ssm_time_t committed = SSM_NEVER;
+#ifdef SSM_OPTIMISTIC
+  committed = ssm_uncommitted_time(); // Hold actions that may be undone
+#endif
+  size_t count = 0;
+  /* An action may queue further actions; they run in this flush too */
+  while (action_head != action_tail && action(action_head)->time < committed) {
+    ssm_action_t *a = action(action_head);
+    if (sink)
+      sink(a);
+    else
+      a->fn(a->data, a->arg);
+    action_head++;
+    count++;
+  }
+  return count;
+}
+
+void ssm_reset_actions()
+{
+  action_head = action_tail = 0;
+}
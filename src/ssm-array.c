@@ -0,0 +1,150 @@
+#include "ssm.h"
+
+static inline void *later_elem(ssm_array_t *v, size_t i)
+{
+  return (char *) v->later_value + i * v->size;
+}
+
+/** Return true if any element from lo up to hi is pending */
+static bool any_dirty(ssm_array_t *v, size_t lo, size_t hi)
+{
+  if (lo >= hi) return false;
+  size_t first = lo / 64, last = (hi - 1) / 64;
+  for (size_t w = first ; w <= last ; w++) {
+    if (w < v->dirty_lo || w >= v->dirty_hi) continue; // Clean word
+    uint64_t bits = v->dirty[w];
+    if (w == first) bits &= ~(uint64_t) 0 << (lo % 64);
+    if (w == last && hi % 64) bits &= ~(~(uint64_t) 0 << (hi % 64));
+    if (bits) return true;
+  }
+  return false;
+}
+
+/** Mark a range as changed in this instant and wake what waits on it */
+static void touch(ssm_array_range_t *r, ssm_priority_t prio, bool all)
+{
+  SSM_SAVE(r->sv.last_updated);
+  SSM_JOURNAL_MARK(&r->sv);
+  r->sv.last_updated = ssm_now();
+  for (ssm_trigger_t *trig = r->sv.triggers ; trig ; trig = trig->next)
+    if (all || trig->act->priority > prio)
+      ssm_activate(trig->act);
+}
+
+/** Commit the dirty elements */
+static bool ssm_update_array(ssm_sv_t *sv)
+{
+  ssm_array_t *v = container_of(sv, ssm_array_t, sv);
+
+  for (ssm_array_range_t *r = v->ranges ; r ; r = r->next)
+    if (any_dirty(v, r->lo, r->hi)) touch(r, 0, true);
+
+  for (size_t w = v->dirty_lo ; w < v->dirty_hi ; w++) {
+    uint64_t bits = v->dirty[w];
+    if (!bits) continue;
+    SSM_SAVE(v->dirty[w]);
+    v->dirty[w] = 0;
+    for ( ; bits ; bits &= bits - 1) {
+      size_t i = w * 64 + __builtin_ctzll(bits);
+      SSM_SAVE_BYTES(ssm_array_elem(v, i), v->size);
+      ssm_copy_value(ssm_array_elem(v, i), later_elem(v, i), v->size);
+    }
+  }
+  SSM_SAVE(v->dirty_lo);
+  SSM_SAVE(v->dirty_hi);
+  v->dirty_lo = v->dirty_hi = 0;
+  return true;
+}
+
+static bool ssm_update_range(ssm_sv_t *sv)
+{
+  return true;
+}
+
+void ssm_initialize_array(ssm_array_t *v, void *value, void *later,
+			  uint64_t *dirty, size_t len, size_t size)
+{
+  assert(v);
+  assert(value && later && dirty);
+  ssm_initialize(&v->sv, ssm_update_array);
+  v->value = value;
+  v->later_value = later;
+  v->dirty = dirty;
+  v->len = len;
+  v->size = size;
+  v->dirty_lo = v->dirty_hi = 0;
+  v->ranges = 0;
+  memset(dirty, 0, SSM_ARRAY_DIRTY_WORDS(len) * sizeof(uint64_t));
+}
+
+void ssm_array_watch(ssm_array_t *v, ssm_array_range_t *range,
+		     size_t lo, size_t hi)
+{
+  assert(v);
+  assert(range);
+  assert(lo <= hi && hi <= v->len);
+  ssm_initialize(&range->sv, ssm_update_range);
+  range->lo = lo;
+  range->hi = hi;
+  SSM_SAVE(v->ranges);
+  range->next = v->ranges;
+  v->ranges = range;
+}
+
+void ssm_array_unwatch(ssm_array_t *v, ssm_array_range_t *range)
+{
+  assert(v);
+  assert(range);
+  for (ssm_array_range_t **r = &v->ranges ; *r ; r = &(*r)->next)
+    if (*r == range) {
+      SSM_SAVE(*r);
+      *r = range->next;
+      return;
+    }
+}
+
+void ssm_assign_array(ssm_array_t *v, ssm_priority_t prio, size_t i,
+		      const void *value)
+{
+  assert(v);
+  assert(i < v->len);
+  SSM_SAVE_BYTES(ssm_array_elem(v, i), v->size);
+  ssm_copy_value(ssm_array_elem(v, i), value, v->size);
+  SSM_SAVE(v->sv.last_updated);
+  SSM_JOURNAL_MARK(&v->sv);
+  v->sv.last_updated = ssm_now();
+  ssm_trigger(&v->sv, prio);
+  for (ssm_array_range_t *r = v->ranges ; r ; r = r->next)
+    if (r->lo <= i && i < r->hi) touch(r, prio, false);
+}
+
+void ssm_later_array(ssm_array_t *v, ssm_time_t then, size_t i,
+		     const void *value)
+{
+  assert(v);
+  assert(i < v->len);
+  if (then <= ssm_now() || // Pending elements share one time
+      (v->sv.later_time != SSM_NEVER && v->sv.later_time != then))
+    SSM_THROW(SSM_INVALID_TIME);
+  SSM_SAVE_BYTES(later_elem(v, i), v->size);
+  ssm_copy_value(later_elem(v, i), value, v->size);
+
+  size_t w = i / 64;
+  uint64_t bit = (uint64_t) 1 << (i % 64);
+  if (!(v->dirty[w] & bit)) {
+    SSM_SAVE(v->dirty[w]);
+    v->dirty[w] |= bit;
+    if (w < v->dirty_lo || w >= v->dirty_hi) {
+      SSM_SAVE(v->dirty_lo);
+      SSM_SAVE(v->dirty_hi);
+      if (v->dirty_lo == v->dirty_hi) {
+	v->dirty_lo = w;
+	v->dirty_hi = w + 1;
+      } else if (w < v->dirty_lo)
+	v->dirty_lo = w;
+      else
+	v->dirty_hi = w + 1;
+    }
+  }
+  if (v->sv.later_time == SSM_NEVER) ssm_schedule(&v->sv, then);
+}
@@ -0,0 +1,124 @@
+#include "ssm.h"
+
+/** Mark watched bits as written in this instant and wake what waits on them */
+static void touch(ssm_bits_watch_t *w, ssm_priority_t prio, bool all)
+{
+  SSM_SAVE(w->sv.last_updated);
+  SSM_JOURNAL_MARK(&w->sv);
+  w->sv.last_updated = ssm_now();
+  for (ssm_trigger_t *trig = w->sv.triggers ; trig ; trig = trig->next)
+    if (all || trig->act->priority > prio)
+      ssm_activate(trig->act);
+}
+
+/** Commit the pending bits of every word */
+static bool ssm_update_bits(ssm_sv_t *sv)
+{
+  ssm_bits_t *v = container_of(sv, ssm_bits_t, sv);
+
+  for (ssm_bits_watch_t *w = v->watches ; w ; w = w->next)
+    if (v->pending[w->word] & w->mask) touch(w, 0, true);
+
+  for (size_t i = v->dirty_lo ; i < v->dirty_hi ; i++) {
+    uint64_t p = v->pending[i];
+    if (!p) continue;
+    SSM_SAVE(v->value[i]);
+    SSM_SAVE(v->pending[i]);
+    v->value[i] = (v->value[i] & ~p) | (v->later_value[i] & p);
+    v->pending[i] = 0;
+  }
+  SSM_SAVE(v->dirty_lo);
+  SSM_SAVE(v->dirty_hi);
+  v->dirty_lo = v->dirty_hi = 0;
+  return true;
+}
+
+static bool ssm_update_watch(ssm_sv_t *sv)
+{
+  return true;
+}
+
+void ssm_initialize_bits(ssm_bits_t *v, uint64_t *value, uint64_t *later,
+			 uint64_t *pending, size_t len)
+{
+  assert(v);
+  assert(value && later && pending);
+  ssm_initialize(&v->sv, ssm_update_bits);
+  v->value = value;
+  v->later_value = later;
+  v->pending = pending;
+  v->words = SSM_BITS_WORDS(len);
+  v->dirty_lo = v->dirty_hi = 0;
+  v->watches = 0;
+  memset(pending, 0, v->words * sizeof(uint64_t));
+}
+
+void ssm_bits_watch(ssm_bits_t *v, ssm_bits_watch_t *watch, size_t word,
+		    uint64_t mask)
+{
+  assert(v);
+  assert(watch);
+  assert(word < v->words);
+  ssm_initialize(&watch->sv, ssm_update_watch);
+  watch->word = word;
+  watch->mask = mask;
+  SSM_SAVE(v->watches);
+  watch->next = v->watches;
+  v->watches = watch;
+}
+
+void ssm_bits_unwatch(ssm_bits_t *v, ssm_bits_watch_t *watch)
+{
+  assert(v);
+  assert(watch);
+  for (ssm_bits_watch_t **w = &v->watches ; *w ; w = &(*w)->next)
+    if (*w == watch) {
+      SSM_SAVE(*w);
+      *w = watch->next;
+      return;
+    }
+}
+
+void ssm_assign_bits(ssm_bits_t *v, ssm_priority_t prio, size_t word,
+		     uint64_t mask, uint64_t bits)
+{
+  assert(v);
+  assert(word < v->words);
+  SSM_SAVE(v->value[word]);
+  v->value[word] = (v->value[word] & ~mask) | (bits & mask);
+  SSM_SAVE(v->sv.last_updated);
+  SSM_JOURNAL_MARK(&v->sv);
+  v->sv.last_updated = ssm_now();
+  ssm_trigger(&v->sv, prio);
+  for (ssm_bits_watch_t *w = v->watches ; w ; w = w->next)
+    if (w->word == word && (w->mask & mask)) touch(w, prio, false);
+}
+
+void ssm_later_bits(ssm_bits_t *v, ssm_time_t then, size_t word,
+		    uint64_t mask, uint64_t bits)
+{
+  assert(v);
+  assert(word < v->words);
+  if (then <= ssm_now() || // Pending bits share one time
+      (v->sv.later_time != SSM_NEVER && v->sv.later_time != then))
+    SSM_THROW(SSM_INVALID_TIME);
+  SSM_SAVE(v->later_value[word]);
+  v->later_value[word] = (v->later_value[word] & ~mask) | (bits & mask);
+
+  if ((v->pending[word] | mask) != v->pending[word]) {
+    SSM_SAVE(v->pending[word]);
+    v->pending[word] |= mask;
+    if (word < v->dirty_lo || word >= v->dirty_hi) {
+      SSM_SAVE(v->dirty_lo);
+      SSM_SAVE(v->dirty_hi);
+      if (v->dirty_lo == v->dirty_hi) {
+	v->dirty_lo = word;
+	v->dirty_hi = word + 1;
+      } else if (word < v->dirty_lo)
+	v->dirty_lo = word;
+      else
+	v->dirty_hi = word + 1;
+    }
+  }
+  if (v->sv.later_time == SSM_NEVER) ssm_schedule(&v->sv, then);
+}
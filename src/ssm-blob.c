@@ -0,0 +1,44 @@
+#include "ssm.h"
+
+/** Exchange the current and buffered values */
+static void swap(ssm_blob_t *v)
+{
+  void *value = v->value;
+  SSM_SAVE(v->value);
+  SSM_SAVE(v->later_value);
+  v->value = v->later_value;
+  v->later_value = value;
+}
+
+static bool ssm_update_blob(ssm_sv_t *sv)
+{
+  swap(container_of(sv, ssm_blob_t, sv));
+  return true;
+}
+
+void ssm_initialize_blob(ssm_blob_t *v, void *value, void *later, size_t size)
+{
+  assert(v);
+  assert(value && later && value != later);
+  ssm_initialize(&v->sv, ssm_update_blob);
+  v->value = value;
+  v->later_value = later;
+  v->size = size;
+}
+
+void ssm_assign_blob(ssm_blob_t *v, ssm_priority_t prio)
+{
+  assert(v);
+  ssm_unschedule(&v->sv);
+  SSM_SAVE(v->sv.last_updated);
+  SSM_JOURNAL_MARK(&v->sv);
+  swap(v);
+  v->sv.last_updated = ssm_now();
+  ssm_trigger(&v->sv, prio);
+}
+
+void ssm_later_blob(ssm_blob_t *v, ssm_time_t then)
+{
+  assert(v);
+  ssm_schedule(&v->sv, then);
+}
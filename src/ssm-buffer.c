@@ -0,0 +1,147 @@
+#include "ssm.h"
+
+/** Bits of a free list head holding a slice number; the rest is the tag */
+#define NUMBER_BITS (sizeof(uintptr_t) * 4)
+#define NUMBER_MASK (((uintptr_t) 1 << NUMBER_BITS) - 1)
+
+static inline ssm_slice_t *slice_at(ssm_slice_pool_t *p, uintptr_t n)
+{
+  return (ssm_slice_t *) (p->base + (n - 1) * p->stride);
+}
+
+/** A head naming slice `n` whose tag follows that of `old` */
+static inline uintptr_t next_head(uintptr_t old, uintptr_t n)
+{
+  return (old & ~NUMBER_MASK) + ((uintptr_t) 1 << NUMBER_BITS) + n;
+}
+
+void ssm_initialize_slice_pool(ssm_slice_pool_t *p, void *storage,
+			       size_t bytes, size_t slice_size)
+{
+  assert(p);
+  assert(storage);
+  size_t stride = SSM_SLICE_STRIDE(slice_size);
+  assert(bytes / stride < NUMBER_MASK);
+  p->free = 0;
+  p->base = storage;
+  p->stride = stride;
+  p->slice_size = slice_size;
+  p->available = 0;
+
+  // Thread the slices in address order so the first allocated comes first
+  for (size_t n = bytes / stride ; n > 0 ; n--) {
+    ssm_slice_t *s = slice_at(p, n);
+    s->refs = 0;
+    s->len = 0;
+    s->pool = p;
+    s->next = p->free;
+    p->free = n;
+    p->available++;
+  }
+}
+
+ssm_slice_t *ssm_slice_alloc(ssm_slice_pool_t *p)
+{
+  assert(p);
+  uintptr_t old = __atomic_load_n(&p->free, __ATOMIC_ACQUIRE);
+  ssm_slice_t *s;
+  do {
+    if (!(old & NUMBER_MASK)) return 0;
+    s = slice_at(p, old & NUMBER_MASK);
+  } while (!__atomic_compare_exchange_n(&p->free, &old,
+	     next_head(old, __atomic_load_n(&s->next, __ATOMIC_RELAXED)),
+	     true, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE));
+  __atomic_fetch_sub(&p->available, 1, __ATOMIC_RELAXED);
+  s->len = 0;
+  __atomic_store_n(&s->refs, 1, __ATOMIC_RELAXED);
+  return s;
+}
+
+void ssm_slice_retain(ssm_slice_t *s)
+{
+  assert(s);
+  assert(s->refs);
+  __atomic_fetch_add(&s->refs, 1, __ATOMIC_RELAXED);
+}
+
+void ssm_slice_release(ssm_slice_t *s)
+{
+  assert(s);
+  assert(s->refs);
+  if (__atomic_sub_fetch(&s->refs, 1, __ATOMIC_ACQ_REL)) return;
+  ssm_slice_pool_t *p = s->pool;
+  uintptr_t n = ((unsigned char *) s - p->base) / p->stride + 1;
+  uintptr_t old = __atomic_load_n(&p->free, __ATOMIC_RELAXED);
+  do
+    __atomic_store_n(&s->next, (uint32_t) (old & NUMBER_MASK),
+		     __ATOMIC_RELAXED);
+  while (!__atomic_compare_exchange_n(&p->free, &old, next_head(old, n),
+				      true, __ATOMIC_RELEASE,
+				      __ATOMIC_RELAXED));
+  __atomic_fetch_add(&p->available, 1, __ATOMIC_RELAXED);
+}
+
+/** Refuse to run speculatively, since releases cannot be undone */
+static inline void not_speculating(void)
+{
+#ifdef SSM_OPTIMISTIC
+  if (ssm_optimistic) SSM_THROW(SSM_SPECULATIVE_BUFFER);
+#endif
+}
+
+/** Commit the pending slice, releasing the one it replaces */
+static bool ssm_update_buffer(ssm_sv_t *sv)
+{
+  ssm_buffer_t *v = container_of(sv, ssm_buffer_t, sv);
+  not_speculating();
+  if (v->value) ssm_slice_release(v->value);
+  v->value = v->later_value;
+  v->later_value = 0;
+  return true;
+}
+
+void ssm_initialize_buffer(ssm_buffer_t *v)
+{
+  assert(v);
+  ssm_initialize(&v->sv, ssm_update_buffer);
+  v->value = 0;
+  v->later_value = 0;
+}
+
+void ssm_assign_buffer(ssm_buffer_t *v, ssm_priority_t prio,
+		       ssm_slice_t *slice)
+{
+  assert(v);
+  not_speculating();
+  if (v->value) ssm_slice_release(v->value);
+  v->value = slice;
+  SSM_JOURNAL_MARK(&v->sv);
+  v->sv.last_updated = ssm_now();
+  ssm_trigger(&v->sv, prio);
+}
+
+void ssm_later_buffer(ssm_buffer_t *v, ssm_time_t then, ssm_slice_t *slice)
+{
+  assert(v);
+  not_speculating();
+  ssm_schedule(&v->sv, then); // Throws before anything is released
+  if (v->later_value) ssm_slice_release(v->later_value);
+  v->later_value = slice;
+}
+
+void ssm_deliver_buffer(ssm_sv_t *sv, ssm_time_t then, const void *payload)
+{
+  ssm_slice_t *slice;
+  memcpy(&slice, payload, sizeof(slice));
+  ssm_later_buffer(container_of(sv, ssm_buffer_t, sv), then, slice);
+}
+
+void ssm_drop_buffer(ssm_buffer_t *v)
+{
+  assert(v);
+  not_speculating();
+  ssm_unschedule(&v->sv);
+  if (v->later_value) ssm_slice_release(v->later_value);
+  if (v->value) ssm_slice_release(v->value);
+  v->value = v->later_value = 0;
+}
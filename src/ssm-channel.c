@@ -0,0 +1,102 @@
+#include "ssm.h"
+
+/** Return the slot `k` items past the oldest visible one */
+static inline size_t slot(ssm_channel_t *c, size_t k)
+{
+  size_t s = c->head + k;
+  return s < c->capacity ? s : s - c->capacity;
+}
+
+/** Make the first `n` pending items visible */
+static void publish(ssm_channel_t *c, size_t n)
+{
+  SSM_SAVE(c->count);
+  SSM_SAVE(c->pending);
+  c->count += n;
+  c->pending -= n;
+}
+
+/** Make the items due now visible; wait for the next pending one */
+static bool ssm_update_channel(ssm_sv_t *sv)
+{
+  ssm_channel_t *c = container_of(sv, ssm_channel_t, sv);
+  size_t n = 0;
+  while (n < c->pending && c->times[slot(c, c->count + n)] <= ssm_now())
+    n++;
+  publish(c, n);
+  if (c->pending) ssm_schedule(&c->sv, c->times[slot(c, c->count)]);
+  return true;
+}
+
+void ssm_initialize_channel(ssm_channel_t *c, void *slots, ssm_time_t *times,
+			    size_t size, size_t capacity)
+{
+  assert(c);
+  assert(slots);
+  assert(times);
+  assert(capacity > 0);
+  ssm_initialize(&c->sv, ssm_update_channel);
+  c->slots = slots;
+  c->times = times;
+  c->size = size;
+  c->capacity = capacity;
+  c->head = c->count = c->pending = 0;
+}
+
+void *ssm_channel_reserve(ssm_channel_t *c)
+{
+  assert(c);
+  size_t used = c->count + c->pending;
+  if (used == c->capacity) return 0;
+  void *s = (char *) c->slots + slot(c, used) * c->size;
+  SSM_SAVE_BYTES(s, c->size); // May hold an item a rollback would restore
+  return s;
+}
+
+void ssm_later_channel(ssm_channel_t *c, ssm_time_t then)
+{
+  assert(c);
+  assert(c->count + c->pending < c->capacity); // Reserved a slot
+  size_t used = c->count + c->pending;
+  if (then <= ssm_now() ||   // Items stay in order, so none may overtake
+      (c->pending && then < c->times[slot(c, used - 1)]))
+    SSM_THROW(SSM_INVALID_TIME);
+  size_t s = slot(c, used);
+  SSM_SAVE(c->times[s]);
+  c->times[s] = then;
+  SSM_SAVE(c->pending);
+  if (!c->pending++) ssm_schedule(&c->sv, then); // Otherwise already scheduled
+}
+
+void ssm_assign_channel(ssm_channel_t *c, ssm_priority_t prio)
+{
+  assert(c);
+  assert(c->count + c->pending < c->capacity); // Reserved a slot
+  ssm_unschedule(&c->sv);
+  SSM_SAVE(c->pending);
+  c->pending++;
+  publish(c, c->pending);
+  SSM_SAVE(c->sv.last_updated);
+  SSM_JOURNAL_MARK(&c->sv);
+  c->sv.last_updated = ssm_now();
+  ssm_trigger(&c->sv, prio);
+}
+
+bool ssm_channel_send(ssm_channel_t *c, ssm_time_t then, const void *item)
+{
+  void *s = ssm_channel_reserve(c);
+  if (!s) return false;
+  ssm_copy_value(s, item, c->size);
+  ssm_later_channel(c, then);
+  return true;
+}
+
+void ssm_channel_pop(ssm_channel_t *c)
+{
+  assert(c);
+  assert(c->count);
+  SSM_SAVE(c->head);
+  SSM_SAVE(c->count);
+  c->head = slot(c, 1);
+  c->count--;
+}
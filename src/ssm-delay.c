@@ -0,0 +1,91 @@
+#include "ssm.h"
+
+/** Return the slot of the `k`th pending value */
+static inline size_t slot(ssm_delay_t *v, size_t k)
+{
+  size_t s = v->head + k;
+  return s < v->capacity ? s : s - v->capacity;
+}
+
+static inline void *slot_value(ssm_delay_t *v, size_t s)
+{
+  return (char *) v->values + s * v->size;
+}
+
+/** Commit the earliest pending value and schedule the next */
+static bool ssm_update_delay(ssm_sv_t *sv)
+{
+  ssm_delay_t *v = container_of(sv, ssm_delay_t, sv);
+  assert(v->count);
+  SSM_SAVE_BYTES(v->value, v->size);
+  ssm_copy_value(v->value, slot_value(v, v->head), v->size);
+  SSM_SAVE(v->head);
+  SSM_SAVE(v->count);
+  v->head = slot(v, 1);
+  if (--v->count)
+    ssm_schedule(&v->sv, v->times[v->head]);
+  return true;
+}
+
+void ssm_initialize_delay(ssm_delay_t *v, void *value, ssm_time_t *times,
+			  void *values, size_t size, size_t capacity)
+{
+  assert(v);
+  assert(value && times && values);
+  assert(capacity > 0);
+  ssm_initialize(&v->sv, ssm_update_delay);
+  v->value = value;
+  v->times = times;
+  v->values = values;
+  v->size = size;
+  v->capacity = capacity;
+  v->head = 0;
+  v->count = 0;
+}
+
+void ssm_assign_delay(ssm_delay_t *v, ssm_priority_t prio, const void *value)
+{
+  assert(v);
+  SSM_SAVE_BYTES(v->value, v->size);
+  ssm_copy_value(v->value, value, v->size);
+  SSM_SAVE(v->sv.last_updated);
+  SSM_JOURNAL_MARK(&v->sv);
+  v->sv.last_updated = ssm_now();
+  ssm_trigger(&v->sv, prio);
+}
+
+void ssm_later_delay(ssm_delay_t *v, ssm_time_t then, const void *value)
+{
+  assert(v);
+  if (then <= ssm_now()) SSM_THROW(SSM_INVALID_TIME);
+
+  // Find where the value goes, searching from the latest
+  size_t k = v->count;
+  while (k > 0 && v->times[slot(v, k - 1)] > then) k--;
+
+  if (k > 0 && v->times[slot(v, k - 1)] == then) {
+    size_t s = slot(v, k - 1); // Replace the value pending at then
+    SSM_SAVE_BYTES(slot_value(v, s), v->size);
+    ssm_copy_value(slot_value(v, s), value, v->size);
+    return;
+  }
+  if (v->count == v->capacity) SSM_THROW(SSM_EXHAUSTED_DELAY_LINE);
+
+  // Make room by moving the later values back a slot
+  for (size_t j = v->count ; j > k ; j--) {
+    size_t to = slot(v, j), from = slot(v, j - 1);
+    SSM_SAVE(v->times[to]);
+    SSM_SAVE_BYTES(slot_value(v, to), v->size);
+    v->times[to] = v->times[from];
+    ssm_copy_value(slot_value(v, to), slot_value(v, from), v->size);
+  }
+  size_t s = slot(v, k);
+  SSM_SAVE(v->times[s]);
+  SSM_SAVE_BYTES(slot_value(v, s), v->size);
+  v->times[s] = then;
+  ssm_copy_value(slot_value(v, s), value, v->size);
+  SSM_SAVE(v->count);
+  v->count++;
+
+  if (k == 0) ssm_schedule(&v->sv, then);
+}
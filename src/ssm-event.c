@@ -3,15 +3,23 @@
 void ssm_assign_event(ssm_event_t *v, ssm_priority_t prio)
 {
   assert(v);
+  SSM_SAVE(v->sv.last_updated);
+  SSM_JOURNAL_MARK(&v->sv);
   v->sv.last_updated = ssm_now();
   ssm_trigger(&v->sv, prio);
 }
 
-static void ssm_update_event(ssm_sv_t *v)
+bool ssm_update_event(ssm_sv_t *v)
 {
+  return true;
 }
 
 void ssm_initialize_event(ssm_event_t *v)
 {
   ssm_initialize(&v->sv, ssm_update_event);
 }
+
+void ssm_deliver_event(ssm_sv_t *sv, ssm_time_t then, const void *payload)
+{
+  ssm_schedule(sv, then);
+}
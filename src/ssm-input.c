@@ -0,0 +1,111 @@
+#include "ssm.h"
+
+#if SSM_INPUT_QUEUE_SIZE & (SSM_INPUT_QUEUE_SIZE - 1)
+#error "SSM_INPUT_QUEUE_SIZE must be a power of two"
+#endif
+
+#define INPUT_MASK (SSM_INPUT_QUEUE_SIZE - 1)
+
+/** An entry in the input ring
+ *
+ * `seq` tells producers and the consumer whose turn it is, as in Vyukov's
+ * bounded queue.  It is stored minus the entry's index so the ring starts
+ * out ready when zeroed: entry i is free for position p when seq + i == p
+ * and holds position p's update when seq + i == p + 1.
+ */
+typedef struct {
+  uint32_t seq;
+  ssm_sv_t *var;
+  ssm_deliverf_t *deliver;
+  ssm_time_t then;
+  uint64_t payload;
+} input_entry_t;
+
+static input_entry_t input_ring[SSM_INPUT_QUEUE_SIZE];
+
+/** Next position for producers to claim */
+static uint32_t input_tail = 0;
+
+/** Next position for the consumer to drain; only the consumer writes it */
+static uint32_t input_head = 0;
+
+bool ssm_input_post(ssm_sv_t *var, ssm_deliverf_t *deliver, ssm_time_t then,
+		    const void *payload, size_t size)
+{
+  assert(var);
+  assert(deliver);
+  assert(size <= sizeof(uint64_t));
+
+  uint32_t pos = __atomic_load_n(&input_tail, __ATOMIC_RELAXED);
+  input_entry_t *e;
+  for (;;) {
+    uint32_t i = pos & INPUT_MASK;
+    e = &input_ring[i];
+    int32_t diff = (int32_t)
+      (__atomic_load_n(&e->seq, __ATOMIC_ACQUIRE) + i - pos);
+    if (diff == 0) {
+      if (__atomic_compare_exchange_n(&input_tail, &pos, pos + 1, true,
+				      __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+	break;  // Claimed pos; otherwise pos is now the current tail
+    } else if (diff < 0)
+      return false; // The consumer has not drained this entry yet
+    else
+      pos = __atomic_load_n(&input_tail, __ATOMIC_RELAXED);
+  }
+
+  e->var = var;
+  e->deliver = deliver;
+  e->then = then;
+  e->payload = 0;
+  if (size) memcpy(&e->payload, payload, size);
+  __atomic_store_n(&e->seq, pos + 1 - (pos & INPUT_MASK), __ATOMIC_RELEASE);
+
+  if (ssm_input_notify) ssm_input_notify();
+  return true;
+}
+
+/** Return the entry at the head of the ring, or 0 if it is not ready */
+static inline input_entry_t *input_peek(void)
+{
+  uint32_t i = input_head & INPUT_MASK;
+  input_entry_t *e = &input_ring[i];
+  return __atomic_load_n(&e->seq, __ATOMIC_ACQUIRE) + i == input_head + 1
+    ? e : 0;
+}
+
+size_t ssm_input_drain(void)
+{
+  size_t delivered = 0;
+  input_entry_t *e;
+  while ((e = input_peek())) {
+    ssm_time_t then = e->then > ssm_now() ? e->then : ssm_now() + 1;
+    ssm_resolve(e->var);
+    if (e->var->later_time < then) {
+      /* Would replace an earlier pending update; run it first.  A lazy
+	 variable's is not in the event queue, so ask for its instant. */
+      if (e->var->later_time < ssm_next_event_time())
+	ssm_schedule_instant(e->var->later_time);
+      break;
+    }
+    e->deliver(e->var, then, &e->payload);
+    delivered++;
+
+    /* Hand the entry back to producers a lap later */
+    __atomic_store_n(&e->seq, input_head + SSM_INPUT_QUEUE_SIZE -
+		     (input_head & INPUT_MASK), __ATOMIC_RELEASE);
+    input_head++;
+  }
+  return delivered;
+}
+
+bool ssm_input_pending(void)
+{
+  return input_peek() != 0;
+}
+
+void ssm_reset_input(void)
+{
+  memset(input_ring, 0, sizeof(input_ring)); // Zeroed means ready; see above
+  input_head = 0;
+  __atomic_store_n(&input_tail, 0, __ATOMIC_RELAXED);
+}
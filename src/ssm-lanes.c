@@ -0,0 +1,41 @@
+#include "ssm.h"
+
+ssm_lanes_t ssm_active_lanes = SSM_ALL_LANES;
+
+void ssm_reset_lanes()
+{
+  ssm_active_lanes = SSM_ALL_LANES;
+}
+
+ssm_lanes_t ssm_lanes_where(const bool cond[SSM_LANES])
+{
+  ssm_lanes_t lanes = 0;
+  for (int i = 0 ; i < SSM_LANES ; i++)
+    lanes |= (ssm_lanes_t) cond[i] << i;
+  return lanes & ssm_active_lanes;
+}
+
+bool ssm_diverge(ssm_lanes_t taken)
+{
+  taken &= ssm_active_lanes;
+  if (taken == ssm_active_lanes) return true;
+  if (!taken) return false;
+
+  if (!ssm_split) SSM_THROW(SSM_DIVERGED_LANES);
+  if (ssm_split()) {
+    ssm_active_lanes = taken;
+    return true;
+  }
+  ssm_active_lanes &= ~taken;
+  return false;
+}
+
+SSM_DEFINE_SV_LANES(bool)
+SSM_DEFINE_SV_LANES(i8)
+SSM_DEFINE_SV_LANES(i16)
+SSM_DEFINE_SV_LANES(i32)
+SSM_DEFINE_SV_LANES(i64)
+SSM_DEFINE_SV_LANES(u8)
+SSM_DEFINE_SV_LANES(u16)
+SSM_DEFINE_SV_LANES(u32)
+SSM_DEFINE_SV_LANES(u64)
@@ -0,0 +1,11 @@
+#include "ssm.h"
+
+SSM_DEFINE_SV_LAZY(bool)
+SSM_DEFINE_SV_LAZY(i8)
+SSM_DEFINE_SV_LAZY(i16)
+SSM_DEFINE_SV_LAZY(i32)
+SSM_DEFINE_SV_LAZY(i64)
+SSM_DEFINE_SV_LAZY(u8)
+SSM_DEFINE_SV_LAZY(u16)
+SSM_DEFINE_SV_LAZY(u32)
+SSM_DEFINE_SV_LAZY(u64)
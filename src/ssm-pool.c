@@ -0,0 +1,174 @@
+#include "ssm.h"
+
+/** Position of an element that is not pending */
+#define NOT_PENDING UINT32_MAX
+
+/* The pending elements form a binary heap in `pending` ordered by
+   later_time, so the earliest sits at pending[0] and adding, moving, or
+   removing one takes time logarithmic in the number pending. */
+
+static inline ssm_time_t key(ssm_pool_t *p, size_t k)
+{
+  return p->later_time[p->pending[k]];
+}
+
+/** Put element `i` at position `k` of the heap */
+static inline void place(ssm_pool_t *p, size_t k, uint32_t i)
+{
+  SSM_SAVE(p->pending[k]);
+  SSM_SAVE(p->position[i]);
+  p->pending[k] = i;
+  p->position[i] = k;
+}
+
+/** Fill the hole at `k` with element `i`, moving it toward the root */
+static void sift_up(ssm_pool_t *p, size_t k, uint32_t i)
+{
+  ssm_time_t t = p->later_time[i];
+  while (k > 0) {
+    size_t parent = (k - 1) / 2;
+    if (key(p, parent) <= t) break;
+    place(p, k, p->pending[parent]);
+    k = parent;
+  }
+  place(p, k, i);
+}
+
+/** Fill the hole at `k` with element `i`, moving it toward the leaves */
+static void sift_down(ssm_pool_t *p, size_t k, uint32_t i)
+{
+  ssm_time_t t = p->later_time[i];
+  for (;;) {
+    size_t child = 2 * k + 1;
+    if (child >= p->pending_len) break;
+    if (child + 1 < p->pending_len && key(p, child + 1) < key(p, child))
+      child++;
+    if (key(p, child) >= t) break;
+    place(p, k, p->pending[child]);
+    k = child;
+  }
+  place(p, k, i);
+}
+
+void ssm_initialize_pool(ssm_pool_t *p, size_t len,
+			 bool (*update)(ssm_sv_t *), ssm_time_t *times,
+			 ssm_trigger_t **triggers, uint32_t *indices)
+{
+  assert(p);
+  assert(times && triggers && indices);
+  assert(len < NOT_PENDING);
+  ssm_initialize(&p->sv, update);
+  p->len = len;
+  p->later_time = times;
+  p->last_updated = times + len;
+  p->triggers = triggers;
+  p->pending = indices;
+  p->position = indices + len;
+  p->pending_len = 0;
+  for (size_t i = 0 ; i < len ; i++) {
+    p->later_time[i] = p->last_updated[i] = SSM_NEVER;
+    p->triggers[i] = 0;
+    p->position[i] = NOT_PENDING;
+  }
+}
+
+void ssm_pool_sensitize(ssm_pool_t *p, size_t i, ssm_trigger_t *trigger)
+{
+  assert(p);
+  assert(i < p->len);
+  assert(trigger);
+  ssm_trigger_t **head = &p->triggers[i];
+
+  SSM_SAVE(*trigger);
+  trigger->next = *head;
+  if (*head) {
+    SSM_SAVE((*head)->prev_ptr);
+    (*head)->prev_ptr = &trigger->next;
+  }
+  SSM_SAVE(*head);
+  *head = trigger;
+  trigger->prev_ptr = head;
+}
+
+size_t ssm_pool_due(ssm_pool_t *p)
+{
+  assert(p);
+  ssm_time_t now = ssm_now();
+  size_t due = 0;
+  while (p->pending_len > 0 && key(p, 0) == now) {
+    uint32_t i = p->pending[0];
+    SSM_SAVE(p->pending_len);
+    uint32_t last = p->pending[--p->pending_len];
+    if (p->pending_len > 0) sift_down(p, 0, last);
+    SSM_SAVE(p->pending[p->pending_len]); // The slot the heap gave up
+    p->pending[p->pending_len] = i;
+    due++;
+  }
+  return due;
+}
+
+void ssm_pool_commit(ssm_pool_t *p, size_t due)
+{
+  assert(p);
+  assert(p->pending_len + due <= p->len);
+  ssm_time_t now = ssm_now();
+  const uint32_t *idx = p->pending + p->pending_len;
+  for (size_t k = 0 ; k < due ; k++) {
+    uint32_t i = idx[k];
+    SSM_SAVE(p->later_time[i]);
+    SSM_SAVE(p->last_updated[i]);
+    SSM_SAVE(p->position[i]);
+    p->later_time[i] = SSM_NEVER;
+    p->last_updated[i] = now;
+    p->position[i] = NOT_PENDING;
+    for (ssm_trigger_t *trig = p->triggers[i] ; trig ; trig = trig->next)
+      ssm_activate(trig->act);
+  }
+  if (p->pending_len > 0) ssm_schedule(&p->sv, key(p, 0));
+}
+
+void ssm_pool_assign(ssm_pool_t *p, ssm_priority_t prio, size_t i)
+{
+  assert(p);
+  assert(i < p->len);
+  SSM_SAVE(p->last_updated[i]);
+  SSM_SAVE(p->sv.last_updated);
+  SSM_JOURNAL_MARK(&p->sv);
+  p->last_updated[i] = ssm_now();
+  p->sv.last_updated = ssm_now();
+  ssm_trigger(&p->sv, prio);
+  for (ssm_trigger_t *trig = p->triggers[i] ; trig ; trig = trig->next)
+    if (trig->act->priority > prio)
+      ssm_activate(trig->act);
+}
+
+void ssm_pool_later(ssm_pool_t *p, size_t i, ssm_time_t then)
+{
+  assert(p);
+  assert(i < p->len);
+  if (then <= ssm_now()) SSM_THROW(SSM_INVALID_TIME); // Before the heap moves
+  ssm_time_t old = p->later_time[i];
+  SSM_SAVE(p->later_time[i]);
+  p->later_time[i] = then;
+
+  if (old == SSM_NEVER) {
+    SSM_SAVE(p->pending_len);
+    sift_up(p, p->pending_len++, i);
+  } else if (then < old)
+    sift_up(p, p->position[i], i);
+  else
+    sift_down(p, p->position[i], i);
+
+  if (key(p, 0) != p->sv.later_time)
+    ssm_schedule(&p->sv, key(p, 0));
+}
+
+SSM_DEFINE_SV_POOL(bool)
+SSM_DEFINE_SV_POOL(i8)
+SSM_DEFINE_SV_POOL(i16)
+SSM_DEFINE_SV_POOL(i32)
+SSM_DEFINE_SV_POOL(i64)
+SSM_DEFINE_SV_POOL(u8)
+SSM_DEFINE_SV_POOL(u16)
+SSM_DEFINE_SV_POOL(u32)
+SSM_DEFINE_SV_POOL(u64)
@@ -0,0 +1,44 @@
+#include "ssm.h"
+
+/** Move the edges counted since the last sample into the value */
+static void sample(ssm_pulses_t *v)
+{
+  u32 count = __atomic_load_n(&v->count, __ATOMIC_RELAXED);
+  SSM_SAVE(v->value);
+  SSM_SAVE(v->delta);
+  SSM_SAVE(v->sampled);
+  v->delta = count - v->sampled;
+  v->value += v->delta;
+  v->sampled = count;
+}
+
+static bool ssm_update_pulses(ssm_sv_t *sv)
+{
+  sample(container_of(sv, ssm_pulses_t, sv));
+  return true;
+}
+
+void ssm_initialize_pulses(ssm_pulses_t *v)
+{
+  assert(v);
+  ssm_initialize(&v->sv, ssm_update_pulses);
+  v->value = 0;
+  v->delta = 0;
+  v->count = v->sampled = 0;
+}
+
+void ssm_assign_pulses(ssm_pulses_t *v, ssm_priority_t prio)
+{
+  assert(v);
+  SSM_SAVE(v->sv.last_updated);
+  SSM_JOURNAL_MARK(&v->sv);
+  sample(v);
+  v->sv.last_updated = ssm_now();
+  ssm_trigger(&v->sv, prio);
+}
+
+void ssm_later_pulses(ssm_pulses_t *v, ssm_time_t then)
+{
+  assert(v);
+  ssm_schedule(&v->sv, then);
+}
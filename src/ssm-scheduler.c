@@ -57,32 +57,293 @@ SSM_STATIC q_idx_t act_queue_len = 0;
  */
 SSM_STATIC ssm_time_t now = 0L;
 
+/** Time of an instant requested with ssm_schedule_instant(), or #SSM_NEVER
+ *
+ * Lets an instant occur when nothing in the event queue is due, e.g., at
+ * the pending time of a lazy variable, which stays out of the queue.
+ */
+SSM_STATIC ssm_time_t instant_time = SSM_NEVER;
+
+#ifdef SSM_OPTIMISTIC
+
+#ifndef SSM_UNDO_LOG_SIZE
+/** Number of entries in the undo log; override as necessary */
+#define SSM_UNDO_LOG_SIZE 8192
+#endif
+
+#ifndef SSM_UNDO_DATA_SIZE
+/** Bytes of saved state in the undo log; override as necessary */
+#define SSM_UNDO_DATA_SIZE 65536
+#endif
+
+bool ssm_optimistic = false;
+
+/** What an undo log entry records */
+enum undo_kind {
+  UNDO_WRITE,   /**< Memory about to be overwritten; restore it */
+  UNDO_ALLOC,   /**< Activation record allocated; free it */
+  UNDO_FREE,    /**< Activation record left; free it when committed */
+  UNDO_INSTANT  /**< Start of an instant */
+};
+
+/** An entry in the undo log */
+typedef struct {
+  enum undo_kind kind;
+  void *addr;        /**< Memory written, allocated, or freed */
+  size_t size;       /**< Number of bytes saved, allocated, or freed */
+  size_t offset;     /**< Position of saved bytes in undo_data */
+  ssm_time_t time;   /**< For UNDO_INSTANT, the time of the instant */
+  ssm_act_freef_t *free; /**< For UNDO_ALLOC and UNDO_FREE, the program's
+			      #SSM_ACT_FREE */
+} undo_entry_t;
+
+/**
+ * \brief Undo log, used to roll back speculatively executed instants.
+ *
+ * Entries are appended in the order state changes; the saved bytes of
+ * each UNDO_WRITE entry live in undo_data starting at its offset.
+ * ssm_rollback() pops entries from the end; ssm_fossil_collect()
+ * discards them from the front.
+ */
+SSM_STATIC undo_entry_t undo_log[SSM_UNDO_LOG_SIZE];
+SSM_STATIC size_t undo_log_len = 0;
+SSM_STATIC unsigned char undo_data[SSM_UNDO_DATA_SIZE];
+SSM_STATIC size_t undo_data_len = 0;
+
+SSM_STATIC_INLINE undo_entry_t *undo_push(enum undo_kind kind, void *addr,
+					   size_t size, ssm_time_t time)
+{
+  if (undo_log_len == SSM_UNDO_LOG_SIZE)
+    SSM_THROW(SSM_EXHAUSTED_UNDO_LOG);
+  undo_log[undo_log_len] = (undo_entry_t) {
+    .kind = kind,
+    .addr = addr,
+    .size = size,
+    .offset = undo_data_len,
+    .time = time,
+    .free = 0
+  };
+  return &undo_log[undo_log_len++];
+}
+
+void ssm_save(void *addr, size_t size)
+{
+  assert(addr);
+  if (undo_data_len + size > SSM_UNDO_DATA_SIZE)
+    SSM_THROW(SSM_EXHAUSTED_UNDO_LOG);
+  undo_push(UNDO_WRITE, addr, size, now);
+  memcpy(undo_data + undo_data_len, addr, size);
+  undo_data_len += size;
+}
+
+void ssm_save_alloc(void *ptr, size_t size, ssm_act_freef_t *freef)
+{
+  assert(ptr);
+  assert(freef);
+  undo_push(UNDO_ALLOC, ptr, size, now)->free = freef;
+}
+
+void ssm_defer_free(void *ptr, size_t size, ssm_act_freef_t *freef)
+{
+  assert(ptr);
+  assert(freef);
+  undo_push(UNDO_FREE, ptr, size, now)->free = freef;
+}
+
+/** Mark the start of the instant at the given time; called by ssm_tick() */
+SSM_STATIC_INLINE void undo_instant(ssm_time_t time)
+{
+  undo_push(UNDO_INSTANT, 0, 0, time);
+}
+
+void ssm_rollback(ssm_time_t time)
+{
+  /* Find the earliest instant no earlier than time; instants are
+     logged in increasing time order */
+  size_t start = undo_log_len;
+  for (size_t i = undo_log_len ; i-- > 0 ; )
+    if (undo_log[i].kind == UNDO_INSTANT) {
+      if (undo_log[i].time < time) break;
+      start = i;
+    }
+
+  /* Undo everything from the end of the log back to that instant */
+  while (undo_log_len > start) {
+    undo_entry_t *e = &undo_log[--undo_log_len];
+    switch (e->kind) {
+    case UNDO_WRITE:
+      memcpy(e->addr, undo_data + e->offset, e->size);
+      undo_data_len = e->offset;
+      break;
+    case UNDO_ALLOC:
+      e->free(e->addr, e->size);
+      break;
+    case UNDO_FREE:    // The record never left; nothing to do
+    case UNDO_INSTANT:
+      break;
+    }
+  }
+}
+
+ssm_time_t ssm_uncommitted_time()
+{
+  for (size_t i = 0 ; i < undo_log_len ; i++)
+    if (undo_log[i].kind == UNDO_INSTANT) return undo_log[i].time;
+  return SSM_NEVER;
+}
+
+void ssm_fossil_collect(ssm_time_t gvt)
+{
+  /* Everything before the first instant at or after gvt is committed */
+  size_t end = 0;
+  while (end < undo_log_len &&
+	 !(undo_log[end].kind == UNDO_INSTANT && undo_log[end].time >= gvt))
+    end++;
+
+  for (size_t i = 0 ; i < end ; i++)
+    if (undo_log[i].kind == UNDO_FREE)
+      undo_log[i].free(undo_log[i].addr, undo_log[i].size);
+
+  size_t data_end = end < undo_log_len ? undo_log[end].offset : undo_data_len;
+
+  /* Slide the uncommitted part of the log to the front */
+  undo_log_len -= end;
+  memmove(undo_log, undo_log + end, undo_log_len * sizeof(undo_entry_t));
+  for (size_t i = 0 ; i < undo_log_len ; i++)
+    undo_log[i].offset -= data_end;
+  undo_data_len -= data_end;
+  memmove(undo_data, undo_data + data_end, undo_data_len);
+}
+#endif
+
+#ifdef SSM_JOURNAL
+
+#ifndef SSM_JOURNAL_SIZE
+/** Most variables that may change in one instant; override as necessary */
+#define SSM_JOURNAL_SIZE 1024
+#endif
+
+/** Variables changed in the latest instant, in the order they changed */
+SSM_STATIC ssm_sv_t *journal[SSM_JOURNAL_SIZE];
+SSM_STATIC size_t journal_len = 0;
+
+void ssm_journal_mark(ssm_sv_t *var)
+{
+  assert(var);
+  if (journal_len == SSM_JOURNAL_SIZE)
+    SSM_THROW(SSM_EXHAUSTED_JOURNAL);
+  SSM_SAVE(journal_len);
+  journal[journal_len++] = var;
+}
+
+ssm_sv_t *const *ssm_journal(size_t *count)
+{
+  assert(count);
+  *count = journal_len;
+  return journal;
+}
+#endif
+
+#ifdef SSM_STEPV
+#ifndef SSM_STEPV_TABLE_SIZE
+/** Number of group step functions that may be registered */
+#define SSM_STEPV_TABLE_SIZE 16
+#endif
+
+#ifndef SSM_STEPV_SIZE
+/** Most activation records passed to a group step function at once */
+#define SSM_STEPV_SIZE 256
+#endif
+
+/** Step functions with a group step function, and those group functions */
+SSM_STATIC ssm_stepf_t *stepv_steps[SSM_STEPV_TABLE_SIZE];
+SSM_STATIC ssm_stepvf_t *stepv_functions[SSM_STEPV_TABLE_SIZE];
+SSM_STATIC unsigned stepv_count = 0;
+
+/** Records removed from the activation record queue to run as a group */
+SSM_STATIC ssm_act_t *stepv_group[SSM_STEPV_SIZE];
+
+void ssm_register_stepv(ssm_stepf_t *step, ssm_stepvf_t *stepv)
+{
+  assert(step);
+  assert(stepv);
+  for (unsigned i = 0 ; i < stepv_count ; i++)
+    if (stepv_steps[i] == step) {
+      stepv_functions[i] = stepv;
+      return;
+    }
+  if (stepv_count == SSM_STEPV_TABLE_SIZE)
+    SSM_THROW(SSM_EXHAUSTED_STEPV_TABLE);
+  stepv_steps[stepv_count] = step;
+  stepv_functions[stepv_count++] = stepv;
+}
+
+/** Return the group step function registered for a step function or 0 */
+SSM_STATIC_INLINE ssm_stepvf_t *find_stepv(ssm_stepf_t *step)
+{
+  for (unsigned i = 0 ; i < stepv_count ; i++)
+    if (stepv_steps[i] == step) return stepv_functions[i];
+  return 0;
+}
+#endif
+
 void ssm_reset()
 {
+#ifdef SSM_OPTIMISTIC
+  ssm_fossil_collect(SSM_NEVER);
+#endif
   now = 0L;
+  instant_time = SSM_NEVER;
   event_queue_len = 0;
   act_queue_len = 0;
+  ssm_top_parent.children = 0;
+#ifdef SSM_JOURNAL
+  journal_len = 0;
+#endif
+#ifdef SSM_STEPV
+  stepv_count = 0;
+#endif
 }
 
 bool ssm_event_on(ssm_sv_t *var)
 {
   assert(var);
+  if (var->later_time <= now) ssm_resolve(var);
   return var->last_updated == now;
 }
 
+void ssm_resolve(ssm_sv_t *var)
+{
+  assert(var);
+  if (var->later_time > now) return; // Nothing pending or not yet due
+  bool changed = (*var->update)(var);
+  SSM_SAVE(var->last_updated);
+  SSM_SAVE(var->later_time);
+  if (changed) {
+    if (var->later_time == now) SSM_JOURNAL_MARK(var);
+    var->last_updated = var->later_time;
+  }
+  var->later_time = SSM_NEVER;
+}
+
 void ssm_sensitize(ssm_sv_t *var, ssm_trigger_t *trigger)
 {
   assert(var);
   assert(trigger);
 
+  SSM_SAVE(*trigger);
+
   /* Point us to the first element */
   trigger->next = var->triggers;
 
-  if (var->triggers)
+  if (var->triggers) {
     /* Make first element point to us */
+    SSM_SAVE(var->triggers->prev_ptr);
     var->triggers->prev_ptr = &trigger->next;
+  }
 
   /* Insert us at the beginning */
+  SSM_SAVE(var->triggers);
   var->triggers = trigger;
 
   /* Our previous is the variable */
@@ -95,11 +356,14 @@ void ssm_desensitize(ssm_trigger_t *trigger)
   assert(trigger->prev_ptr);
 
   /* Tell predecessor to skip us */
+  SSM_SAVE(*trigger->prev_ptr);
   *trigger->prev_ptr = trigger->next;
 
-  if (trigger->next)
+  if (trigger->next) {
     /* Tell successor its predecessor is our predecessor */
+    SSM_SAVE(trigger->next->prev_ptr);
     trigger->next->prev_ptr = trigger->prev_ptr;
+  }
 } 
 
 void ssm_trigger(ssm_sv_t *var, ssm_priority_t priority)
@@ -124,9 +388,13 @@ SSM_STATIC_INLINE void act_queue_percolate_up(q_idx_t hole, ssm_act_t *act)
   assert(hole >= SSM_QUEUE_HEAD && hole <= act_queue_len);
   ssm_priority_t priority = act->priority;
   for ( ; hole > SSM_QUEUE_HEAD && priority < act_queue[hole >> 1]->priority ;
-	hole >>= 1 )
+	hole >>= 1 ) {
+    SSM_SAVE(act_queue[hole]);
     act_queue[hole] = act_queue[hole >> 1];
+  }
+  SSM_SAVE(act_queue[hole]);
   act_queue[hole] = act;
+  SSM_SAVE(act->scheduled);
   act->scheduled = true;
 }
 
@@ -155,17 +423,39 @@ SSM_STATIC_INLINE void act_queue_percolate_down(q_idx_t hole,
 
     if (priority < act_queue[child]->priority)
       break; // Earlier child is later than what we're inserting
+    SSM_SAVE(act_queue[hole]);
     act_queue[hole] = act_queue[child];
     hole = child;
   }
+  SSM_SAVE(act_queue[hole]);
   act_queue[hole] = act;
 }
 
+/** Remove and return the earliest record in the activation record queue
+ */
+SSM_STATIC_INLINE ssm_act_t *act_queue_pop()
+{
+  assert(act_queue_len > 0);
+  ssm_act_t *act = act_queue[SSM_QUEUE_HEAD];
+  SSM_SAVE(*act); // The step function may change pc, children
+  act->scheduled = false;
+
+  /* Remove the top activation record from the queue by inserting the
+     last element in the queue at the front and percolating it down */
+  SSM_SAVE(act_queue_len);
+  ssm_act_t *to_insert = act_queue[act_queue_len--];
+
+  if (act_queue_len)
+    act_queue_percolate_down(SSM_QUEUE_HEAD, to_insert);
+  return act;
+}
+
 void ssm_activate(ssm_act_t *act)
 {
   assert(act);
   if (act->scheduled) return; // Don't activate an already activated routine
 
+  SSM_SAVE(act_queue_len);
   q_idx_t hole = ++act_queue_len;
 
   if (act_queue_len > SSM_ACT_QUEUE_SIZE)
@@ -175,8 +465,18 @@ void ssm_activate(ssm_act_t *act)
 }
 
 ssm_time_t ssm_next_event_time() {
-  return event_queue_len ?
+  ssm_time_t next = event_queue_len ?
     event_queue[SSM_QUEUE_HEAD]->later_time : SSM_NEVER;
+  return instant_time < next ? instant_time : next;
+}
+
+void ssm_schedule_instant(ssm_time_t then)
+{
+  assert(then > now);
+  if (then < instant_time) {
+    SSM_SAVE(instant_time);
+    instant_time = then;
+  }
 }
 
 ssm_time_t ssm_now() { return now; }
@@ -200,7 +500,7 @@ q_idx_t find_queued_event(ssm_sv_t *var /**< must be non-NULL */)
   return 0;
 }
 
-void ssm_initialize(ssm_sv_t *var, void (*update)(ssm_sv_t *))
+void ssm_initialize(ssm_sv_t *var, bool (*update)(ssm_sv_t *))
 {
   assert(var);
   *var = (ssm_sv_t){
@@ -225,8 +525,11 @@ SSM_STATIC_INLINE void event_queue_percolate_up(q_idx_t hole,
   assert(hole >= SSM_QUEUE_HEAD && hole <= event_queue_len);  
   ssm_time_t later = var->later_time;
   for ( ; hole > SSM_QUEUE_HEAD &&
-	  later < event_queue[hole >> 1]->later_time ; hole >>= 1 )
+	  later < event_queue[hole >> 1]->later_time ; hole >>= 1 ) {
+    SSM_SAVE(event_queue[hole]);
     event_queue[hole] = event_queue[hole >> 1];
+  }
+  SSM_SAVE(event_queue[hole]);
   event_queue[hole] = var;
 }
 
@@ -255,9 +558,11 @@ SSM_STATIC_INLINE void event_queue_percolate_down(q_idx_t hole,
 
     if (later < event_queue[child]->later_time)
       break; // Earlier child is later than what we're inserting
+    SSM_SAVE(event_queue[hole]);
     event_queue[hole] = event_queue[child];
     hole = child;
   }
+  SSM_SAVE(event_queue[hole]);
   event_queue[hole] = event;
 }
 
@@ -269,10 +574,12 @@ void ssm_schedule(ssm_sv_t *var, ssm_time_t later)
 
   if (var->later_time == SSM_NEVER) {
     // Variable does not have a pending event: add it to the queue
+    SSM_SAVE(event_queue_len);
     q_idx_t hole = ++event_queue_len;
     if (event_queue_len > SSM_EVENT_QUEUE_SIZE)
       SSM_THROW(SSM_EXHAUSTED_EVENT_QUEUE);
 
+    SSM_SAVE(var->later_time);
     var->later_time = later;
     event_queue_percolate_up(hole, var);
 
@@ -282,6 +589,7 @@ void ssm_schedule(ssm_sv_t *var, ssm_time_t later)
 
     q_idx_t hole = find_queued_event(var);
 
+    SSM_SAVE(var->later_time);
     var->later_time = later;
     if (hole == SSM_QUEUE_HEAD || event_queue[hole >> 1]->later_time < later)
       event_queue_percolate_down(hole, var);
@@ -295,7 +603,9 @@ void ssm_unschedule(ssm_sv_t *var)
   assert(var);        // A real variable
   if (var->later_time != SSM_NEVER) {
     q_idx_t hole = find_queued_event(var);
+    SSM_SAVE(var->later_time);
     var->later_time = SSM_NEVER;
+    SSM_SAVE(event_queue_len);
     ssm_sv_t *moved_var = event_queue[event_queue_len--];
     if (hole < SSM_QUEUE_HEAD + event_queue_len)
       // Percolate only if removal led to a hole in the queue; no need to do
@@ -310,10 +620,24 @@ void ssm_unschedule(ssm_sv_t *var)
 
 void ssm_tick()
 {
-  // Advance time to the earliest event in the queue
-  if (event_queue_len > 0) {
-    assert(now < event_queue[SSM_QUEUE_HEAD]->later_time); // No time-traveling!
-    now = event_queue[SSM_QUEUE_HEAD]->later_time;
+  // Advance time to the earliest event in the queue or requested instant
+  ssm_time_t next = ssm_next_event_time();
+  if (next != SSM_NEVER) {
+    assert(now < next); // No time-traveling!
+#ifdef SSM_OPTIMISTIC
+    if (ssm_optimistic)
+      undo_instant(next);
+#endif
+    SSM_SAVE(now);
+    now = next;
+    if (instant_time == now) {
+      SSM_SAVE(instant_time);
+      instant_time = SSM_NEVER;
+    }
+#ifdef SSM_JOURNAL
+    SSM_SAVE(journal_len);
+    journal_len = 0; // Start the new instant's journal
+#endif
   }
     
   /* Update every variable in the event queue at the current time */
@@ -321,35 +645,57 @@ void ssm_tick()
 	 event_queue[SSM_QUEUE_HEAD]->later_time == now) {
     
     ssm_sv_t *sv = event_queue[SSM_QUEUE_HEAD];
-    (*sv->update)(sv);  // Update the scheduled variable
-    sv->last_updated = now;
+    SSM_SAVE(sv->later_time);
     sv->later_time = SSM_NEVER;
 
-    /* Schedule all sensitive triggers */
-    for (ssm_trigger_t *trigger = sv->triggers ; trigger ;
-	 trigger = trigger->next)
-      ssm_activate(trigger->act);
-
     /* Remove the top event from the queue by inserting the last
-       element in the queue at the front and percolating it toward the leaves */
+       element in the queue at the front and percolating it toward the leaves.
+       Done before the update so the update may schedule the variable again. */
+    SSM_SAVE(event_queue_len);
     ssm_sv_t *to_insert = event_queue[event_queue_len--]; // get last
 
     if (event_queue_len) // Was this the last?
       event_queue_percolate_down(SSM_QUEUE_HEAD, to_insert);
-  }
 
-  while (act_queue_len > 0) {
-    ssm_act_t *to_run = act_queue[SSM_QUEUE_HEAD];
-    to_run->scheduled = false;
+    if (!(*sv->update)(sv)) // Update the scheduled variable
+      continue;             // Unchanged and only fires on changes
+    SSM_SAVE(sv->last_updated);
+    SSM_JOURNAL_MARK(sv);
+    sv->last_updated = now;
 
-    /* Remove the top activation record from the queue by inserting the
-       last element in the queue at the front and percolating it down */
-    ssm_act_t *to_insert = act_queue[act_queue_len--];
+    /* Schedule all sensitive triggers */
+    for (ssm_trigger_t *trigger = sv->triggers ; trigger ;
+	 trigger = trigger->next)
+      ssm_activate(trigger->act);
+  }
 
-    if (act_queue_len)
-      act_queue_percolate_down(SSM_QUEUE_HEAD, to_insert);
+  while (act_queue_len > 0) {
+    ssm_act_t *to_run = act_queue_pop();
+#ifdef SSM_STEPV
+    ssm_stepvf_t *stepv = stepv_count ? find_stepv(to_run->step) : 0;
+
+    if (!stepv || act_queue_len == 0 ||
+	act_queue[SSM_QUEUE_HEAD]->step != to_run->step) {
+      to_run->step(to_run); // Execute the step function
+      continue;
+    }
 
+    /* Run the records at the head of the queue with the same step
+       function as a group */
+    size_t count = 0;
+    stepv_group[count++] = to_run;
+    while (count < SSM_STEPV_SIZE && act_queue_len > 0 &&
+	   act_queue[SSM_QUEUE_HEAD]->step == to_run->step) {
+      ssm_act_t *act = act_queue_pop();
+      act->scheduled = true; // Waking it before it has run does nothing
+      stepv_group[count++] = act;
+    }
+    stepv(stepv_group, count);
+    for (size_t i = 1 ; i < count ; i++)
+      stepv_group[i]->scheduled = false;
+#else
     to_run->step(to_run); // Execute the step function
+#endif
   }
 }
 
@@ -1,5 +1,6 @@
 #include "ssm.h"
 #include <stdio.h>
+#include <inttypes.h>
 
 #ifndef SSM_DEBUG
 #error "SSM_DEBUG undefined; it should be defined for the library"
@@ -398,8 +399,791 @@ void trigger_basic()
   assert(step1ran);  
 }
 
-void vacuous_update(ssm_sv_t *var)
+#ifdef SSM_OPTIMISTIC
+ssm_i32_t opt_in, opt_sum;
+ssm_trigger_t opt_trigger;
+ssm_act_t opt_act;
+
+/* Add the input to the sum, then schedule the input to increase */
+void opt_step(ssm_act_t *act)
+{
+  act->pc++;
+  ssm_assign_i32(&opt_sum, act->priority, opt_sum.value + opt_in.value);
+  ssm_later_i32(&opt_in, ssm_now() + 10, opt_in.value + 1);
+}
+
+void opt_run_until(ssm_time_t stop)
+{
+  while (ssm_next_event_time() <= stop) {
+    ssm_tick();
+    event_queue_consistency_check();
+    act_queue_consistency_check();
+    printf("%" PRIu64 ":%d ", ssm_now(), opt_sum.value);
+  }
+  printf("\n");
+}
+
+int opt_freed;
+
+void opt_free(void *ptr, size_t size)
+{
+  (void) ptr;
+  (void) size;
+  opt_freed++;
+}
+
+/** Run speculatively, roll back for a straggler, replay, and make sure
+ * state is restored exactly at each step
+ */
+void optimistic_rollback()
+{
+  ssm_reset();
+  ssm_initialize_i32(&opt_in);
+  opt_in.value = 0;
+  ssm_initialize_i32(&opt_sum);
+  opt_sum.value = 0;
+  opt_act = (ssm_act_t) { .step = opt_step, .caller = &ssm_top_parent,
+			  .priority = 1 };
+  opt_trigger.act = &opt_act;
+  ssm_sensitize(&opt_in.sv, &opt_trigger);
+
+  ssm_optimistic = true;
+  ssm_later_i32(&opt_in, 10, 1);
+
+  opt_run_until(30);
+  assert(ssm_now() == 30);
+  assert(opt_sum.value == 6);
+  assert(opt_act.pc == 3);
+
+  ssm_rollback(20); // Undo the instants at 20 and 30
+  event_queue_consistency_check();
+  assert(ssm_now() == 10);
+  assert(opt_sum.value == 1);
+  assert(opt_in.value == 1);
+  assert(opt_act.pc == 1);
+  assert(ssm_next_event_time() == 20);
+  assert(opt_in.later_value == 2);
+
+  ssm_later_i32(&opt_in, 15, 100); // A straggler replaces the event at 20
+  opt_run_until(25);
+  assert(opt_sum.value == 202);
+
+  ssm_fossil_collect(20); // Instant 10 and 15 may no longer be undone
+  ssm_rollback(0);
+  assert(ssm_now() == 15);
+  assert(opt_sum.value == 101);
+  assert(opt_act.pc == 2);
+  assert(ssm_next_event_time() == 25);
+
+  opt_run_until(35);
+  assert(opt_sum.value == 304);
+
+  // Records go back through the free function the program allocated with
+  static char records[2][16];
+  ssm_save_alloc(records[0], sizeof(records[0]), opt_free);
+  ssm_rollback(35); // Frees the record allocated in instant 35
+  assert(opt_freed == 1);
+  ssm_defer_free(records[1], sizeof(records[1]), opt_free);
+  assert(opt_freed == 1);
+
+  ssm_optimistic = false;
+  ssm_fossil_collect(SSM_NEVER);
+  assert(opt_freed == 2);
+  ssm_desensitize(&opt_trigger);
+  ssm_unschedule(&opt_in.sv);
+}
+
+uint64_t opt_performed;
+
+void opt_perform(void *data, uint64_t arg)
+{
+  opt_performed = opt_performed * 10 + arg;
+}
+
+/** Hold the actions of speculative instants until they are committed */
+void optimistic_actions()
+{
+  ssm_reset();
+  ssm_event_t e;
+  ssm_initialize_event(&e);
+  opt_performed = 0;
+  ssm_optimistic = true;
+  for (uint64_t t = 1 ; t <= 3 ; t++) {
+    ssm_later_event(&e, t * 10);
+    ssm_tick();
+    ssm_defer(opt_perform, 0, t);
+    assert(ssm_flush_actions(0) == 0);
+  }
+  assert(ssm_uncommitted_time() == 10);
+
+  ssm_fossil_collect(20); // Performs only the action of instant 10
+  assert(ssm_uncommitted_time() == 20);
+  assert(ssm_flush_actions(0) == 1 && opt_performed == 1);
+
+  ssm_rollback(30); // Drops the action of instant 30
+  ssm_later_event(&e, 40);
+  ssm_tick();
+  ssm_defer(opt_perform, 0, 4);
+  ssm_fossil_collect(SSM_NEVER);
+  assert(ssm_flush_actions(0) == 2 && opt_performed == 124);
+  assert(ssm_flush_actions(0) == 0);
+  ssm_optimistic = false;
+
+  ssm_defer(opt_perform, 0, 5); // Resetting forgets unperformed actions
+  ssm_reset_actions();
+  assert(ssm_flush_actions(0) == 0 && opt_performed == 124);
+}
+#endif
+
+/** Assign and schedule a variable with a value per ensemble lane */
+void lanes_basic()
+{
+  ssm_reset();
+  ssm_i32_lanes_t v;
+  i32 values[SSM_LANES];
+  bool cond[SSM_LANES];
+  ssm_initialize_i32_lanes(&v);
+
+  for (int i = 0 ; i < SSM_LANES ; i++) values[i] = i;
+  ssm_assign_i32_lanes(&v, 0, values);
+  for (int i = 0 ; i < SSM_LANES ; i++) values[i] = 10 * i;
+  ssm_later_i32_lanes(&v, 5, values);
+  assert(v.value[SSM_LANES - 1] == SSM_LANES - 1);
+
+  ssm_tick();
+  assert(ssm_now() == 5);
+  assert(ssm_event_on(&v.sv));
+  for (int i = 0 ; i < SSM_LANES ; i++) {
+    assert(v.value[i] == 10 * i);
+    cond[i] = v.value[i] >= 0;
+  }
+
+  assert(ssm_active_lanes == SSM_ALL_LANES);
+  assert(ssm_lanes_where(cond) == SSM_ALL_LANES);
+  assert(ssm_diverge(ssm_lanes_where(cond))); // All lanes agree
+  assert(!ssm_diverge(0));
+  assert(ssm_active_lanes == SSM_ALL_LANES);
+}
+
+#ifdef SSM_STEPV
+void stepv_single(ssm_act_t *act) { printf("%c", (char) act->priority); }
+
+void stepv_group_print(ssm_act_t **acts, size_t count)
+{
+  printf("[");
+  for (size_t i = 0 ; i < count ; i++) {
+    assert(acts[i]->scheduled == (i > 0));
+    stepv_single(acts[i]);
+    ssm_activate(acts[count - 1]); // Still to run, so not run twice
+  }
+  printf("]");
+}
+
+/** Run consecutive activation records with the same step function as a
+ * group; others, and groups of one, run alone */
+void stepv_basic()
+{
+  const char *input = "EBDAFGC";
+  const char *grouped = "ABCEG";
+  ssm_reset();
+  ssm_register_stepv(stepv_single, stepv_group_print);
+  ssm_act_t *act = acts;
+  for (const char *cp = input ; *cp ; ++cp, ++act) {
+    act->step = strchr(grouped, *cp) ? stepv_single : check_priority_step;
+    act->scheduled = false;
+    act->priority = *cp;
+    ssm_activate(act);
+  }
+  next_expected = "DF";
+  ssm_tick();
+  assert(*next_expected == 0);
+  assert(act_queue_len == 0);
+  printf("\n");
+}
+#endif
+
+/** Post updates to the input ring, drain them, and run them */
+void input_basic()
+{
+  ssm_reset();
+  ssm_i32_t v;
+  ssm_event_t e;
+  ssm_initialize_i32(&v);
+  ssm_initialize_event(&e);
+  i32 x;
+
+  assert(!ssm_input_pending());
+  x = 1; assert(ssm_input_post(&v.sv, ssm_deliver_i32, 10, &x, sizeof(x)));
+  assert(ssm_input_post(&e.sv, ssm_deliver_event, 5, 0, 0));
+  x = 2; assert(ssm_input_post(&v.sv, ssm_deliver_i32, 20, &x, sizeof(x)));
+  assert(ssm_input_pending());
+
+  // The second update to v waits until its first has happened
+  assert(ssm_input_drain() == 2);
+  assert(ssm_input_pending());
+  ssm_tick();
+  assert(ssm_now() == 5 && ssm_event_on(&e.sv));
+  assert(ssm_input_drain() == 0);
+  ssm_tick();
+  assert(ssm_now() == 10 && v.value == 1);
+  assert(ssm_input_drain() == 1);
+  assert(!ssm_input_pending());
+  ssm_tick();
+  assert(ssm_now() == 20 && v.value == 2);
+
+  // Late updates happen in the next instant
+  x = 3; assert(ssm_input_post(&v.sv, ssm_deliver_i32, 15, &x, sizeof(x)));
+  assert(ssm_input_drain() == 1);
+  assert(ssm_next_event_time() == 21);
+  ssm_tick();
+  assert(v.value == 3);
+
+  // A full ring refuses updates; updates for the same time coalesce
+  for (x = 0 ; x < SSM_INPUT_QUEUE_SIZE ; x++)
+    assert(ssm_input_post(&v.sv, ssm_deliver_i32, 30, &x, sizeof(x)));
+  assert(!ssm_input_post(&v.sv, ssm_deliver_i32, 30, &x, sizeof(x)));
+  assert(ssm_input_drain() == SSM_INPUT_QUEUE_SIZE);
+  assert(ssm_input_post(&v.sv, ssm_deliver_i32, 30, &x, sizeof(x)));
+  assert(ssm_input_drain() == 1);
+  ssm_tick();
+  assert(ssm_now() == 30 && v.value == SSM_INPUT_QUEUE_SIZE);
+  assert(ssm_next_event_time() == SSM_NEVER);
+
+  // Resetting discards what the last run left in the ring
+  assert(ssm_input_post(&v.sv, ssm_deliver_i32, 40, &x, sizeof(x)));
+  ssm_reset_input();
+  assert(!ssm_input_pending() && ssm_input_drain() == 0);
+}
+
+/** Pulse counters commit the edges counted so far only when sampled */
+void pulses_basic()
+{
+  ssm_reset();
+  ssm_pulses_t p;
+  ssm_initialize_pulses(&p);
+
+  ssm_pulses_add(&p, 3);
+  ssm_later_pulses(&p, 10);
+  ssm_pulses_add(&p, 4);
+  assert(p.value == 0 && p.delta == 0);
+  ssm_tick();
+  assert(ssm_now() == 10 && p.value == 7 && p.delta == 7);
+  assert(ssm_next_event_time() == SSM_NEVER);
+
+  // The running count wraps without disturbing the deltas
+  p.count = p.sampled = UINT32_MAX - 1;
+  ssm_pulses_add(&p, 5);
+  ssm_later_pulses(&p, 20);
+  ssm_tick();
+  assert(p.value == 12 && p.delta == 5);
+
+  ssm_assign_pulses(&p, 0);
+  assert(p.delta == 0 && p.sv.last_updated == 20);
+}
+
+/** Aggregates commit their buffered copy by swapping pointers */
+void blob_basic()
+{
+  ssm_reset();
+  typedef struct { int x[100]; } frame_t;
+  frame_t a = { { 1 } }, b = { { 0 } };
+  ssm_blob_t v;
+  ssm_initialize_blob(&v, &a, &b, sizeof(frame_t));
+  assert(((frame_t *) v.value)->x[0] == 1);
+
+  frame_t *f = ssm_blob_buffer(&v);
+  assert(f == &b);
+  f->x[0] = 2;
+  ssm_later_blob(&v, 10);
+  assert(((frame_t *) v.value)->x[0] == 1);
+  ssm_tick();
+  assert(ssm_now() == 10 && v.value == &b && v.later_value == &a);
+  assert(((frame_t *) v.value)->x[0] == 2);
+
+  // Assigning cancels a pending update, which shares the buffer
+  f = ssm_blob_buffer(&v);
+  f->x[0] = 3;
+  ssm_later_blob(&v, 20);
+  ssm_assign_blob(&v, 0);
+  assert(v.value == &a && ((frame_t *) v.value)->x[0] == 3);
+  assert(ssm_next_event_time() == SSM_NEVER);
+}
+
+/** Arrays commit only their dirty elements and trigger only touched ranges */
+void array_basic()
+{
+  ssm_reset();
+  i32 value[200] = { 0 }, later[200];
+  uint64_t dirty[SSM_ARRAY_DIRTY_WORDS(200)];
+  ssm_array_t a;
+  ssm_array_range_t low, high;
+  ssm_initialize_array(&a, value, later, dirty, 200, sizeof(i32));
+  ssm_array_watch(&a, &low, 0, 10);
+  ssm_array_watch(&a, &high, 100, 200);
+  i32 x;
+
+  x = 5; ssm_later_array(&a, 10, 5, &x);
+  x = 150; ssm_later_array(&a, 10, 150, &x);
+  assert(ssm_next_event_time() == 10 && value[5] == 0);
+  ssm_tick();
+  assert(value[5] == 5 && value[150] == 150 && value[6] == 0);
+  assert(ssm_event_on(&a.sv) && ssm_event_on(&low.sv) &&
+	 ssm_event_on(&high.sv));
+  assert(a.dirty_lo == a.dirty_hi && !dirty[0] && !dirty[2]);
+
+  // Elements outside both ranges leave them alone
+  x = 50; ssm_later_array(&a, 20, 50, &x);
+  ssm_tick();
+  assert(ssm_now() == 20 && value[50] == 50);
+  assert(ssm_event_on(&a.sv) && !ssm_event_on(&low.sv) &&
+	 !ssm_event_on(&high.sv));
+
+  x = 9; ssm_assign_array(&a, 0, 9, &x);
+  assert(value[9] == 9 && ssm_event_on(&low.sv) && !ssm_event_on(&high.sv));
+
+  ssm_array_unwatch(&a, &low);
+  x = 1; ssm_later_array(&a, 30, 1, &x);
+  ssm_tick();
+  assert(value[1] == 1 && !ssm_event_on(&low.sv));
+}
+
+void pool_step(ssm_act_t *act)
+{
+}
+
+void pool_basic()
+{
+  ssm_reset();
+  static SSM_POOL_STORAGE(i32, 100) storage;
+  ssm_i32_pool_t p;
+  SSM_INITIALIZE_POOL(i32, &p, &storage);
+  assert(p.pool.len == 100);
+  ssm_act_t *act = ssm_enter(sizeof(ssm_act_t), pool_step, &ssm_top_parent,
+			     SSM_ROOT_PRIORITY + 1, SSM_ROOT_DEPTH);
+  ssm_trigger_t trigger = { .act = act };
+  ssm_pool_sensitize(&p.pool, 7, &trigger);
+
+  // Elements pending at different times commit at their own times
+  ssm_later_i32_pool(&p, 20, 3, 30);
+  ssm_later_i32_pool(&p, 10, 7, 70);
+  assert(ssm_next_event_time() == 10);
+  ssm_tick();
+  assert(p.value[7] == 70 && p.value[3] == 0);
+  assert(ssm_pool_event_on(&p.pool, 7) && !ssm_pool_event_on(&p.pool, 3));
+  assert(ssm_event_on(&p.pool.sv) && p.pool.pending_len == 1);
+  assert(ssm_next_event_time() == 20);
+
+  // Moving the earliest element later reschedules the pool
+  ssm_later_i32_pool(&p, 30, 3, 31);
+  assert(ssm_next_event_time() == 30);
+  ssm_tick();
+  assert(ssm_now() == 30 && p.value[3] == 31);
+
+  // Committing most of the pool takes the blend path
+  for (size_t i = 0 ; i < 100 ; i += 2)
+    ssm_later_i32_pool(&p, 40, i, i);
+  ssm_later_i32_pool(&p, 50, 1, 1);
+  ssm_tick();
+  for (size_t i = 0 ; i < 100 ; i += 2)
+    assert(p.value[i] == (i32) i && ssm_pool_event_on(&p.pool, i));
+  assert(p.value[1] == 0 && p.value[7] == 70 && p.pool.pending_len == 1);
+  ssm_tick();
+  assert(ssm_now() == 50 && p.value[1] == 1);
+
+  ssm_assign_i32_pool(&p, SSM_ROOT_PRIORITY, 7, 8);
+  assert(p.value[7] == 8 && ssm_pool_event_on(&p.pool, 7) && act->scheduled);
+  ssm_tick();
+
+  // Elements pending at many times, some moved, commit in time order
+  for (i32 i = 10 ; i < 30 ; i++)
+    ssm_later_i32_pool(&p, 100 + (i * 7) % 20, i, -i);
+  ssm_later_i32_pool(&p, 99, 25, -25);   // Earlier than every other
+  ssm_later_i32_pool(&p, 200, 10, -10);  // Later than every other
+  assert(p.pool.pending_len == 20);
+  ssm_tick();
+  assert(ssm_now() == 99 && p.value[25] == -25 && p.value[10] == 10);
+  for (ssm_time_t t = 100 ; t < 120 ; t++) {
+    i32 i = 10;
+    while ((i * 7) % 20 != (i32) (t - 100)) i++;
+    if (i == 10 || i == 25) continue; // Moved
+    assert(ssm_next_event_time() == t);
+    ssm_tick();
+    assert(p.value[i] == -i && ssm_pool_event_on(&p.pool, i));
+  }
+  ssm_tick();
+  assert(ssm_now() == 200 && p.value[10] == -10 && !p.pool.pending_len);
+  assert(ssm_next_event_time() == SSM_NEVER);
+  ssm_desensitize(&trigger);
+  ssm_leave(act, sizeof(ssm_act_t));
+}
+
+void bits_basic()
+{
+  ssm_reset();
+  uint64_t value[SSM_BITS_WORDS(100)] = { 0, 0xf0 };
+  uint64_t later[SSM_BITS_WORDS(100)], pending[SSM_BITS_WORDS(100)];
+  ssm_bits_t b;
+  ssm_bits_watch_t low, bit70;
+  ssm_initialize_bits(&b, value, later, pending, 100);
+  ssm_bits_watch(&b, &low, 0, 0xff);
+  ssm_bits_watch(&b, &bit70, 1, (uint64_t) 1 << 6);
+  assert(ssm_bits_get(&b, 68) && !ssm_bits_get(&b, 64));
+
+  ssm_later_bit(&b, 10, 3, true);
+  ssm_later_bits(&b, 10, 1, 0x3c, 0x0c); // Bits 66 and 67 on, 68 and 69 off
+  assert(ssm_next_event_time() == 10 && !ssm_bits_get(&b, 3));
+  ssm_tick();
+  assert(value[0] == 0x8 && value[1] == 0xcc);
+  assert(ssm_event_on(&b.sv) && ssm_event_on(&low.sv) &&
+	 !ssm_event_on(&bit70.sv));
+  assert(b.dirty_lo == b.dirty_hi && !pending[0] && !pending[1]);
+
+  // Writing a bit to the value it has still counts as a write
+  ssm_later_bit(&b, 20, 70, false);
+  ssm_tick();
+  assert(ssm_now() == 20 && value[1] == 0x8c);
+  assert(ssm_event_on(&bit70.sv) && !ssm_event_on(&low.sv));
+
+  ssm_assign_bits(&b, 0, 0, 0x3, 0x1);
+  assert(value[0] == 0x9 && ssm_event_on(&low.sv));
+
+  ssm_bits_unwatch(&b, &low);
+  ssm_later_bit(&b, 30, 0, false);
+  ssm_tick();
+  assert(value[0] == 0x8 && !ssm_event_on(&low.sv));
+}
+
+/** Built-in scalars of every size commit their buffered values when due */
+void update_builtin()
+{
+  ssm_reset();
+  ssm_event_t e;
+  ssm_bool_t b;
+  ssm_u16_t h;
+  ssm_i32_t i;
+  ssm_u64_t u;
+  ssm_initialize_event(&e);
+  ssm_initialize_bool(&b);
+  ssm_initialize_u16(&h);
+  ssm_initialize_i32(&i);
+  ssm_initialize_u64(&u);
+
+  b.value = false;
+  h.value = 1;
+  i.value = 2;
+  u.value = 3;
+  ssm_later_event(&e, 10);
+  ssm_later_bool(&b, 10, true);
+  ssm_later_u16(&h, 10, 0xffff);
+  ssm_later_i32(&i, 10, -5);
+  ssm_later_u64(&u, 10, UINT64_MAX);
+  ssm_tick();
+  assert(ssm_event_on(&e.sv) && b.value && h.value == 0xffff &&
+	 i.value == -5 && u.value == UINT64_MAX);
+}
+
+void delay_basic()
+{
+  ssm_reset();
+  i32 value = 0, values[4];
+  ssm_time_t times[4];
+  ssm_delay_t d;
+  ssm_initialize_delay(&d, &value, times, values, sizeof(i32), 4);
+  i32 x;
+
+  // Every pending value commits in time order
+  x = 20; ssm_later_delay(&d, 20, &x);
+  x = 30; ssm_later_delay(&d, 30, &x);
+  x = 10; ssm_later_delay(&d, 10, &x);
+  assert(d.count == 3 && ssm_next_event_time() == 10);
+  x = 21; ssm_later_delay(&d, 20, &x); // Replaces the value at 20
+  assert(d.count == 3);
+  ssm_tick();
+  assert(ssm_now() == 10 && value == 10 && ssm_event_on(&d.sv));
+  assert(ssm_next_event_time() == 20);
+
+  // Inserting in the middle moves later values around the end of the slots
+  x = 40; ssm_later_delay(&d, 40, &x);
+  x = 25; ssm_later_delay(&d, 25, &x);
+  assert(d.count == 4 && d.head == 1 && times[0] == 40);
+  ssm_tick();
+  assert(ssm_now() == 20 && value == 21);
+  ssm_tick();
+  assert(ssm_now() == 25 && value == 25);
+
+  x = 5; ssm_assign_delay(&d, 0, &x);
+  assert(value == 5 && d.count == 2);
+  ssm_tick();
+  assert(ssm_now() == 30 && value == 30);
+  ssm_tick();
+  assert(ssm_now() == 40 && value == 40 && d.count == 0);
+  assert(ssm_next_event_time() == SSM_NEVER);
+}
+
+ssm_stepf_t vacuous_step;
+
+/** A variable that fires only on changes ignores writes of the same value */
+void changes_only()
+{
+  ssm_reset();
+  ssm_i32_t a;
+  ssm_bool_t b;
+  ssm_event_t e;
+  ssm_initialize_i32(&a);
+  ssm_initialize_bool(&b);
+  ssm_initialize_event(&e);
+  a.value = 1;
+  b.value = false;
+  assert(!a.changes_only);
+  ssm_changes_only(&a);
+  ssm_changes_only(&b);
+  assert(a.changes_only && b.changes_only);
+
+  ssm_act_t *act = ssm_enter(sizeof(ssm_act_t), vacuous_step,
+			     &ssm_top_parent, SSM_ROOT_PRIORITY + 1,
+			     SSM_ROOT_DEPTH);
+  ssm_trigger_t trigger = { .act = act };
+  ssm_sensitize(&a.sv, &trigger);
+
+  ssm_later_i32(&a, 10, 1);
+  ssm_later_bool(&b, 10, true);
+  ssm_tick();
+  assert(ssm_now() == 10 && a.value == 1 && !ssm_event_on(&a.sv));
+  assert(b.value && ssm_event_on(&b.sv));
+
+  ssm_later_i32(&a, 20, 2);
+  ssm_tick();
+  assert(a.value == 2 && ssm_event_on(&a.sv));
+
+  ssm_later_event(&e, 30);
+  ssm_tick();
+  ssm_assign_i32(&a, SSM_ROOT_PRIORITY, 2);
+  assert(!ssm_event_on(&a.sv) && !act->scheduled);
+  ssm_assign_i32(&a, SSM_ROOT_PRIORITY, 3);
+  assert(a.value == 3 && ssm_event_on(&a.sv) && act->scheduled);
+  ssm_tick();
+  ssm_desensitize(&trigger);
+  ssm_leave(act, sizeof(ssm_act_t));
+}
+
+/** Lazy variables commit on read, outside the event queue */
+void lazy_basic()
+{
+  ssm_reset();
+  ssm_i32_lazy_t a;
+  ssm_event_t e;
+  ssm_initialize_i32_lazy(&a);
+  ssm_initialize_event(&e);
+  a.value = 1;
+
+  ssm_later_i32_lazy(&a, 10, 2);
+  assert(ssm_next_event_time() == SSM_NEVER);
+  assert(ssm_read_i32_lazy(&a) == 1);
+
+  // An instant at the pending time sees the event
+  ssm_later_event(&e, 10);
+  ssm_tick();
+  assert(a.value == 1); // Not committed until read
+  assert(ssm_event_on(&a.sv) && a.value == 2);
+
+  // A later read commits the value but sees no event
+  ssm_later_i32_lazy(&a, 15, 3);
+  ssm_later_i32_lazy(&a, 17, 4); // Replaces the value pending at 15
+  ssm_later_event(&e, 20);
+  ssm_tick();
+  assert(ssm_read_i32_lazy(&a) == 4 && !ssm_event_on(&a.sv));
+  assert(a.sv.last_updated == 17);
+
+  // A matured value commits before a new one replaces it
+  ssm_later_i32_lazy(&a, 25, 5);
+  ssm_later_event(&e, 30);
+  ssm_tick();
+  ssm_later_i32_lazy(&a, 40, 6);
+  assert(a.value == 5 && a.sv.later_time == 40);
+
+  ssm_assign_i32_lazy(&a, 0, 7);
+  assert(ssm_read_i32_lazy(&a) == 7 && ssm_event_on(&a.sv));
+
+  // A second input waits for an instant at the first one's time
+  ssm_later_event(&e, 45);
+  ssm_tick();
+  assert(ssm_read_i32_lazy(&a) == 6 && a.sv.later_time == SSM_NEVER);
+  i32 x = 8;
+  assert(ssm_input_post(&a.sv, ssm_deliver_i32_lazy, 50, &x, sizeof(x)));
+  x = 9;
+  assert(ssm_input_post(&a.sv, ssm_deliver_i32_lazy, 60, &x, sizeof(x)));
+  assert(ssm_input_drain() == 1 && ssm_input_pending());
+  assert(ssm_next_event_time() == 50);
+  ssm_tick();
+  assert(ssm_now() == 50 && ssm_input_drain() == 1);
+  assert(ssm_event_on(&a.sv) && ssm_read_i32_lazy(&a) == 8);
+  assert(ssm_next_event_time() == SSM_NEVER);
+  ssm_later_event(&e, 60);
+  ssm_tick();
+  assert(ssm_read_i32_lazy(&a) == 9 && ssm_event_on(&a.sv));
+}
+
+void channel_basic()
 {
+  ssm_reset();
+  i32 slots[3];
+  ssm_time_t times[3];
+  ssm_channel_t c;
+  ssm_initialize_channel(&c, slots, times, sizeof(i32), 3);
+  i32 x;
+
+  // Every item sent in an instant arrives, in order, in one later instant
+  x = 1; assert(ssm_channel_send(&c, 10, &x));
+  x = 2; assert(ssm_channel_send(&c, 10, &x));
+  assert(!ssm_channel_peek(&c) && c.pending == 2);
+  ssm_tick();
+  assert(ssm_now() == 10 && ssm_event_on(&c.sv) && c.count == 2);
+  assert(*(i32 *) ssm_channel_peek(&c) == 1);
+  ssm_channel_pop(&c);
+
+  // Items are written in place and wrap around the ring
+  *(i32 *) ssm_channel_reserve(&c) = 3;
+  ssm_later_channel(&c, 20);
+  *(i32 *) ssm_channel_reserve(&c) = 4;
+  ssm_later_channel(&c, 20);
+  assert(!ssm_channel_reserve(&c));
+  x = 5; assert(!ssm_channel_send(&c, 20, &x));
+  ssm_tick();
+  assert(ssm_now() == 20 && c.count == 3 && slots[0] == 4);
+  for (i32 i = 2 ; i <= 4 ; i++) {
+    assert(*(i32 *) ssm_channel_peek(&c) == i);
+    ssm_channel_pop(&c);
+  }
+  assert(!ssm_channel_peek(&c));
+
+  // Assigning makes pending items visible too
+  x = 6; ssm_channel_send(&c, 30, &x);
+  *(i32 *) ssm_channel_reserve(&c) = 7;
+  ssm_assign_channel(&c, 0);
+  assert(c.count == 2 && c.pending == 0 && ssm_event_on(&c.sv));
+  assert(ssm_next_event_time() == SSM_NEVER);
+
+  // Items sent for different times each arrive at their own
+  ssm_channel_pop(&c);
+  x = 8; assert(ssm_channel_send(&c, 25, &x));
+  x = 9; assert(ssm_channel_send(&c, 28, &x));
+  ssm_tick();
+  assert(ssm_now() == 25 && c.count == 2 && c.pending == 1);
+  assert(ssm_next_event_time() == 28);
+  ssm_tick();
+  assert(ssm_now() == 28 && c.count == 3 && c.pending == 0);
+  for (i32 i = 7 ; i <= 9 ; i++) {
+    assert(*(i32 *) ssm_channel_peek(&c) == i);
+    ssm_channel_pop(&c);
+  }
+  x = 6; assert(ssm_channel_send(&c, 30, &x));
+  *(i32 *) ssm_channel_reserve(&c) = 7;
+  ssm_assign_channel(&c, 0);
+
+#ifdef SSM_OPTIMISTIC
+  // Rolling back restores an item popped and written over
+  ssm_event_t e;
+  ssm_initialize_event(&e);
+  ssm_channel_pop(&c);
+  ssm_optimistic = true;
+  ssm_later_event(&e, 40);
+  ssm_tick();
+  ssm_channel_pop(&c);
+  for (x = 8 ; x <= 10 ; x++) assert(ssm_channel_send(&c, 50, &x));
+  ssm_rollback(40);
+  assert(c.count == 1 && c.pending == 0 && *(i32 *) ssm_channel_peek(&c) == 7);
+  ssm_optimistic = false;
+  ssm_fossil_collect(SSM_NEVER);
+#endif
+}
+
+void buffer_basic()
+{
+  ssm_reset();
+  uint64_t storage[4 * SSM_SLICE_STRIDE(16) / sizeof(uint64_t)];
+  ssm_slice_pool_t pool;
+  ssm_initialize_slice_pool(&pool, storage, sizeof(storage), 16);
+  assert(pool.available == 4);
+  ssm_buffer_t b;
+  ssm_initialize_buffer(&b);
+
+  // The variable takes the slice itself, not a copy
+  ssm_slice_t *s1 = ssm_slice_alloc(&pool);
+  assert(s1 == (ssm_slice_t *) storage && s1->refs == 1);
+  memcpy(s1->data, "hello", s1->len = 5);
+  ssm_later_buffer(&b, 10, s1);
+  ssm_tick();
+  assert(ssm_now() == 10 && ssm_event_on(&b.sv) && b.value == s1);
+  assert(s1->refs == 1 && pool.available == 3);
+
+  // Replacing a pending payload releases it
+  ssm_slice_t *s2 = ssm_slice_alloc(&pool), *s3 = ssm_slice_alloc(&pool);
+  ssm_later_buffer(&b, 20, s2);
+  ssm_later_buffer(&b, 20, s3);
+  assert(pool.available == 2);
+
+  // A reader that keeps the current payload holds it past its replacement
+  ssm_slice_retain(s1);
+  ssm_tick();
+  assert(ssm_now() == 20 && b.value == s3 && pool.available == 2);
+  assert(!memcmp(s1->data, "hello", s1->len));
+  ssm_slice_release(s1);
+  assert(pool.available == 3);
+
+  // A posted slice pointer is delivered the same way
+  ssm_slice_t *s4 = ssm_slice_alloc(&pool);
+  ssm_deliver_buffer(&b.sv, 30, &s4);
+  ssm_tick();
+  assert(ssm_now() == 30 && b.value == s4 && pool.available == 3);
+
+  // Exhausting the pool reports it rather than allocating
+  ssm_slice_t *s[3];
+  for (int i = 0 ; i < 3 ; i++) assert((s[i] = ssm_slice_alloc(&pool)));
+  assert(!ssm_slice_alloc(&pool));
+  ssm_assign_buffer(&b, 0, s[0]);
+  ssm_later_buffer(&b, 40, s[1]);
+  ssm_slice_release(s[2]);
+  assert(b.value == s[0] && pool.available == 2);
+  ssm_drop_buffer(&b);
+  assert(pool.available == 4 && ssm_next_event_time() == SSM_NEVER);
+}
+
+#ifdef SSM_JOURNAL
+/** Journal each variable that changes in an instant once */
+void journal_basic()
+{
+  ssm_reset();
+  ssm_i32_t a, b;
+  ssm_event_t e;
+  size_t count;
+  ssm_sv_t *const *changed;
+  ssm_initialize_i32(&a);
+  ssm_initialize_i32(&b);
+  ssm_initialize_event(&e);
+
+  ssm_later_i32(&b, 10, 1);
+  ssm_later_event(&e, 10);
+  ssm_later_i32(&a, 20, 1);
+  ssm_tick();
+  assert(ssm_now() == 10);
+  ssm_assign_i32(&b, 0, 2); // Already in the journal
+  ssm_assign_i32(&a, 0, 3);
+  changed = ssm_journal(&count);
+  assert(count == 3);
+  assert(changed[2] == &a.sv);
+  assert((changed[0] == &b.sv && changed[1] == &e.sv) ||
+	 (changed[0] == &e.sv && changed[1] == &b.sv));
+
+  ssm_tick(); // The pending update of a starts a new journal
+  assert(ssm_now() == 20);
+  changed = ssm_journal(&count);
+  assert(count == 1 && changed[0] == &a.sv);
+}
+#endif
+
+bool vacuous_update(ssm_sv_t *var)
+{
+  return true;
 }
 
 void vacuous_step(ssm_act_t *act)
@@ -514,6 +1298,37 @@ int main()
 
   trigger_basic();
 
+#ifdef SSM_OPTIMISTIC
+  optimistic_rollback();
+  optimistic_actions();
+#endif
+
+  lanes_basic();
+
+#ifdef SSM_STEPV
+  stepv_basic();
+#endif
+
+  input_basic();
+
+  pulses_basic();
+
+  blob_basic();
+
+  array_basic();
+  pool_basic();
+  bits_basic();
+  update_builtin();
+  delay_basic();
+  changes_only();
+  lazy_basic();
+  channel_basic();
+  buffer_basic();
+
+#ifdef SSM_JOURNAL
+  journal_basic();
+#endif
+
   printf("PASSED\n");
   return 0;
 }